@@ -0,0 +1,1600 @@
+#include "Benchmarks.h"
+#include "BlockCompression.h"
+#include "BoundingVolumeHierarchy.h"
+#include "CommandBuffer.h"
+#include "CookedMesh.h"
+#include "CookedTexture.h"
+#include "CubeGeometry.h"
+#include "FixedTimestep.h"
+#include "FrameConstants.h"
+#include "FrustumCulling.h"
+#include "GLExtensions.h"
+#include "GLStateCache.h"
+#include "InstanceBuffer.h"
+#include "JobSystem.h"
+#include "MappedFile.h"
+#include "MeshBuilder.h"
+#include "MeshImport.h"
+#include "MeshOptimizer.h"
+#include "MipChain.h"
+#include "OcclusionCuller.h"
+#include "RenderQueue.h"
+#include "ShaderProgram.h"
+#include "SimulationStep.h"
+#include "Transform.h"
+#include "TripleBuffer.h"
+#include "VertexQuantization.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <stb_image.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+	typedef std::chrono::steady_clock BenchmarkClock;
+
+	double millisecondsSince(const BenchmarkClock::time_point start) {
+		return std::chrono::duration<double, std::milli>(BenchmarkClock::now() - start).count();
+	}
+
+	std::string readTextFile(const char* path) {
+		std::ifstream file(path);
+		std::stringstream intermediary;
+		intermediary << file.rdbuf();
+		return intermediary.str();
+	}
+
+	std::string makeShaderVariant(const std::string& source, const long long salt) {
+		std::string::size_type versionEnd = source.find('\n');
+		std::ostringstream variant;
+		variant << source.substr(0, versionEnd + 1) << "const float variantSalt = " << salt << ".0;\n" << source.substr(versionEnd + 1);
+		return variant.str();
+	}
+
+	// The driver keeps its own shader cache, so every pass compiles sources no earlier run has seen.
+	bool runShaderCompileBenchmark() {
+		const int VARIANT_COUNT = 200;
+		const std::string vertexSource = readTextFile("source/shaders/VertexShader.txt");
+		const std::string fragmentSource = readTextFile("source/shaders/FragmentShader.txt");
+		const long long runSalt = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count() % 1000000000ll * 1000;
+
+		std::vector<std::string> vertexVariants;
+		std::vector<std::string> fragmentVariants;
+		for (int i = 0; i < 2 * VARIANT_COUNT; ++i) {
+			vertexVariants.push_back(makeShaderVariant(vertexSource, runSalt + i));
+			fragmentVariants.push_back(makeShaderVariant(fragmentSource, runSalt + i));
+		}
+
+		std::vector<unsigned> programs;
+		BenchmarkClock::time_point start = BenchmarkClock::now();
+		for (int i = 0; i < VARIANT_COUNT; ++i) {
+			programs.push_back(compileShaderProgram(vertexVariants[i].c_str(), fragmentVariants[i].c_str()));
+		}
+		const double sequentialMilliseconds = millisecondsSince(start);
+		for (unsigned program : programs) glDeleteProgram(program);
+		programs.clear();
+
+		ShaderBatch batch;
+		start = BenchmarkClock::now();
+		for (int i = VARIANT_COUNT; i < 2 * VARIANT_COUNT; ++i) batch.add(vertexVariants[i], fragmentVariants[i]);
+		batch.submit();
+		const double submitMilliseconds = millisecondsSince(start);
+		int pollCount = 0;
+		while (!batch.allReady()) ++pollCount;
+		for (std::size_t i = 0; i < batch.size(); ++i) programs.push_back(batch.program(static_cast<int>(i)));
+		const double batchMilliseconds = millisecondsSince(start);
+		for (unsigned program : programs) glDeleteProgram(program);
+
+		std::cout << "Compiled " << VARIANT_COUNT << " shader program variants" << '\n';
+		std::cout << "  sequential: " << sequentialMilliseconds << " ms" << '\n';
+		std::cout << "  batch:      " << batchMilliseconds << " ms (" << submitMilliseconds << " ms to submit, " << pollCount << " polls, parallel compile " << (GLAD_GL_KHR_parallel_shader_compile ? "on" : "unavailable") << ")" << '\n';
+		std::cout << "  speedup:    " << sequentialMilliseconds / batchMilliseconds << "x" << '\n';
+		return true;
+	}
+
+	int maxLevelDifference(const std::vector<MipLevel>& a, const std::vector<MipLevel>& b) {
+		int difference = 0;
+		for (std::size_t level = 0; level < a.size() && level < b.size(); ++level) {
+			for (std::size_t i = 0; i < a[level].pixels.size(); ++i) difference = std::max(difference, std::abs(a[level].pixels[i] - b[level].pixels[i]));
+		}
+		return difference;
+	}
+
+	double timeMipChain(void (*generate)(const unsigned char*, const int, const int, const int, const bool, const MipFilter, std::vector<MipLevel>&), const unsigned char* pixels, const int width, const int height, const int channels, const MipFilter filter, std::vector<MipLevel>& levels) {
+		const int ITERATIONS = 5;
+		const BenchmarkClock::time_point start = BenchmarkClock::now();
+		for (int i = 0; i < ITERATIONS; ++i) generate(pixels, width, height, channels, true, filter, levels);
+		return millisecondsSince(start) / ITERATIONS;
+	}
+
+	bool runMipmapBenchmark() {
+		int width, height, channels;
+		unsigned char* pixels = stbi_load("source/textures/sion.jpg", &width, &height, &channels, 0);
+		if (!pixels) {
+			std::cout << "There was an error loading source/textures/sion.jpg:" << '\n' << stbi_failure_reason() << '\n';
+			return false;
+		}
+
+		std::vector<MipLevel> scalarLevels;
+		std::vector<MipLevel> simdLevels;
+		const double scalarBoxMilliseconds = timeMipChain(generateMipChainScalar, pixels, width, height, channels, MipFilter::Box, scalarLevels);
+		const double simdBoxMilliseconds = timeMipChain(generateMipChain, pixels, width, height, channels, MipFilter::Box, simdLevels);
+		const int boxDifference = maxLevelDifference(scalarLevels, simdLevels);
+		const double scalarKaiserMilliseconds = timeMipChain(generateMipChainScalar, pixels, width, height, channels, MipFilter::Kaiser, scalarLevels);
+		const double simdKaiserMilliseconds = timeMipChain(generateMipChain, pixels, width, height, channels, MipFilter::Kaiser, simdLevels);
+		const int kaiserDifference = maxLevelDifference(scalarLevels, simdLevels);
+
+		const int ITERATIONS = 5;
+		unsigned format = (channels == 4) ? GL_RGBA : GL_RGB;
+		unsigned texture;
+		glGenTextures(1, &texture);
+		glBindTexture(GL_TEXTURE_2D, texture);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, pixels);
+		glFinish();
+		const BenchmarkClock::time_point start = BenchmarkClock::now();
+		for (int i = 0; i < ITERATIONS; ++i) {
+			glGenerateMipmap(GL_TEXTURE_2D);
+			glFinish();
+		}
+		const double glMilliseconds = millisecondsSince(start) / ITERATIONS;
+		glBindTexture(GL_TEXTURE_2D, 0);
+		glDeleteTextures(1, &texture);
+		stbi_image_free(pixels);
+
+		std::cout << "Mip chain for " << width << 'x' << height << 'x' << channels << " (" << simdLevels.size() << " levels, " << reinterpret_cast<const char*>(glGetString(GL_RENDERER)) << ")" << '\n';
+		std::cout << "  box scalar:      " << scalarBoxMilliseconds << " ms" << '\n';
+		std::cout << "  box SSE2:        " << simdBoxMilliseconds << " ms (max difference " << boxDifference << ")" << '\n';
+		std::cout << "  Kaiser scalar:   " << scalarKaiserMilliseconds << " ms" << '\n';
+		std::cout << "  Kaiser SSE2:     " << simdKaiserMilliseconds << " ms (max difference " << kaiserDifference << ")" << '\n';
+		std::cout << "  glGenerateMipmap: " << glMilliseconds << " ms" << '\n';
+
+		// Only the last column of a 3x3 image is lit, so the 1x1 level shows whether it was sampled.
+		const unsigned char oddPixels[] = { 0, 0, 255, 0, 0, 255, 0, 0, 255 };
+		std::vector<MipLevel> oddLevels;
+		generateMipChain(oddPixels, 3, 3, 1, false, MipFilter::Box, oddLevels);
+		std::cout << "  box, 3x3 with its last column lit: " << static_cast<int>(oddLevels[0].pixels[0]) << " (expected 85)" << '\n';
+		return oddLevels[0].pixels[0] == 85;
+	}
+
+	bool runTextureLoadBenchmark() {
+		const int ITERATIONS = 3;
+		const char* TEXTURES[] = { "source/textures/sion.jpg", "source/textures/warwick.jpg", "source/textures/container.jpg", "source/textures/awesomeface.png" };
+		const std::filesystem::path cookedDirectory = std::filesystem::temp_directory_path() / "texcook-benchmark";
+
+		unsigned texture;
+		glGenTextures(1, &texture);
+		glBindTexture(GL_TEXTURE_2D, texture);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		for (const char* sourcePath : TEXTURES) {
+			const std::string cookedPath = (cookedDirectory / std::filesystem::path(sourcePath).stem()).string() + ".ctex";
+			if (!cookTexture(sourcePath, cookedPath.c_str(), TextureCookOptions())) continue;
+
+			BenchmarkClock::time_point start = BenchmarkClock::now();
+			for (int i = 0; i < ITERATIONS; ++i) {
+				int width, height, channels;
+				unsigned char* pixels = stbi_load(sourcePath, &width, &height, &channels, 0);
+				unsigned format = (channels == 4) ? GL_RGBA : GL_RGB;
+				glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, pixels);
+				glGenerateMipmap(GL_TEXTURE_2D);
+				glFinish();
+				stbi_image_free(pixels);
+			}
+			const double stbiMilliseconds = millisecondsSince(start) / ITERATIONS;
+
+			start = BenchmarkClock::now();
+			for (int i = 0; i < ITERATIONS; ++i) {
+				MappedFile file;
+				file.open(cookedPath.c_str());
+				const CookedTextureHeader* header = validateCookedTexture(file);
+				if (header) uploadCookedTexture(*header, file.data());
+				glFinish();
+			}
+			const double cookedMilliseconds = millisecondsSince(start) / ITERATIONS;
+
+			std::cout << "  " << sourcePath << ": stbi_load + glGenerateMipmap " << stbiMilliseconds << " ms, mapped .ctex " << cookedMilliseconds << " ms (" << stbiMilliseconds / cookedMilliseconds << "x)" << '\n';
+		}
+		glBindTexture(GL_TEXTURE_2D, 0);
+		glDeleteTextures(1, &texture);
+
+		std::error_code error;
+		std::filesystem::remove_all(cookedDirectory, error);
+		return true;
+	}
+
+	bool runBlockCompressionBenchmark() {
+		const char* TEXTURES[] = { "source/textures/sion.jpg", "source/textures/warwick.jpg", "source/textures/awesomeface.png" };
+		const BlockFormat FORMATS[] = { BlockFormat::BC1, BlockFormat::BC3, BlockFormat::BC7 };
+		const BlockQuality QUALITIES[] = { BlockQuality::Fast, BlockQuality::Normal, BlockQuality::High };
+		const char* QUALITY_NAMES[] = { "fast", "normal", "high" };
+		const unsigned threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+		std::cout << "Block compression (" << threadCount << " threads)" << '\n';
+		for (const char* sourcePath : TEXTURES) {
+			int width, height, channels;
+			unsigned char* pixels = stbi_load(sourcePath, &width, &height, &channels, 0);
+			if (!pixels) continue;
+			const double megabytes = static_cast<double>(width) * height * channels / (1024.0 * 1024.0);
+			std::cout << "  " << sourcePath << " (" << width << 'x' << height << 'x' << channels << ", chosen " << blockFormatName(chooseBlockFormat(pixels, width, height, channels, false, false)) << ")" << '\n';
+
+			for (const BlockFormat format : FORMATS) {
+				for (int q = 0; q < 3; ++q) {
+					std::vector<unsigned char> blocks;
+					BenchmarkClock::time_point start = BenchmarkClock::now();
+					compressImage(pixels, width, height, channels, format, QUALITIES[q], 1, blocks);
+					const double singleMilliseconds = millisecondsSince(start);
+
+					start = BenchmarkClock::now();
+					compressImage(pixels, width, height, channels, format, QUALITIES[q], threadCount, blocks);
+					const double threadedMilliseconds = millisecondsSince(start);
+
+					std::vector<unsigned char> decoded;
+					decompressImage(blocks.data(), width, height, format, decoded);
+					std::cout << "    " << blockFormatName(format) << ' ' << QUALITY_NAMES[q] << ": " << megabytes * 1000.0 / singleMilliseconds << " MB/s on 1 thread, " << megabytes * 1000.0 / threadedMilliseconds << " MB/s on " << threadCount << ", PSNR " << blockCompressionPsnr(pixels, width, height, channels, format, decoded) << " dB" << '\n';
+				}
+			}
+			stbi_image_free(pixels);
+		}
+		return true;
+	}
+
+	// Largest entry of |R^T R - I| over the upper 3x3, with scale divided out.
+	float orthonormalityError(const glm::mat4& matrix, const glm::vec3& scale) {
+		const glm::mat3 rotation(glm::vec3(matrix[0]) / scale.x, glm::vec3(matrix[1]) / scale.y, glm::vec3(matrix[2]) / scale.z);
+		const glm::mat3 product = glm::transpose(rotation) * rotation;
+		float error = 0.0f;
+		for (int column = 0; column < 3; ++column) {
+			for (int row = 0; row < 3; ++row) error = std::max(error, std::abs(product[column][row] - (column == row ? 1.0f : 0.0f)));
+		}
+		return error;
+	}
+
+	bool runTransformBenchmark() {
+		const int FRAMES = 1000000;
+		const int TRANSFORM_COUNT = 100000;
+		const int ITERATIONS = 20;
+		const float ORTHONORMAL_TOLERANCE = 1e-5f;
+		const glm::vec3 axis(0.5f, 1.0f, 0.0f);
+
+		glm::mat4 accumulated(1.0f);
+		Transform transform;
+		for (int frame = 0; frame < FRAMES; ++frame) {
+			const float radians = glm::radians(static_cast<float>(frame % 11) - 5.0f);
+			accumulated = glm::rotate(accumulated, radians, axis);
+			transform.rotate(radians, axis);
+			transform.matrix();
+		}
+		const float accumulatedError = orthonormalityError(accumulated, glm::vec3(1.0f));
+		const float transformError = orthonormalityError(transform.matrix(), transform.scale());
+		std::cout << "Orthonormality after " << FRAMES << " frames of incremental rotation" << '\n';
+		std::cout << "  glm::rotate on the previous matrix: " << accumulatedError << '\n';
+		std::cout << "  Transform: " << transformError << (transformError <= ORTHONORMAL_TOLERANCE ? " (ok)" : " (FAILED)") << '\n';
+
+		std::vector<Transform> transforms(TRANSFORM_COUNT);
+		for (int i = 0; i < TRANSFORM_COUNT; ++i) {
+			transforms[i].setPosition(glm::vec3(static_cast<float>(i % 100), static_cast<float>(i / 100 % 100), static_cast<float>(i / 10000)));
+			transforms[i].setScale(glm::vec3(0.5f + static_cast<float>(i % 7) * 0.25f));
+		}
+		const glm::mat4 parent = glm::perspective(glm::radians(45.0f), 4.0f / 3.0f, 0.1f, 100.0f) * glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -3.0f));
+		std::vector<glm::mat4> scalarMatrices(TRANSFORM_COUNT), simdMatrices(TRANSFORM_COUNT);
+
+		double scalarMilliseconds = 0.0, simdMilliseconds = 0.0, cleanMilliseconds = 0.0;
+		for (int iteration = 0; iteration < ITERATIONS; ++iteration) {
+			for (Transform& each : transforms) each.rotate(0.01f, axis);
+			BenchmarkClock::time_point start = BenchmarkClock::now();
+			for (int i = 0; i < TRANSFORM_COUNT; ++i) scalarMatrices[i] = parent * transforms[i].matrix();
+			scalarMilliseconds += millisecondsSince(start);
+
+			for (Transform& each : transforms) each.rotate(0.01f, axis);
+			start = BenchmarkClock::now();
+			composeTransforms(transforms.data(), transforms.size(), parent, simdMatrices.data());
+			simdMilliseconds += millisecondsSince(start);
+
+			start = BenchmarkClock::now();
+			composeTransforms(transforms.data(), transforms.size(), parent, simdMatrices.data());
+			cleanMilliseconds += millisecondsSince(start);
+		}
+
+		float difference = 0.0f;
+		for (int i = 0; i < TRANSFORM_COUNT; ++i) {
+			const glm::mat4 expected = parent * transforms[i].matrix();
+			for (int column = 0; column < 4; ++column) {
+				for (int row = 0; row < 4; ++row) difference = std::max(difference, std::abs(expected[column][row] - simdMatrices[i][column][row]));
+			}
+		}
+		std::cout << "Composing " << TRANSFORM_COUNT << " transforms" << '\n';
+		std::cout << "  dirty, glm operator*: " << scalarMilliseconds / ITERATIONS << " ms" << '\n';
+		std::cout << "  dirty, glm_mat4_mul:  " << simdMilliseconds / ITERATIONS << " ms (max difference " << difference << ")" << '\n';
+		std::cout << "  clean, glm_mat4_mul:  " << cleanMilliseconds / ITERATIONS << " ms" << '\n';
+		return transformError <= ORTHONORMAL_TOLERANCE;
+	}
+
+	// Unindexed UV sphere with position and texture coordinate, as an exporter without welding would write it.
+	std::vector<float> makeSphereTriangles(const int rings, const int segments) {
+		std::vector<float> triangles;
+		auto addVertex = [&](const int ring, const int segment) {
+			const float u = static_cast<float>(segment) / segments;
+			const float v = static_cast<float>(ring) / rings;
+			const float theta = u * 6.2831853f;
+			const float phi = v * 3.1415927f;
+			const float position[5] = { std::sin(phi) * std::cos(theta), std::cos(phi), std::sin(phi) * std::sin(theta), u, v };
+			triangles.insert(triangles.end(), position, position + 5);
+		};
+		for (int ring = 0; ring < rings; ++ring) {
+			for (int segment = 0; segment < segments; ++segment) {
+				addVertex(ring, segment);
+				addVertex(ring + 1, segment);
+				addVertex(ring + 1, segment + 1);
+				addVertex(ring, segment);
+				addVertex(ring + 1, segment + 1);
+				addVertex(ring, segment + 1);
+			}
+		}
+		return triangles;
+	}
+
+	bool runMeshBuilderBenchmark() {
+		// Known sequences: a 3-entry cache keeps a repeated triangle, and once 3 has pushed 0 out of a
+		// 3-entry FIFO every vertex of the last triangle misses, while a 4-entry FIFO still holds them.
+		const std::uint32_t repeated[] = { 0, 1, 2, 0, 1, 2 };
+		const std::uint32_t rotating[] = { 0, 1, 2, 1, 2, 3, 0, 1, 2 };
+		const double repeatedFifo = simulateVertexCache(repeated, 6, 3, 3, CacheModel::Fifo).acmr;
+		const double repeatedLru = simulateVertexCache(repeated, 6, 3, 3, CacheModel::Lru).acmr;
+		const double rotatingFifo3 = simulateVertexCache(rotating, 9, 4, 3, CacheModel::Fifo).acmr;
+		const double rotatingFifo4 = simulateVertexCache(rotating, 9, 4, 4, CacheModel::Fifo).acmr;
+		const bool cacheModelsCorrect = repeatedFifo == 1.5 && repeatedLru == 1.5 && rotatingFifo3 == 7.0 / 3.0 && rotatingFifo4 == 4.0 / 3.0;
+		std::cout << "Vertex cache models on known sequences: FIFO " << repeatedFifo << " / LRU " << repeatedLru << " (expected 1.5), 3- and 4-entry FIFO "
+			<< rotatingFifo3 << " / " << rotatingFifo4 << " (expected 2.33333 / 1.33333)" << (cacheModelsCorrect ? " (ok)" : " (WRONG)") << '\n';
+
+		QuantizedMesh quantizedCube;
+		quantizeMesh(buildCubeMesh(), quantizedCube);
+		const int SIZES[] = { 16, 128, 512 };
+		for (const int size : SIZES) {
+			const std::vector<float> triangles = makeSphereTriangles(size, 2 * size);
+			MeshBuilder builder("sphere " + std::to_string(size) + 'x' + std::to_string(2 * size), { 3, 2 });
+			const BenchmarkClock::time_point start = BenchmarkClock::now();
+			builder.addTriangles(triangles.data(), triangles.size() / 5);
+			const double weldMilliseconds = millisecondsSince(start);
+			IndexedMesh mesh = builder.build();
+			std::cout << "  welded " << triangles.size() / 5 << " vertices in " << weldMilliseconds << " ms" << '\n';
+
+			// Exporters often emit triangles in an arbitrary order; shuffling shows what the optimizer recovers.
+			std::srand(1);
+			const std::size_t triangleCount = mesh.indices.size() / 3;
+			for (std::size_t i = triangleCount - 1; i > 0; --i) {
+				const std::size_t j = static_cast<std::size_t>(std::rand()) * (RAND_MAX + 1ull) + std::rand();
+				std::swap_ranges(mesh.indices.begin() + i * 3, mesh.indices.begin() + i * 3 + 3, mesh.indices.begin() + (j % (i + 1)) * 3);
+			}
+			mesh.name += " shuffled";
+			const BenchmarkClock::time_point optimizeStart = BenchmarkClock::now();
+			optimizeMesh(mesh);
+			std::cout << "  optimized in " << millisecondsSince(optimizeStart) << " ms (including reports)" << '\n';
+
+			QuantizedMesh quantized;
+			quantizeMesh(mesh, quantized);
+		}
+		return cacheModelsCorrect;
+	}
+
+	// A wavy grid written row by row until the file reaches targetBytes; every face uses v/vt pairs.
+	std::size_t writeSyntheticObj(const std::string& path, const std::size_t targetBytes) {
+		const int COLUMNS = 1024;
+		std::ofstream file(path, std::ios::binary);
+		std::string chunk;
+		char line[128];
+		std::size_t written = 0;
+		for (int row = 0; written < targetBytes; ++row) {
+			chunk.clear();
+			for (int column = 0; column < COLUMNS; ++column) {
+				const float x = column * 0.01f, z = row * 0.01f;
+				chunk.append(line, std::snprintf(line, sizeof(line), "v %.6f %.6f %.6f\n", x, 0.1f * std::sin(x * 7.0f) * std::cos(z * 5.0f), z));
+				chunk.append(line, std::snprintf(line, sizeof(line), "vt %.6f %.6f\n", column / static_cast<float>(COLUMNS - 1), (row % 1024) / 1023.0f));
+			}
+			if (row > 0) {
+				const long long previous = static_cast<long long>(row - 1) * COLUMNS + 1, current = static_cast<long long>(row) * COLUMNS + 1;
+				for (int column = 0; column + 1 < COLUMNS; ++column) {
+					const long long a = previous + column, b = current + column, c = current + column + 1, d = previous + column + 1;
+					chunk.append(line, std::snprintf(line, sizeof(line), "f %lld/%lld %lld/%lld %lld/%lld\n", a, a, b, b, c, c));
+					chunk.append(line, std::snprintf(line, sizeof(line), "f %lld/%lld %lld/%lld %lld/%lld\n", a, a, c, c, d, d));
+				}
+			}
+			file.write(chunk.data(), chunk.size());
+			written += chunk.size();
+		}
+		return written;
+	}
+
+	double megabytesPerSecond(const std::size_t bytes, const double milliseconds) {
+		return bytes / (1024.0 * 1024.0) / (milliseconds / 1000.0);
+	}
+
+	bool runObjLoadBenchmark() {
+		const std::size_t LARGE_FILE_BYTES = 1ull << 30;
+		const int PART_COUNT = 4;
+		const std::filesystem::path directory = std::filesystem::temp_directory_path() / "objload-benchmark";
+		std::filesystem::create_directories(directory);
+
+		const std::string largePath = (directory / "synthetic.obj").string();
+		std::cout << "Writing a synthetic " << (LARGE_FILE_BYTES >> 20) << " MB OBJ to " << largePath << '\n';
+		const std::size_t largeBytes = writeSyntheticObj(largePath, LARGE_FILE_BYTES);
+
+		// Number parsing alone: every token after a "v"/"vt" tag, hand-written parser vs strtof.
+		MappedFile mapped;
+		mapped.open(largePath.c_str());
+		mapped.prefetch();
+		const char* text = reinterpret_cast<const char*>(mapped.data());
+		const char* textEnd = text + mapped.size();
+		const std::size_t scanBytes = std::min<std::size_t>(mapped.size(), 256u << 20);
+		double checksum = 0.0;
+		BenchmarkClock::time_point start = BenchmarkClock::now();
+		for (const char* cursor = text; cursor < text + scanBytes;) {
+			const char* lineEnd = static_cast<const char*>(std::memchr(cursor, '\n', textEnd - cursor));
+			if (!lineEnd) lineEnd = textEnd;
+			if (*cursor == 'v') {
+				float value;
+				for (const char* next = parseFloat(cursor + 2, lineEnd, value); next; next = parseFloat(next, lineEnd, value)) checksum += value;
+			}
+			cursor = lineEnd + 1;
+		}
+		const double parserMilliseconds = millisecondsSince(start);
+		double strtofChecksum = 0.0;
+		std::string lineCopy;
+		start = BenchmarkClock::now();
+		for (const char* cursor = text; cursor < text + scanBytes;) {
+			const char* lineEnd = static_cast<const char*>(std::memchr(cursor, '\n', textEnd - cursor));
+			if (!lineEnd) lineEnd = textEnd;
+			if (*cursor == 'v') {
+				lineCopy.assign(cursor + 2, lineEnd);
+				char* next = &lineCopy[0];
+				for (char* parsed = next; ; next = parsed) {
+					const float value = std::strtof(next, &parsed);
+					if (parsed == next) break;
+					strtofChecksum += value;
+				}
+			}
+			cursor = lineEnd + 1;
+		}
+		const double strtofMilliseconds = millisecondsSince(start);
+		mapped.close();
+
+		std::ifstream stream(largePath);
+		std::string streamLine, tag;
+		std::size_t streamBytes = 0;
+		double streamChecksum = 0.0;
+		start = BenchmarkClock::now();
+		while (streamBytes < scanBytes && std::getline(stream, streamLine)) {
+			streamBytes += streamLine.size() + 1;
+			if (streamLine[0] != 'v') continue;
+			std::istringstream tokens(streamLine);
+			tokens >> tag;
+			float value;
+			while (tokens >> value) streamChecksum += value;
+		}
+		const double streamMilliseconds = millisecondsSince(start);
+
+		std::cout << "Parsing the numbers in the first " << (scanBytes >> 20) << " MB (checksums " << checksum << ", " << strtofChecksum << ", " << streamChecksum << ")" << '\n';
+		std::cout << "  hand-written parser: " << megabytesPerSecond(scanBytes, parserMilliseconds) << " MB/s" << '\n';
+		std::cout << "  std::strtof:         " << megabytesPerSecond(scanBytes, strtofMilliseconds) << " MB/s" << '\n';
+		std::cout << "  iostreams:           " << megabytesPerSecond(scanBytes, streamMilliseconds) << " MB/s" << '\n';
+
+		IndexedMesh mesh;
+		start = BenchmarkClock::now();
+		const bool imported = importMesh(largePath.c_str(), mesh, false);
+		const double importMilliseconds = millisecondsSince(start);
+		if (imported) std::cout << "Full import of " << (largeBytes >> 20) << " MB (map, parse, weld): " << megabytesPerSecond(largeBytes, importMilliseconds) << " MB/s, " << mesh.vertexCount() << " vertices, " << mesh.indices.size() / 3 << " triangles" << '\n';
+		mesh = IndexedMesh();
+		std::filesystem::remove(largePath);
+
+		std::vector<std::string> parts;
+		std::size_t partBytes = 0;
+		for (int i = 0; i < PART_COUNT; ++i) {
+			parts.push_back((directory / ("part" + std::to_string(i) + ".obj")).string());
+			partBytes += writeSyntheticObj(parts.back(), LARGE_FILE_BYTES / PART_COUNT);
+		}
+		JobSystem jobSystem;
+		jobSystem.create();
+		const unsigned threadCount = jobSystem.threadCount();
+		std::vector<IndexedMesh> meshes;
+		start = BenchmarkClock::now();
+		importMeshes(parts, meshes, NULL, false);
+		const double sequentialMilliseconds = millisecondsSince(start);
+		meshes.clear();
+		start = BenchmarkClock::now();
+		importMeshes(parts, meshes, &jobSystem, false);
+		const double parallelMilliseconds = millisecondsSince(start);
+		jobSystem.destroy();
+		std::cout << "Importing " << PART_COUNT << " files, " << (partBytes >> 20) << " MB total" << '\n';
+		std::cout << "  1 thread:  " << megabytesPerSecond(partBytes, sequentialMilliseconds) << " MB/s" << '\n';
+		std::cout << "  " << threadCount << " threads: " << megabytesPerSecond(partBytes, parallelMilliseconds) << " MB/s" << '\n';
+
+		std::error_code error;
+		std::filesystem::remove_all(directory, error);
+		return true;
+	}
+
+	// What --mesh did before cooking: parse, weld, optimize and quantize the source, then upload.
+	double timeSourceMeshLoad(const std::string& path) {
+		const BenchmarkClock::time_point start = BenchmarkClock::now();
+		IndexedMesh mesh;
+		importMesh(path.c_str(), mesh, false);
+		optimizeMesh(mesh, false);
+		QuantizedMesh quantized;
+		quantizeMesh(mesh, quantized, false);
+		MeshBuffers buffers = createMeshBuffers(quantized);
+		glFinish();
+		const double milliseconds = millisecondsSince(start);
+		destroyMeshBuffers(buffers);
+		return milliseconds;
+	}
+
+	double timeCookedMeshLoad(const std::string& path) {
+		const BenchmarkClock::time_point start = BenchmarkClock::now();
+		MeshBuffers buffers;
+		loadCookedMesh(path.c_str(), buffers);
+		glFinish();
+		const double milliseconds = millisecondsSince(start);
+		destroyMeshBuffers(buffers);
+		return milliseconds;
+	}
+
+	bool runMeshLoadBenchmark() {
+		const std::size_t SOURCE_BYTES = 64u << 20;
+		const int WARM_RUNS = 5;
+		const std::filesystem::path directory = std::filesystem::temp_directory_path() / "meshload-benchmark";
+		std::filesystem::create_directories(directory);
+
+		const std::string sourcePath = (directory / "synthetic.obj").string();
+		const std::string cookedPath = cookedMeshPath(sourcePath.c_str());
+		const std::size_t sourceBytes = writeSyntheticObj(sourcePath, SOURCE_BYTES);
+		BenchmarkClock::time_point start = BenchmarkClock::now();
+		if (!cookMesh(sourcePath.c_str(), cookedPath.c_str())) return false;
+		std::cout << "  cooking took " << millisecondsSince(start) << " ms" << '\n';
+		const std::size_t cookedBytes = static_cast<std::size_t>(std::filesystem::file_size(cookedPath));
+
+		// Cold loads start with the file out of the OS cache; warm loads repeat with it cached.
+		const bool evicted = evictFromFileCache(sourcePath.c_str()) && evictFromFileCache(cookedPath.c_str());
+		const double coldSource = timeSourceMeshLoad(sourcePath);
+		const double coldCooked = timeCookedMeshLoad(cookedPath);
+		double warmSource = timeSourceMeshLoad(sourcePath);
+		double warmCooked = 0.0;
+		for (int run = 0; run < WARM_RUNS; ++run) warmCooked += timeCookedMeshLoad(cookedPath);
+		warmCooked /= WARM_RUNS;
+
+		std::cout << "Loading " << (sourceBytes >> 20) << " MB of OBJ vs " << (cookedBytes >> 10) << " KB cooked (cold runs " << (evicted ? "evicted" : "could not evict") << " the file cache)" << '\n';
+		std::cout << "  source, cold: " << coldSource << " ms" << '\n';
+		std::cout << "  source, warm: " << warmSource << " ms" << '\n';
+		std::cout << "  cooked, cold: " << coldCooked << " ms (" << megabytesPerSecond(cookedBytes, coldCooked) << " MB/s)" << '\n';
+		std::cout << "  cooked, warm: " << warmCooked << " ms (" << megabytesPerSecond(cookedBytes, warmCooked) << " MB/s)" << '\n';
+
+		std::error_code error;
+		std::filesystem::remove_all(directory, error);
+		return true;
+	}
+
+	double nanosecondsPerObject(const double milliseconds, const std::size_t objectCount) {
+		return milliseconds * 1.0e6 / objectCount;
+	}
+
+	bool runCullingBenchmark() {
+		const std::size_t OBJECT_COUNT = 1000000;
+		const int ITERATIONS = 20;
+		const float WORLD_EXTENT = 200.0f;
+
+		// Objects fill a cube around the camera, so only a few percent land in the frustum.
+		ObjectBounds bounds;
+		bounds.resize(OBJECT_COUNT);
+		std::srand(1);
+		for (std::size_t i = 0; i < OBJECT_COUNT; ++i) {
+			const glm::vec3 center = (glm::vec3(std::rand(), std::rand(), std::rand()) / static_cast<float>(RAND_MAX) * 2.0f - 1.0f) * WORLD_EXTENT;
+			bounds.set(i, center, glm::vec3(0.5f + static_cast<float>(i % 4) * 0.5f));
+		}
+		const glm::mat4 projection = glm::perspective(glm::radians(45.0f), 4.0f / 3.0f, 0.1f, 150.0f);
+
+		std::vector<std::uint32_t> scalarVisible(OBJECT_COUNT), simdVisible(OBJECT_COUNT);
+		double scalarBoxes = 0.0, simdBoxes = 0.0, scalarSpheres = 0.0, simdSpheres = 0.0;
+		std::size_t boxCount = 0, sphereCount = 0, mismatches = 0;
+		for (int iteration = 0; iteration < ITERATIONS; ++iteration) {
+			const glm::mat4 view = glm::rotate(glm::mat4(1.0f), iteration * 0.3f, glm::vec3(0.0f, 1.0f, 0.0f));
+			const Frustum frustum = extractFrustum(projection * view);
+
+			BenchmarkClock::time_point start = BenchmarkClock::now();
+			const std::size_t scalarBoxCount = cullBoxesScalar(frustum, bounds, scalarVisible.data());
+			scalarBoxes += millisecondsSince(start);
+			start = BenchmarkClock::now();
+			boxCount = cullBoxes(frustum, bounds, simdVisible.data());
+			simdBoxes += millisecondsSince(start);
+			if (boxCount != scalarBoxCount || !std::equal(scalarVisible.begin(), scalarVisible.begin() + boxCount, simdVisible.begin())) ++mismatches;
+
+			start = BenchmarkClock::now();
+			const std::size_t scalarSphereCount = cullSpheresScalar(frustum, bounds, scalarVisible.data());
+			scalarSpheres += millisecondsSince(start);
+			start = BenchmarkClock::now();
+			sphereCount = cullSpheres(frustum, bounds, simdVisible.data());
+			simdSpheres += millisecondsSince(start);
+			if (sphereCount != scalarSphereCount || !std::equal(scalarVisible.begin(), scalarVisible.begin() + sphereCount, simdVisible.begin())) ++mismatches;
+		}
+
+		std::cout << "Culling " << OBJECT_COUNT << " objects (last frame: " << boxCount << " boxes, " << sphereCount << " spheres visible; "
+			<< mismatches << " of " << 2 * ITERATIONS << " SIMD lists differ from the scalar reference)" << '\n';
+		std::cout << "  boxes, scalar:   " << nanosecondsPerObject(scalarBoxes / ITERATIONS, OBJECT_COUNT) << " ns/object" << '\n';
+		std::cout << "  boxes, SSE:      " << nanosecondsPerObject(simdBoxes / ITERATIONS, OBJECT_COUNT) << " ns/object" << '\n';
+		std::cout << "  spheres, scalar: " << nanosecondsPerObject(scalarSpheres / ITERATIONS, OBJECT_COUNT) << " ns/object" << '\n';
+		std::cout << "  spheres, SSE:    " << nanosecondsPerObject(simdSpheres / ITERATIONS, OBJECT_COUNT) << " ns/object" << '\n';
+		return mismatches == 0;
+	}
+
+	// Unit cubes scattered through a cube of side 2 * extent, each with its own size.
+	void scatterCubes(const std::size_t count, const float extent, std::vector<glm::mat4>& models, ObjectBounds& bounds) {
+		models.resize(count);
+		bounds.resize(count);
+		for (std::size_t i = 0; i < count; ++i) {
+			const glm::vec3 center = (glm::vec3(std::rand(), std::rand(), std::rand()) / static_cast<float>(RAND_MAX) * 2.0f - 1.0f) * extent;
+			models[i] = glm::scale(glm::translate(glm::mat4(1.0f), center), glm::vec3(1.0f + static_cast<float>(i % 4)));
+			glm::vec3 worldCenter, worldExtents;
+			transformBounds(models[i], glm::vec3(0.0f), glm::vec3(0.5f), worldCenter, worldExtents);
+			bounds.set(i, worldCenter, worldExtents);
+		}
+	}
+
+	bool runBvhBenchmark() {
+		const std::size_t OBJECT_COUNTS[] = { 10000, 100000, 1000000 };
+		const int QUERY_ITERATIONS = 20;
+		const int BVH_RAYS = 200;
+		const int BRUTE_FORCE_RAYS = 4;
+		const IndexedMesh cube = buildCubeMesh();
+		const glm::mat4 projection = glm::perspective(glm::radians(45.0f), 4.0f / 3.0f, 0.1f, 150.0f);
+
+		bool matchesBruteForce = true;
+		for (const std::size_t objectCount : OBJECT_COUNTS) {
+			// Same density at every size, so the frustum sees a similar fraction of the scene.
+			const float extent = 200.0f * std::cbrt(objectCount / 1000000.0f);
+			std::vector<glm::mat4> models;
+			ObjectBounds bounds;
+			std::srand(1);
+			scatterCubes(objectCount, extent, models, bounds);
+
+			BoundingVolumeHierarchy hierarchy;
+			BenchmarkClock::time_point start = BenchmarkClock::now();
+			hierarchy.build(bounds);
+			const double buildMilliseconds = millisecondsSince(start);
+			const float builtCost = hierarchy.cost();
+
+			std::vector<std::uint32_t> bruteForce(objectCount), visible;
+			double bruteForceMilliseconds = 0.0, hierarchyMilliseconds = 0.0;
+			std::size_t mismatches = 0, visibleCount = 0;
+			for (int iteration = 0; iteration < QUERY_ITERATIONS; ++iteration) {
+				const Frustum frustum = extractFrustum(projection * glm::rotate(glm::mat4(1.0f), iteration * 0.3f, glm::vec3(0.0f, 1.0f, 0.0f)));
+				start = BenchmarkClock::now();
+				visibleCount = cullBoxes(frustum, bounds, bruteForce.data());
+				bruteForceMilliseconds += millisecondsSince(start);
+				start = BenchmarkClock::now();
+				hierarchy.queryFrustum(frustum, bounds, visible);
+				hierarchyMilliseconds += millisecondsSince(start);
+				std::sort(visible.begin(), visible.end());
+				if (visible.size() != visibleCount || !std::equal(visible.begin(), visible.end(), bruteForce.begin())) ++mismatches;
+			}
+
+			// Nudge every object as a frame of animation would, then refit or rebuild.
+			for (std::size_t i = 0; i < objectCount; ++i) {
+				models[i][3] += glm::vec4(std::sin(static_cast<float>(i)), std::cos(static_cast<float>(i)), 0.0f, 0.0f) * 2.0f;
+				glm::vec3 worldCenter, worldExtents;
+				transformBounds(models[i], glm::vec3(0.0f), glm::vec3(0.5f), worldCenter, worldExtents);
+				bounds.set(i, worldCenter, worldExtents);
+			}
+			start = BenchmarkClock::now();
+			hierarchy.refit(bounds);
+			const double refitMilliseconds = millisecondsSince(start);
+			const float refitCost = hierarchy.cost();
+
+			// Rays from the origin out through the scene; the brute-force hits check the tree's.
+			std::vector<glm::vec3> directions(BVH_RAYS);
+			for (glm::vec3& direction : directions) direction = glm::normalize(glm::vec3(std::rand(), std::rand(), std::rand()) / static_cast<float>(RAND_MAX) * 2.0f - 1.0f);
+			std::size_t hits = 0, pickMismatches = 0;
+			start = BenchmarkClock::now();
+			for (const glm::vec3& direction : directions) {
+				RayHit hit;
+				hits += hierarchy.intersectRay(glm::vec3(0.0f), direction, cube, models.data(), hit);
+			}
+			const double pickMilliseconds = millisecondsSince(start);
+			start = BenchmarkClock::now();
+			for (int ray = 0; ray < BRUTE_FORCE_RAYS; ++ray) {
+				RayHit bruteForceHit;
+				intersectRayBruteForce(glm::vec3(0.0f), directions[ray], cube, models.data(), objectCount, bruteForceHit);
+				RayHit hit;
+				hierarchy.intersectRay(glm::vec3(0.0f), directions[ray], cube, models.data(), hit);
+				if (hit.distance != bruteForceHit.distance) ++pickMismatches;
+			}
+			const double bruteForcePickMilliseconds = millisecondsSince(start);
+
+			start = BenchmarkClock::now();
+			hierarchy.build(bounds);
+			const double rebuildMilliseconds = millisecondsSince(start);
+
+			std::cout << objectCount << " objects, " << hierarchy.nodes().size() << " nodes" << '\n';
+			std::cout << "  build: " << buildMilliseconds << " ms, refit: " << refitMilliseconds << " ms (SAH cost " << builtCost << " -> " << refitCost << "), rebuild: " << rebuildMilliseconds << " ms" << '\n';
+			std::cout << "  frustum, brute force SSE: " << bruteForceMilliseconds / QUERY_ITERATIONS << " ms, BVH: " << hierarchyMilliseconds / QUERY_ITERATIONS << " ms ("
+				<< visibleCount << " visible, " << mismatches << " of " << QUERY_ITERATIONS << " lists differ)" << '\n';
+			std::cout << "  picking, brute force: " << bruteForcePickMilliseconds / BRUTE_FORCE_RAYS << " ms/ray, BVH: " << pickMilliseconds * 1000.0 / BVH_RAYS << " us/ray ("
+				<< hits << " of " << BVH_RAYS << " rays hit, " << pickMismatches << " of " << BRUTE_FORCE_RAYS << " differ)" << '\n';
+			matchesBruteForce = matchesBruteForce && mismatches == 0 && pickMismatches == 0;
+		}
+		return matchesBruteForce;
+	}
+
+	bool runOcclusionBenchmark() {
+		const std::size_t OBJECT_COUNT = 100000;
+		const int FRAMES = 30;
+		const IndexedMesh cube = buildCubeMesh();
+		const glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 200.0f);
+
+		// A row of wide walls with gaps between them, and small boxes scattered behind and around.
+		std::vector<glm::mat4> occluders;
+		for (int wall = 0; wall < 4; ++wall) {
+			occluders.push_back(glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(-18.0f + wall * 12.0f, 0.0f, -25.0f)), glm::vec3(9.0f, 30.0f, 1.0f)));
+		}
+		ObjectBounds bounds;
+		bounds.resize(OBJECT_COUNT);
+		std::srand(1);
+		for (std::size_t i = 0; i < OBJECT_COUNT; ++i) {
+			const glm::vec3 unit = glm::vec3(std::rand(), std::rand(), std::rand()) / static_cast<float>(RAND_MAX);
+			bounds.set(i, glm::vec3(unit.x * 160.0f - 80.0f, unit.y * 60.0f - 30.0f, -10.0f - unit.z * 180.0f), glm::vec3(0.5f));
+		}
+
+		OcclusionCuller culler, scalarCuller;
+		culler.create(256, 128);
+		scalarCuller.create(256, 128, false);
+		std::vector<std::uint32_t> visible(OBJECT_COUNT), scalarVisible(OBJECT_COUNT);
+		double frustumMilliseconds = 0.0, rasterMilliseconds = 0.0, scalarRasterMilliseconds = 0.0, pyramidMilliseconds = 0.0, testMilliseconds = 0.0;
+		std::size_t inFrustum = 0, occluded = 0, triangles = 0, mismatches = 0;
+		for (int frame = 0; frame < FRAMES; ++frame) {
+			const glm::mat4 view = glm::rotate(glm::mat4(1.0f), std::sin(frame * 0.2f) * 0.3f, glm::vec3(0.0f, 1.0f, 0.0f));
+			const glm::mat4 viewProjection = projection * view;
+			BenchmarkClock::time_point start = BenchmarkClock::now();
+			const std::size_t frustumCount = cullBoxes(extractFrustum(viewProjection), bounds, visible.data());
+			frustumMilliseconds += millisecondsSince(start);
+
+			culler.beginFrame(viewProjection);
+			scalarCuller.beginFrame(viewProjection);
+			for (const glm::mat4& occluder : occluders) {
+				culler.addOccluder(cube, occluder);
+				scalarCuller.addOccluder(cube, occluder);
+			}
+			culler.finishOccluders();
+			scalarCuller.finishOccluders();
+			std::copy(visible.begin(), visible.begin() + frustumCount, scalarVisible.begin());
+			const std::size_t visibleCount = culler.cullObjects(bounds, visible.data(), frustumCount);
+			const std::size_t scalarCount = scalarCuller.cullObjects(bounds, scalarVisible.data(), frustumCount);
+			if (visibleCount != scalarCount || culler.depthBuffer() != scalarCuller.depthBuffer()) ++mismatches;
+
+			const OcclusionStatistics& statistics = culler.statistics();
+			inFrustum += statistics.testedObjects;
+			occluded += statistics.occludedObjects;
+			triangles += statistics.occluderTriangles;
+			rasterMilliseconds += statistics.rasterMilliseconds;
+			scalarRasterMilliseconds += scalarCuller.statistics().rasterMilliseconds;
+			pyramidMilliseconds += statistics.pyramidMilliseconds;
+			testMilliseconds += statistics.testMilliseconds;
+		}
+
+		std::cout << "Occlusion culling " << OBJECT_COUNT << " objects behind " << occluders.size() << " occluders over " << FRAMES << " frames ("
+			<< mismatches << " frames where SSE and scalar differ)" << '\n';
+		std::cout << "  per frame: " << inFrustum / FRAMES << " objects in the frustum, " << occluded / FRAMES << " occluded (" << 100.0 * occluded / std::max<std::size_t>(inFrustum, 1) << "%), "
+			<< triangles / FRAMES << " occluder triangles" << '\n';
+		std::cout << "  frustum:        " << frustumMilliseconds / FRAMES << " ms" << '\n';
+		std::cout << "  raster, SSE:    " << rasterMilliseconds / FRAMES << " ms (scalar " << scalarRasterMilliseconds / FRAMES << " ms)" << '\n';
+		std::cout << "  pyramid:        " << pyramidMilliseconds / FRAMES << " ms" << '\n';
+		std::cout << "  tests:          " << testMilliseconds / FRAMES << " ms (" << testMilliseconds * 1.0e6 / std::max<std::size_t>(inFrustum, 1) << " ns/object)" << '\n';
+		return mismatches == 0;
+	}
+
+	// Programs, textures and cube meshes for draw submission benchmarks; every mesh has a one-instance
+	// buffer in front of the camera so draws produce fragments.
+	struct DrawResources {
+		std::vector<ShaderProgram> programs;
+		std::vector<unsigned> textures;
+		std::vector<MeshBuffers> meshes;
+		std::vector<InstanceBuffer> instances;
+	};
+
+	void createDrawResources(const int programCount, const int textureCount, const int meshCount, DrawResources& resources) {
+		const std::string vertexSource = readTextFile("source/shaders/VertexShader.txt");
+		const std::string fragmentSource = readTextFile("source/shaders/FragmentShader.txt");
+		for (int i = 0; i < programCount; ++i) resources.programs.push_back(ShaderProgram(compileShaderProgram(makeShaderVariant(vertexSource, i).c_str(), fragmentSource.c_str())));
+		resources.textures.resize(textureCount);
+		glGenTextures(textureCount, resources.textures.data());
+		for (int i = 0; i < textureCount; ++i) {
+			const unsigned char pixel[4] = { static_cast<unsigned char>(i * 4), 128, 255, 255 };
+			glBindTexture(GL_TEXTURE_2D, resources.textures[i]);
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixel);
+		}
+		glBindTexture(GL_TEXTURE_2D, 0);
+		QuantizedMesh quantizedCube;
+		quantizeMesh(buildCubeMesh(), quantizedCube, false);
+		resources.meshes.resize(meshCount);
+		resources.instances.resize(meshCount);
+		const glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -3.0f));
+		for (int i = 0; i < meshCount; ++i) {
+			resources.meshes[i] = createMeshBuffers(quantizedCube);
+			resources.instances[i].create(resources.meshes[i].vertexArray, 2, 1);
+			resources.instances[i].update(&model, 1);
+		}
+	}
+
+	void destroyDrawResources(DrawResources& resources) {
+		glBindVertexArray(0);
+		for (std::size_t i = 0; i < resources.meshes.size(); ++i) {
+			resources.instances[i].destroy();
+			destroyMeshBuffers(resources.meshes[i]);
+		}
+		glDeleteTextures(static_cast<int>(resources.textures.size()), resources.textures.data());
+		for (ShaderProgram& program : resources.programs) program.destroy();
+		resources = DrawResources();
+	}
+
+	DrawPacket randomDrawPacket(DrawResources& resources) {
+		const std::size_t mesh = std::rand() % resources.meshes.size();
+		ShaderProgram* program = &resources.programs[std::rand() % resources.programs.size()];
+		const unsigned texture = resources.textures[std::rand() % resources.textures.size()];
+		return { program, texture, &resources.meshes[mesh], &resources.instances[mesh], static_cast<float>(std::rand()) / RAND_MAX * 100.0f };
+	}
+
+	// Binds every piece of state for every packet, the way draws were issued before the render queue.
+	void submitBindingEverything(const std::vector<DrawPacket>& packets) {
+		for (const DrawPacket& packet : packets) {
+			packet.program->use();
+			glBindVertexArray(packet.mesh->vertexArray);
+			glBindTexture(GL_TEXTURE_2D, packet.texture);
+			packet.program->setVec3("positionScale", packet.mesh->positionScale);
+			packet.program->setVec3("positionBias", packet.mesh->positionBias);
+			packet.instances->drawElements(GL_TRIANGLES, packet.mesh->indexCount, packet.mesh->indexType);
+		}
+	}
+
+	unsigned long long framebufferChecksum(const int width, const int height) {
+		std::vector<unsigned char> pixels(static_cast<std::size_t>(width) * height * 4);
+		glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+		unsigned long long checksum = 1469598103934665603ull;
+		for (const unsigned char value : pixels) checksum = (checksum ^ value) * 1099511628211ull;
+		return checksum;
+	}
+
+	bool runRenderQueueBenchmark() {
+		const int PROGRAM_COUNT = 16;
+		const int TEXTURE_COUNT = 64;
+		const int MESH_COUNT = 32;
+		const std::size_t SORT_COUNT = 1000000;
+		const std::size_t DRAW_COUNT = 20000;
+
+		DrawResources resources;
+		createDrawResources(PROGRAM_COUNT, TEXTURE_COUNT, MESH_COUNT, resources);
+
+		std::srand(1);
+		RenderQueue queue;
+		for (std::size_t i = 0; i < SORT_COUNT; ++i) queue.push(randomDrawPacket(resources));
+
+		// Sorting alone, on keys built the way RenderQueue::sort builds them.
+		std::vector<SortEntry> keys(SORT_COUNT), scratch(SORT_COUNT), expected;
+		for (std::size_t i = 0; i < SORT_COUNT; ++i) keys[i] = { (static_cast<std::uint64_t>(std::rand()) << 40) ^ (static_cast<std::uint64_t>(std::rand()) << 20) ^ static_cast<std::uint64_t>(std::rand()), static_cast<std::uint32_t>(i) };
+		expected = keys;
+		BenchmarkClock::time_point start = BenchmarkClock::now();
+		std::stable_sort(expected.begin(), expected.end(), [](const SortEntry& a, const SortEntry& b) { return a.key < b.key; });
+		const double stdSortMilliseconds = millisecondsSince(start);
+		JobSystem jobSystem;
+		jobSystem.create();
+		const unsigned threadCount = jobSystem.threadCount();
+		std::vector<SortEntry> sorted = keys;
+		start = BenchmarkClock::now();
+		radixSort(sorted.data(), scratch.data(), SORT_COUNT);
+		const double radixMilliseconds = millisecondsSince(start);
+		const bool radixMatches = std::equal(sorted.begin(), sorted.end(), expected.begin(), [](const SortEntry& a, const SortEntry& b) { return a.key == b.key && a.index == b.index; });
+		sorted = keys;
+		start = BenchmarkClock::now();
+		radixSort(sorted.data(), scratch.data(), SORT_COUNT, &jobSystem);
+		const double parallelMilliseconds = millisecondsSince(start);
+		const bool parallelMatches = std::equal(sorted.begin(), sorted.end(), expected.begin(), [](const SortEntry& a, const SortEntry& b) { return a.key == b.key && a.index == b.index; });
+		std::cout << "Sorting " << SORT_COUNT << " keys" << '\n';
+		std::cout << "  std::stable_sort:     " << stdSortMilliseconds << " ms" << '\n';
+		std::cout << "  radix, 1 thread:      " << radixMilliseconds << " ms" << (radixMatches ? "" : " (WRONG ORDER)") << '\n';
+		std::cout << "  radix, " << threadCount << " threads:     " << parallelMilliseconds << " ms" << (parallelMatches ? "" : " (WRONG ORDER)") << '\n';
+		queue.sort(&jobSystem);
+		queue.report();
+
+		// Submission: binding everything per draw in arrival order, then through the queue.
+		std::vector<DrawPacket> packets;
+		for (std::size_t i = 0; i < DRAW_COUNT; ++i) packets.push_back(randomDrawPacket(resources));
+		glFinish();
+		start = BenchmarkClock::now();
+		submitBindingEverything(packets);
+		glFinish();
+		const double naiveMilliseconds = millisecondsSince(start);
+		queue.clear();
+		start = BenchmarkClock::now();
+		for (const DrawPacket& packet : packets) queue.push(packet);
+		queue.sort(&jobSystem);
+		queue.submit();
+		glFinish();
+		const double queueMilliseconds = millisecondsSince(start);
+		std::vector<CommandBuffer> commandBuffers;
+		start = BenchmarkClock::now();
+		queue.record(commandBuffers, &jobSystem);
+		replayCommandBuffers(commandBuffers);
+		glFinish();
+		const double recordedMilliseconds = millisecondsSince(start);
+		std::cout << "Submitting " << DRAW_COUNT << " draws over " << PROGRAM_COUNT << " programs, " << TEXTURE_COUNT << " textures, " << MESH_COUNT << " meshes" << '\n';
+		std::cout << "  bind everything, arrival order: " << naiveMilliseconds << " ms" << '\n';
+		std::cout << "  render queue, sorted:           " << queueMilliseconds << " ms" << '\n';
+		std::cout << "  recorded, replayed:             " << recordedMilliseconds << " ms (recording threads: " << commandBuffers.size() << ")" << '\n';
+		queue.report();
+
+		// A replay sets positionScale behind the program's last-value cache, so a submit afterwards
+		// has to upload it again to draw the same picture as before the replay.
+		MeshBuffers scaledMesh = resources.meshes[0];
+		scaledMesh.positionScale *= 0.5f;
+		const DrawPacket plain = { &resources.programs[0], resources.textures[0], &resources.meshes[0], &resources.instances[0], 1.0f };
+		DrawPacket scaled = plain;
+		scaled.mesh = &scaledMesh;
+		RenderQueue plainQueue, scaledQueue;
+		plainQueue.push(plain);
+		plainQueue.sort();
+		scaledQueue.push(scaled);
+		scaledQueue.sort();
+		FrameConstantsBuffer frameConstantsBuffer;
+		frameConstantsBuffer.create();
+		bindFrameConstantsBlock(plain.program->id());
+		FrameConstants frameConstants;
+		frameConstants.view = glm::mat4(1.0f);
+		frameConstants.projection = glm::perspective(glm::radians(45.0f), 4.0f / 3.0f, 0.1f, 100.0f);
+		frameConstantsBuffer.update(frameConstants);
+		GLint viewport[4];
+		glGetIntegerv(GL_VIEWPORT, viewport);
+		unsigned long long checksums[2] = {};
+		for (int pass = 0; pass < 2; ++pass) {
+			if (pass == 1) {
+				scaledQueue.record(commandBuffers);
+				replayCommandBuffers(commandBuffers);
+			}
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			plainQueue.submit();
+			checksums[pass] = framebufferChecksum(viewport[2], viewport[3]);
+		}
+		std::cout << "  submit after a replay: " << (checksums[0] == checksums[1] ? "same picture" : "DIFFERENT PICTURE, stale uniform cache") << '\n';
+		frameConstantsBuffer.destroy();
+		destroyDrawResources(resources);
+		jobSystem.destroy();
+		return radixMatches && parallelMatches && checksums[0] == checksums[1];
+	}
+
+	bool runStateCacheBenchmark() {
+		const int PROGRAM_COUNT = 16;
+		const int TEXTURE_COUNT = 64;
+		const int MESH_COUNT = 32;
+		const std::size_t DRAW_COUNT = 20000;
+		const int FRAMES = 5;
+
+		DrawResources resources;
+		createDrawResources(PROGRAM_COUNT, TEXTURE_COUNT, MESH_COUNT, resources);
+		std::srand(1);
+		std::vector<DrawPacket> packets;
+		for (std::size_t i = 0; i < DRAW_COUNT; ++i) packets.push_back(randomDrawPacket(resources));
+		std::sort(packets.begin(), packets.end(), [](const DrawPacket& a, const DrawPacket& b) {
+			return makeSortKey(a.program->id(), a.texture, a.mesh->vertexArray, a.depth) < makeSortKey(b.program->id(), b.texture, b.mesh->vertexArray, b.depth);
+		});
+		GLint viewport[4];
+		glGetIntegerv(GL_VIEWPORT, viewport);
+
+		// Frames bind everything per draw, in sorted order where most of those binds repeat the last
+		// one, first straight into the driver and then through the cache.
+		std::cout << DRAW_COUNT << " sorted draws binding everything, " << FRAMES << " frames" << '\n';
+		unsigned long long checksums[2] = {};
+		for (int cached = 0; cached < 2; ++cached) {
+			if (cached) installGLStateCache();
+			double milliseconds = 0.0;
+			for (int frame = 0; frame < FRAMES; ++frame) {
+				glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+				glEnable(GL_DEPTH_TEST);
+				glDepthFunc(GL_LESS);
+				glActiveTexture(GL_TEXTURE0);
+				glClearColor(0.2f, 0.7f, 0.2f, 1.0f);
+				glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+				glFinish();
+				const BenchmarkClock::time_point start = BenchmarkClock::now();
+				submitBindingEverything(packets);
+				glFinish();
+				milliseconds += millisecondsSince(start);
+				if (cached) endGLStateFrame();
+			}
+			checksums[cached] = framebufferChecksum(viewport[2], viewport[3]);
+			std::cout << (cached ? "  through the cache:    " : "  straight to GL:       ") << milliseconds / FRAMES << " ms/frame" << '\n';
+		}
+		reportGLStateCache();
+		const bool verified = verifyGLStateCache();
+		std::cout << "  shadow state " << (verified ? "matches GL" : "DOES NOT MATCH GL") << ", frames " << (checksums[0] == checksums[1] ? "identical" : "DIFFER") << '\n';
+
+		// Deleting bound objects has to reset their shadows or the next bind of a reused name is lost.
+		glBindVertexArray(resources.meshes[0].vertexArray);
+		glBindTexture(GL_TEXTURE_2D, resources.textures[0]);
+		destroyDrawResources(resources);
+		const bool verifiedAfterDelete = verifyGLStateCache();
+		std::cout << "  after deleting bound objects: " << (verifiedAfterDelete ? "matches GL" : "DOES NOT MATCH GL") << '\n';
+		uninstallGLStateCache();
+		return verified && checksums[0] == checksums[1] && verifiedAfterDelete;
+	}
+
+	// The pre-instancing vertex shader: one model matrix uniform per draw.
+	const char* PER_DRAW_VERTEX_SHADER =
+		"#version 330\n"
+		"layout(location = 0) in vec3 positionAttribute;\n"
+		"layout(location = 1) in vec2 textureCoordinateAttribute;\n"
+		"out vec2 textureCoordinate;\n"
+		"layout(std140) uniform FrameConstants { mat4 view; mat4 projection; };\n"
+		"uniform mat4 model;\n"
+		"void main() {\n"
+		"	gl_Position = projection * view * model * vec4(positionAttribute, 1.0);\n"
+		"	textureCoordinate = textureCoordinateAttribute;\n"
+		"}\n";
+
+	bool runInstancingBenchmark() {
+		const int CUBE_COUNT = 100000;
+		const int FRAMES = 5;
+		const int GRID_SIZE = 47;
+		const glm::vec3 axis(0.5f, 1.0f, 0.0f);
+
+		const std::string fragmentSource = readTextFile("source/shaders/FragmentShader.txt");
+		ShaderProgram perDrawProgram(compileShaderProgram(PER_DRAW_VERTEX_SHADER, fragmentSource.c_str()));
+		ShaderProgram instancedProgram(compileShaderProgram(readTextFile("source/shaders/VertexShader.txt").c_str(), fragmentSource.c_str()));
+		bindFrameConstantsBlock(perDrawProgram.id());
+		bindFrameConstantsBlock(instancedProgram.id());
+		const int modelSlot = perDrawProgram.uniformSlot("model");
+
+		MeshBuffers cubeMesh = createMeshBuffers(buildCubeMesh());
+		InstanceBuffer instanceBuffer;
+		instanceBuffer.create(cubeMesh.vertexArray, 2, CUBE_COUNT);
+
+		FrameConstantsBuffer frameConstantsBuffer;
+		frameConstantsBuffer.create();
+		FrameConstants frameConstants;
+		frameConstants.view = glm::translate(glm::mat4(1.0f), glm::vec3(-GRID_SIZE, -GRID_SIZE, -3.0f * GRID_SIZE));
+		frameConstants.projection = glm::perspective(glm::radians(45.0f), 4.0f / 3.0f, 0.1f, 1000.0f);
+		frameConstantsBuffer.update(frameConstants);
+
+		std::vector<Transform> cubes(CUBE_COUNT);
+		for (int i = 0; i < CUBE_COUNT; ++i) cubes[i].setPosition(2.0f * glm::vec3(static_cast<float>(i % GRID_SIZE), static_cast<float>(i / GRID_SIZE % GRID_SIZE), -static_cast<float>(i / (GRID_SIZE * GRID_SIZE))));
+		std::vector<glm::mat4> matrices(CUBE_COUNT);
+		glEnable(GL_DEPTH_TEST);
+		glBindVertexArray(cubeMesh.vertexArray);
+
+		double perDrawSubmit = 0.0, perDrawFrame = 0.0;
+		double instancedSubmit = 0.0, instancedFrame = 0.0;
+		double mappedSubmit = 0.0, mappedFrame = 0.0;
+		for (int frame = 0; frame < FRAMES; ++frame) {
+			for (Transform& cube : cubes) cube.rotate(0.01f, axis);
+			composeTransforms(cubes.data(), cubes.size(), glm::mat4(1.0f), matrices.data());
+
+			glFinish();
+			BenchmarkClock::time_point start = BenchmarkClock::now();
+			perDrawProgram.use();
+			for (int i = 0; i < CUBE_COUNT; ++i) {
+				perDrawProgram.setMat4(modelSlot, matrices[i]);
+				glDrawElements(GL_TRIANGLES, cubeMesh.indexCount, cubeMesh.indexType, NULL);
+			}
+			perDrawSubmit += millisecondsSince(start);
+			glFinish();
+			perDrawFrame += millisecondsSince(start);
+
+			start = BenchmarkClock::now();
+			instancedProgram.use();
+			instancedProgram.setVec3("positionScale", cubeMesh.positionScale);
+			instancedProgram.setVec3("positionBias", cubeMesh.positionBias);
+			instanceBuffer.update(matrices.data(), matrices.size());
+			instanceBuffer.drawElements(GL_TRIANGLES, cubeMesh.indexCount, cubeMesh.indexType);
+			instancedSubmit += millisecondsSince(start);
+			glFinish();
+			instancedFrame += millisecondsSince(start);
+
+			for (Transform& cube : cubes) cube.rotate(0.01f, axis);
+			start = BenchmarkClock::now();
+			glm::mat4* mapped = instanceBuffer.map(cubes.size());
+			if (mapped) composeTransforms(cubes.data(), cubes.size(), glm::mat4(1.0f), mapped);
+			instanceBuffer.unmap();
+			instanceBuffer.drawElements(GL_TRIANGLES, cubeMesh.indexCount, cubeMesh.indexType);
+			mappedSubmit += millisecondsSince(start);
+			glFinish();
+			mappedFrame += millisecondsSince(start);
+		}
+		glBindVertexArray(0);
+		glUseProgram(0);
+		glDisable(GL_DEPTH_TEST);
+
+		std::cout << "Drawing " << CUBE_COUNT << " cubes (CPU submit / submit + glFinish per frame, " << reinterpret_cast<const char*>(glGetString(GL_RENDERER)) << ")" << '\n';
+		std::cout << "  glDrawElements per cube:           " << perDrawSubmit / FRAMES << " / " << perDrawFrame / FRAMES << " ms" << '\n';
+		std::cout << "  glDrawElementsInstanced, SubData:  " << instancedSubmit / FRAMES << " / " << instancedFrame / FRAMES << " ms" << '\n';
+		std::cout << "  glDrawElementsInstanced, mapped:   " << mappedSubmit / FRAMES << " / " << mappedFrame / FRAMES << " ms (includes composing)" << '\n';
+
+		frameConstantsBuffer.destroy();
+		instanceBuffer.destroy();
+		destroyMeshBuffers(cubeMesh);
+		perDrawProgram.destroy();
+		instancedProgram.destroy();
+		return true;
+	}
+
+	bool runCommandBufferBenchmark() {
+		const int CUBE_COUNT = 50000;
+		const int TEXTURE_COUNT = 64;
+		const int FRAMES = 5;
+		const int GRID_SIZE = 47;
+		const unsigned RECORD_THREADS = 8;
+		const glm::vec3 axis(0.5f, 1.0f, 0.0f);
+
+		const std::string fragmentSource = readTextFile("source/shaders/FragmentShader.txt");
+		ShaderProgram program(compileShaderProgram(PER_DRAW_VERTEX_SHADER, fragmentSource.c_str()));
+		bindFrameConstantsBlock(program.id());
+		const int modelLocation = program.uniformLocation(program.uniformSlot("model"));
+		MeshBuffers cubeMesh = createMeshBuffers(buildCubeMesh());
+		std::vector<unsigned> textures(TEXTURE_COUNT);
+		glGenTextures(TEXTURE_COUNT, textures.data());
+		for (int i = 0; i < TEXTURE_COUNT; ++i) {
+			const unsigned char pixel[4] = { static_cast<unsigned char>(i * 4), 128, 255, 255 };
+			glBindTexture(GL_TEXTURE_2D, textures[i]);
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixel);
+		}
+
+		FrameConstantsBuffer frameConstantsBuffer;
+		frameConstantsBuffer.create();
+		FrameConstants frameConstants;
+		frameConstants.view = glm::translate(glm::mat4(1.0f), glm::vec3(-GRID_SIZE, -GRID_SIZE, -3.0f * GRID_SIZE));
+		frameConstants.projection = glm::perspective(glm::radians(45.0f), 4.0f / 3.0f, 0.1f, 1000.0f);
+		frameConstantsBuffer.update(frameConstants);
+		std::vector<Transform> cubes(CUBE_COUNT);
+		for (int i = 0; i < CUBE_COUNT; ++i) cubes[i].setPosition(2.0f * glm::vec3(static_cast<float>(i % GRID_SIZE), static_cast<float>(i / GRID_SIZE % GRID_SIZE), -static_cast<float>(i / (GRID_SIZE * GRID_SIZE))));
+		GLint viewport[4];
+		glGetIntegerv(GL_VIEWPORT, viewport);
+		glEnable(GL_DEPTH_TEST);
+		JobSystem jobSystem;
+		jobSystem.create(RECORD_THREADS - 1);
+
+		// The per-object scene work: the rotation depends only on the frame, so every mode draws the
+		// same pictures. Each range binds its own program and vertex array since it may replay first.
+		int frame = 0;
+		const auto recordRange = [&](CommandBuffer& buffer, const std::size_t begin, const std::size_t end) {
+			buffer.bindProgram(program.id());
+			buffer.bindVertexArray(cubeMesh.vertexArray);
+			for (std::size_t i = begin; i < end; ++i) {
+				cubes[i].setRotation(glm::angleAxis(0.01f * frame + 0.001f * i, glm::normalize(axis)));
+				if (i == begin || i % (CUBE_COUNT / TEXTURE_COUNT + 1) == 0) buffer.bindTexture(0, textures[i / (CUBE_COUNT / TEXTURE_COUNT + 1)]);
+				buffer.setMat4(modelLocation, cubes[i].matrix());
+				buffer.drawElements(GL_TRIANGLES, cubeMesh.indexCount, cubeMesh.indexType);
+			}
+		};
+
+		std::cout << "Submitting " << CUBE_COUNT << " draws with per-draw matrices (record / replay / whole frame)" << '\n';
+		unsigned long long checksums[3] = {};
+		std::size_t commandBytes = 0, commandCount = 0;
+		for (int mode = 0; mode < 3; ++mode) {
+			std::vector<CommandBuffer> buffers(mode == 2 ? RECORD_THREADS : 1);
+			double recordMilliseconds = 0.0, replayMilliseconds = 0.0, frameMilliseconds = 0.0;
+			for (frame = 0; frame < FRAMES; ++frame) {
+				glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+				glFinish();
+				const BenchmarkClock::time_point start = BenchmarkClock::now();
+				if (mode == 0) {
+					// Scene work and GL calls interleaved on the context thread, as main does today.
+					glUseProgram(program.id());
+					glBindVertexArray(cubeMesh.vertexArray);
+					for (int i = 0; i < CUBE_COUNT; ++i) {
+						cubes[i].setRotation(glm::angleAxis(0.01f * frame + 0.001f * i, glm::normalize(axis)));
+						if (i == 0 || i % (CUBE_COUNT / TEXTURE_COUNT + 1) == 0) {
+							glActiveTexture(GL_TEXTURE0);
+							glBindTexture(GL_TEXTURE_2D, textures[i / (CUBE_COUNT / TEXTURE_COUNT + 1)]);
+						}
+						glUniformMatrix4fv(modelLocation, 1, GL_FALSE, &cubes[i].matrix()[0][0]);
+						glDrawElements(GL_TRIANGLES, cubeMesh.indexCount, cubeMesh.indexType, NULL);
+					}
+				}
+				else {
+					recordCommandBuffers(buffers, CUBE_COUNT, mode == 2 ? &jobSystem : NULL, recordRange);
+					const BenchmarkClock::time_point replayStart = BenchmarkClock::now();
+					recordMilliseconds += std::chrono::duration<double, std::milli>(replayStart - start).count();
+					replayCommandBuffers(buffers);
+					replayMilliseconds += millisecondsSince(replayStart);
+				}
+				glFinish();
+				frameMilliseconds += millisecondsSince(start);
+			}
+			checksums[mode] = framebufferChecksum(viewport[2], viewport[3]);
+			if (mode == 0) {
+				std::cout << "  direct GL calls:        - / " << frameMilliseconds / FRAMES << " ms (no separate record step)" << '\n';
+				continue;
+			}
+			commandBytes = commandCount = 0;
+			for (const CommandBuffer& buffer : buffers) {
+				commandBytes += buffer.byteSize();
+				commandCount += buffer.commandCount();
+			}
+			std::cout << "  recorded on " << buffers.size() << (buffers.size() == 1 ? " thread:  " : " threads: ") << recordMilliseconds / FRAMES << " / " << replayMilliseconds / FRAMES << " / " << frameMilliseconds / FRAMES << " ms" << '\n';
+		}
+		std::cout << "  " << commandCount << " commands in " << commandBytes / 1024 << " KiB per frame, frames " << (checksums[0] == checksums[1] && checksums[1] == checksums[2] ? "identical" : "DIFFER") << '\n';
+
+		glDisable(GL_DEPTH_TEST);
+		glBindVertexArray(0);
+		glUseProgram(0);
+		frameConstantsBuffer.destroy();
+		glDeleteTextures(TEXTURE_COUNT, textures.data());
+		destroyMeshBuffers(cubeMesh);
+		program.destroy();
+		jobSystem.destroy();
+		return checksums[0] == checksums[1] && checksums[1] == checksums[2];
+	}
+
+	void emptyJob(Job*, const void*) {}
+
+	void spawnEmptyJobs(Job* job, const void* data) {
+		JobSystem* system = *static_cast<JobSystem* const*>(data);
+		for (int i = 0; i < 1000; ++i) system->run(system->createChildJob(job, emptyJob));
+	}
+
+	void countJob(Job*, const void* data) {
+		(*static_cast<std::atomic<int>* const*>(data))->fetch_add(1, std::memory_order_relaxed);
+	}
+
+	struct CountingSpawner {
+		JobSystem* system;
+		std::atomic<int>* counter;
+	};
+
+	void spawnCountingJobs(Job* job, const void* data) {
+		const CountingSpawner spawner = *static_cast<const CountingSpawner*>(data);
+		for (int i = 0; i < 200; ++i) spawner.system->run(spawner.system->createChildJob(job, countJob, &spawner.counter, sizeof(spawner.counter)));
+	}
+
+	// Correctness rather than speed, with enough rounds and worker counts that a build with
+	// -fsanitize=thread sees the deques, wakeups and child counting race.
+	bool checkJobSystem() {
+		const unsigned WORKER_COUNTS[] = { 0, 1, 3, 7 };
+		const int ROUNDS = 20;
+		const std::size_t COUNT = 100000;
+		std::vector<long long> values(COUNT, 1), results(COUNT);
+		bool correct = true;
+		for (const unsigned workers : WORKER_COUNTS) {
+			JobSystem system;
+			system.create(workers);
+			for (int round = 0; round < ROUNDS; ++round) {
+				std::fill(results.begin(), results.end(), 0);
+				parallelFor(system, COUNT, [&](const std::size_t begin, const std::size_t end) {
+					for (std::size_t i = begin; i < end; ++i) results[i] = values[i] * 2 + static_cast<long long>(i);
+				});
+				const long long sum = std::accumulate(results.begin(), results.end(), 0LL);
+				correct = correct && sum == 2LL * COUNT + static_cast<long long>(COUNT) * (COUNT - 1) / 2;
+
+				// A grain of one makes a job per element, far more than one thread's first block of
+				// jobs holds, with the root and the big halves still unfinished throughout.
+				std::fill(results.begin(), results.end(), 0);
+				parallelFor(system, COUNT, [&](const std::size_t begin, const std::size_t end) {
+					for (std::size_t i = begin; i < end; ++i) results[i] = 1;
+				}, 1);
+				correct = correct && std::accumulate(results.begin(), results.end(), 0LL) == static_cast<long long>(COUNT);
+
+				// The root counts once and each of ten spawners' 200 children once.
+				std::atomic<int> counter(0);
+				std::atomic<int>* counterPointer = &counter;
+				Job* root = system.createJob(countJob, &counterPointer, sizeof(counterPointer));
+				const CountingSpawner spawner = { &system, &counter };
+				for (int i = 0; i < 10; ++i) system.run(system.createChildJob(root, spawnCountingJobs, &spawner, sizeof(spawner)));
+				system.run(root);
+				system.wait(root);
+				correct = correct && counter.load() == 2001;
+			}
+			system.destroy();
+		}
+		return correct;
+	}
+
+	bool runJobSystemBenchmark() {
+		const std::size_t TRANSFORM_COUNT = 1000000;
+		const int FRAMES = 10;
+		const int SPAWNERS = 64;
+		const glm::vec3 axis(0.5f, 1.0f, 0.0f);
+		const glm::mat4 parent = glm::perspective(glm::radians(45.0f), 4.0f / 3.0f, 0.1f, 100.0f) * glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -3.0f));
+
+		const unsigned coreCount = std::max(1u, std::thread::hardware_concurrency());
+		std::vector<unsigned> threadCounts;
+		for (unsigned count = 1; count < std::max(coreCount, 4u); count *= 2) threadCounts.push_back(count);
+		threadCounts.push_back(std::max(coreCount, 4u));
+
+		std::vector<Transform> transforms(TRANSFORM_COUNT);
+		std::vector<glm::mat4> expected(TRANSFORM_COUNT), matrices(TRANSFORM_COUNT);
+		const auto resetTransforms = [&]() {
+			for (std::size_t i = 0; i < TRANSFORM_COUNT; ++i) {
+				transforms[i] = Transform();
+				transforms[i].setPosition(glm::vec3(static_cast<float>(i % 100), static_cast<float>(i / 100 % 100), static_cast<float>(i / 10000)));
+			}
+		};
+		const auto updateRange = [&](const std::size_t begin, const std::size_t end) {
+			for (std::size_t i = begin; i < end; ++i) transforms[i].rotate(0.01f, axis);
+			composeTransforms(&transforms[begin], end - begin, parent, &matrices[begin]);
+		};
+		resetTransforms();
+		for (int frame = 0; frame < FRAMES; ++frame) updateRange(0, TRANSFORM_COUNT);
+		expected = matrices;
+
+		const bool checked = checkJobSystem();
+		std::cout << "Job system parallelFor sums and nested child counts with 0, 1, 3 and 7 workers: " << (checked ? "ok" : "WRONG") << '\n';
+		bool allMatch = true;
+
+		// Each row is a fresh system with threads - 1 workers; rows past the core count oversubscribe.
+		std::cout << "Job system, " << TRANSFORM_COUNT << " transform updates per frame and " << SPAWNERS * 1000 << " empty jobs, " << coreCount << " cores" << '\n';
+		double singleThreadMilliseconds = 0.0;
+		for (const unsigned threads : threadCounts) {
+			JobSystem system;
+			system.create(threads - 1);
+			resetTransforms();
+			BenchmarkClock::time_point start = BenchmarkClock::now();
+			for (int frame = 0; frame < FRAMES; ++frame) parallelFor(system, TRANSFORM_COUNT, updateRange);
+			const double transformMilliseconds = millisecondsSince(start) / FRAMES;
+			if (threads == 1) singleThreadMilliseconds = transformMilliseconds;
+			const bool matches = std::equal(matrices.begin(), matrices.end(), expected.begin());
+			allMatch = allMatch && matches;
+
+			JobSystem* systemPointer = &system;
+			start = BenchmarkClock::now();
+			Job* root = system.createJob(emptyJob);
+			for (int i = 0; i < SPAWNERS; ++i) system.run(system.createChildJob(root, spawnEmptyJobs, &systemPointer, sizeof(systemPointer)));
+			system.run(root);
+			system.wait(root);
+			const double jobNanoseconds = millisecondsSince(start) * 1.0e6 / (SPAWNERS * 1001 + 1);
+			system.destroy();
+
+			std::cout << "  " << threads << (threads == 1 ? " thread:  " : " threads: ") << transformMilliseconds << " ms/frame (" << singleThreadMilliseconds / transformMilliseconds << "x)"
+				<< (matches ? "" : " (WRONG RESULT)") << ", " << jobNanoseconds << " ns/job" << (threads > coreCount ? " (oversubscribed)" : "") << '\n';
+		}
+		return checked && allMatch;
+	}
+
+	struct PipelineSnapshot {
+		std::vector<glm::mat4> matrices;
+		BenchmarkClock::time_point inputTime;
+	};
+
+	bool runPipelineBenchmark() {
+		const int CUBE_COUNT = 20000;
+		const int FRAMES = 60;
+		const int GRID_SIZE = 30;
+		const glm::vec3 axis(0.5f, 1.0f, 0.0f);
+
+		ShaderProgram program(createShaderProgram("source/shaders/VertexShader.txt", "source/shaders/FragmentShader.txt"));
+		bindFrameConstantsBlock(program.id());
+		QuantizedMesh quantizedCube;
+		quantizeMesh(buildCubeMesh(), quantizedCube, false);
+		MeshBuffers cubeMesh = createMeshBuffers(quantizedCube);
+		InstanceBuffer instanceBuffer;
+		instanceBuffer.create(cubeMesh.vertexArray, 2, CUBE_COUNT);
+		FrameConstantsBuffer frameConstantsBuffer;
+		frameConstantsBuffer.create();
+		FrameConstants frameConstants;
+		frameConstants.view = glm::translate(glm::mat4(1.0f), glm::vec3(-GRID_SIZE, -GRID_SIZE, -3.0f * GRID_SIZE));
+		frameConstants.projection = glm::perspective(glm::radians(45.0f), 4.0f / 3.0f, 0.1f, 1000.0f);
+		frameConstantsBuffer.update(frameConstants);
+		std::vector<Transform> cubes(CUBE_COUNT);
+		for (int i = 0; i < CUBE_COUNT; ++i) cubes[i].setPosition(2.0f * glm::vec3(static_cast<float>(i % GRID_SIZE), static_cast<float>(i / GRID_SIZE % GRID_SIZE), -static_cast<float>(i / (GRID_SIZE * GRID_SIZE))));
+
+		// The same split as main: simulation writes a snapshot, rendering only reads one.
+		const auto simulate = [&](PipelineSnapshot& snapshot) {
+			snapshot.inputTime = BenchmarkClock::now();
+			for (Transform& cube : cubes) cube.rotate(0.01f, axis);
+			snapshot.matrices.resize(CUBE_COUNT);
+			composeTransforms(cubes.data(), cubes.size(), glm::mat4(1.0f), snapshot.matrices.data());
+		};
+		const auto render = [&](const PipelineSnapshot& snapshot) {
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			program.use();
+			program.setVec3("positionScale", cubeMesh.positionScale);
+			program.setVec3("positionBias", cubeMesh.positionBias);
+			glBindVertexArray(cubeMesh.vertexArray);
+			instanceBuffer.update(snapshot.matrices.data(), snapshot.matrices.size());
+			instanceBuffer.drawElements(GL_TRIANGLES, cubeMesh.indexCount, cubeMesh.indexType);
+			glFinish();
+		};
+		glEnable(GL_DEPTH_TEST);
+
+		std::cout << "Simulating " << CUBE_COUNT << " transforms and drawing them, " << FRAMES << " frames (" << std::max(1u, std::thread::hardware_concurrency()) << " cores)" << '\n';
+		for (int pipelined = 0; pipelined < 2; ++pipelined) {
+			TripleBuffer<PipelineSnapshot> snapshots;
+			std::thread simulationThread;
+			if (pipelined) {
+				simulationThread = std::thread([&]() {
+					while (snapshots.waitUntilConsumed()) {
+						simulate(snapshots.writeBuffer());
+						snapshots.publish();
+					}
+				});
+			}
+			double latencyMilliseconds = 0.0;
+			const BenchmarkClock::time_point start = BenchmarkClock::now();
+			for (int frame = 0; frame < FRAMES; ++frame) {
+				if (pipelined) snapshots.waitForPublish();
+				else {
+					simulate(snapshots.writeBuffer());
+					snapshots.publish();
+				}
+				snapshots.acquire();
+				render(snapshots.readBuffer());
+				latencyMilliseconds += millisecondsSince(snapshots.readBuffer().inputTime);
+			}
+			const double frameMilliseconds = millisecondsSince(start) / FRAMES;
+			if (pipelined) {
+				snapshots.close();
+				simulationThread.join();
+			}
+			std::cout << (pipelined ? "  pipelined:  " : "  sequential: ") << frameMilliseconds << " ms/frame, input to present " << latencyMilliseconds / FRAMES << " ms" << '\n';
+		}
+
+		glDisable(GL_DEPTH_TEST);
+		glBindVertexArray(0);
+		glUseProgram(0);
+		frameConstantsBuffer.destroy();
+		instanceBuffer.destroy();
+		destroyMeshBuffers(cubeMesh);
+		program.destroy();
+		return true;
+	}
+
+	struct TimestepReplay {
+		Transform camera;
+		Transform cube;
+		std::uint64_t stepsAtTenSeconds;
+		float largestRenderJump;
+		bool blendsInRange;
+	};
+
+	// Plays the recording through FixedTimestep and stepSimulation at a frame rate, or with random
+	// frame times when framesPerSecond is 0, and stops exactly at stepLimit steps. Like simulateFrame,
+	// each step takes the keys held when it starts.
+	TimestepReplay replayRecordedInput(const KeyChange* recording, const std::size_t recordingSize, const int stepLimit, const double framesPerSecond) {
+		FixedTimestep timestep;
+		const float stepSeconds = static_cast<float>(timestep.stepSeconds());
+		InputTimeline input;
+		for (std::size_t i = 0; i < recordingSize; ++i) input.record(recording[i]);
+		TimestepReplay replay;
+		replay.camera.setPosition(glm::vec3(0.0f, 0.0f, -3.0f));
+		replay.stepsAtTenSeconds = 0;
+		replay.largestRenderJump = 0.0f;
+		replay.blendsInRange = true;
+		Transform previousCamera = replay.camera;
+		float lastRenderZ = replay.camera.position().z;
+		std::srand(7);
+		double seconds = 0.0;
+		int step = 0;
+		while (step < stepLimit) {
+			const double frameSeconds = framesPerSecond > 0.0 ? 1.0 / framesPerSecond : 0.004 + 0.036 * std::rand() / RAND_MAX;
+			seconds += frameSeconds;
+			const int steps = timestep.advance(frameSeconds);
+			for (int i = 0; i < steps && step < stepLimit; ++i, ++step) {
+				previousCamera = replay.camera;
+				stepSimulation(replay.camera, replay.cube, input.keysAt(timestep.stepStartSeconds(i)), stepSeconds);
+			}
+			if (seconds <= 10.0) replay.stepsAtTenSeconds = timestep.steps();
+
+			const float renderZ = interpolateTransforms(previousCamera, replay.camera, timestep.alpha()).position().z;
+			const float low = std::min(previousCamera.position().z, replay.camera.position().z), high = std::max(previousCamera.position().z, replay.camera.position().z);
+			replay.blendsInRange = replay.blendsInRange && timestep.alpha() >= 0.0f && timestep.alpha() < 1.0f && renderZ >= low && renderZ <= high;
+			replay.largestRenderJump = std::max(replay.largestRenderJump, std::fabs(renderZ - lastRenderZ));
+			lastRenderZ = renderZ;
+		}
+		return replay;
+	}
+
+	float degreesBetween(const glm::quat& a, const glm::quat& b) {
+		return glm::degrees(2.0f * std::acos(std::min(1.0f, std::fabs(glm::dot(a, b)))));
+	}
+
+	bool sameBits(const Transform& a, const Transform& b) {
+		return std::memcmp(&a.position(), &b.position(), sizeof(glm::vec3)) == 0 && std::memcmp(&a.rotation(), &b.rotation(), sizeof(glm::quat)) == 0 && std::memcmp(&a.scale(), &b.scale(), sizeof(glm::vec3)) == 0;
+	}
+
+	// Every frame rate runs the same steps with the same keys, so the final camera and cube must
+	// match the first replay bit for bit. Against the keys integrated over continuous time, a step
+	// applies each key change late by less than one step.
+	bool runTimestepBenchmark() {
+		const int STEP_LIMIT = 600;
+		const KeyChange RECORDING[] = { { 0.0, { 0.0f, 0.0f } }, { 0.5, { -1.0f, 0.0f } }, { 2.25, { -1.0f, 1.0f } }, { 3.1, { 0.0f, 1.0f } }, { 5.0, { 1.0f, -1.0f } }, { 7.3, { 0.0f, 0.0f } }, { 8.0, { 1.0f, 0.0f } }, { 9.4, { 0.0f, 0.0f } } };
+		const double RATES[] = { 30.0, 60.0, 240.0, 0.0 };
+		const std::size_t recordingSize = sizeof(RECORDING) / sizeof(RECORDING[0]);
+
+		const double horizon = STEP_LIMIT * FixedTimestep().stepSeconds();
+		double movedSeconds = 0.0, turnedSeconds = 0.0, moveChanges = 0.0, turnChanges = 0.0;
+		for (std::size_t i = 0; i < recordingSize; ++i) {
+			const double end = std::min(horizon, i + 1 < recordingSize ? RECORDING[i + 1].seconds : horizon);
+			if (end > RECORDING[i].seconds) {
+				movedSeconds += RECORDING[i].keys.moveAxis * (end - RECORDING[i].seconds);
+				turnedSeconds += RECORDING[i].keys.turnAxis * (end - RECORDING[i].seconds);
+			}
+			if (i > 0 && RECORDING[i].seconds < horizon) {
+				moveChanges += std::fabs(RECORDING[i].keys.moveAxis - RECORDING[i - 1].keys.moveAxis);
+				turnChanges += std::fabs(RECORDING[i].keys.turnAxis - RECORDING[i - 1].keys.turnAxis);
+			}
+		}
+		const float expectedZ = -3.0f + static_cast<float>(CAMERA_SPEED * movedSeconds);
+		const glm::quat expectedRotation = glm::angleAxis(static_cast<float>(glm::radians(TURN_DEGREES_PER_SECOND * turnedSeconds)), glm::normalize(glm::vec3(0.5f, 1.0f, 0.0f)));
+		const double delay = FixedTimestep().stepSeconds();
+		const float moveTolerance = static_cast<float>(CAMERA_SPEED * moveChanges * delay) + 1e-3f;
+		const float turnTolerance = static_cast<float>(TURN_DEGREES_PER_SECOND * turnChanges * delay) + 1e-2f;
+
+		std::cout << "Replaying " << recordingSize << " timestamped input changes over " << STEP_LIMIT << " fixed steps, expecting camera z " << expectedZ << '\n';
+		bool passed = true;
+		TimestepReplay first;
+		for (const double rate : RATES) {
+			const TimestepReplay replay = replayRecordedInput(RECORDING, recordingSize, STEP_LIMIT, rate);
+			if (rate == RATES[0]) first = replay;
+			const bool identical = sameBits(replay.camera, first.camera) && sameBits(replay.cube, first.cube);
+			const float moveError = std::fabs(replay.camera.position().z - expectedZ);
+			const float turnError = degreesBetween(replay.cube.rotation(), expectedRotation);
+			const bool inTolerance = moveError <= moveTolerance && turnError <= turnTolerance;
+			passed = passed && identical && inTolerance && replay.blendsInRange;
+			if (rate > 0.0) std::cout << "  " << rate << " FPS: ";
+			else std::cout << "  4-40 ms frames: ";
+			std::cout << replay.stepsAtTenSeconds << " steps in 10 s, camera z off by " << moveError << " (allowed " << moveTolerance << "), cube off by " << turnError << " degrees (allowed " << turnTolerance << ")"
+				<< ", largest rendered step " << replay.largestRenderJump << (identical ? ", identical to " : ", DIFFERS FROM ") << RATES[0] << " FPS" << (inTolerance ? "" : ", OUT OF TOLERANCE") << (replay.blendsInRange ? "" : ", BLEND OUT OF RANGE") << '\n';
+		}
+
+		// The old rule moved the camera 0.1 per frame while W was held, so distance followed frame rate.
+		std::cout << "  per-frame movement for 1 s of W: " << 0.1f * 30 << " at 30 FPS, " << 0.1f * 240 << " at 240 FPS" << '\n';
+
+		FixedTimestep timestep;
+		const int normalSteps = timestep.advance(1.0 / 60.0);
+		const int stalledSteps = timestep.advance(1.0);
+		const int recoveredSteps = timestep.advance(1.0 / 60.0);
+		std::cout << "  1 s stall at 60 Hz: " << normalSteps << ", " << stalledSteps << ", " << recoveredSteps << " steps per frame, " << timestep.droppedSeconds() << " s dropped" << '\n';
+		return passed;
+	}
+
+	struct Benchmark {
+		const char* name;
+		bool (*run)();
+	};
+
+	const Benchmark BENCHMARKS[] = {
+		{ "shaders", runShaderCompileBenchmark },
+		{ "mipmaps", runMipmapBenchmark },
+		{ "texload", runTextureLoadBenchmark },
+		{ "bc", runBlockCompressionBenchmark },
+		{ "transforms", runTransformBenchmark },
+		{ "instancing", runInstancingBenchmark },
+		{ "meshes", runMeshBuilderBenchmark },
+		{ "objload", runObjLoadBenchmark },
+		{ "meshload", runMeshLoadBenchmark },
+		{ "culling", runCullingBenchmark },
+		{ "bvh", runBvhBenchmark },
+		{ "occlusion", runOcclusionBenchmark },
+		{ "renderqueue", runRenderQueueBenchmark },
+		{ "statecache", runStateCacheBenchmark },
+		{ "commandbuffers", runCommandBufferBenchmark },
+		{ "jobs", runJobSystemBenchmark },
+		{ "pipeline", runPipelineBenchmark },
+		{ "timestep", runTimestepBenchmark },
+	};
+}
+
+bool runBenchmark(const char* name) {
+	for (const Benchmark& benchmark : BENCHMARKS) {
+		if (std::strcmp(benchmark.name, name) == 0) {
+			return benchmark.run();
+		}
+	}
+
+	std::cout << "Unknown benchmark " << name << ", available:";
+	for (const Benchmark& benchmark : BENCHMARKS) std::cout << ' ' << benchmark.name;
+	std::cout << '\n';
+	return false;
+}
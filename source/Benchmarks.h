@@ -0,0 +1,5 @@
+#pragma once
+
+// Runs the named benchmark against the current GL context and prints its results.
+// Returns false when no benchmark has that name or one of its correctness checks failed.
+bool runBenchmark(const char* name);
@@ -0,0 +1,616 @@
+#include "BlockCompression.h"
+#include "GLExtensions.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <thread>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define BLOCK_COMPRESSION_SSE2 1
+#endif
+
+namespace {
+	// Channel-major so four texels of one channel load as a single SSE register.
+	typedef float BlockTexels[4][16];
+
+	const int BC7_WEIGHTS[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	struct BitWriter {
+		unsigned char* output;
+		int position;
+
+		void write(const unsigned value, const int bitCount) {
+			for (int i = 0; i < bitCount; ++i, ++position) {
+				if ((value >> i) & 1u) output[position >> 3] |= static_cast<unsigned char>(1u << (position & 7));
+			}
+		}
+	};
+
+	struct BitReader {
+		const unsigned char* input;
+		int position;
+
+		unsigned read(const int bitCount) {
+			unsigned value = 0;
+			for (int i = 0; i < bitCount; ++i, ++position) value |= ((input[position >> 3] >> (position & 7)) & 1u) << i;
+			return value;
+		}
+	};
+
+	// raw keeps the source channels as they are (BC4/BC5); otherwise grey and grey+alpha sources expand to RGBA.
+	void fetchBlock(const unsigned char* pixels, const int width, const int height, const int channels, const int blockX, const int blockY, const bool raw, BlockTexels& texels) {
+		for (int y = 0; y < 4; ++y) {
+			for (int x = 0; x < 4; ++x) {
+				const int sourceX = std::min(blockX * 4 + x, width - 1);
+				const int sourceY = std::min(blockY * 4 + y, height - 1);
+				const unsigned char* texel = pixels + (static_cast<std::size_t>(sourceY) * width + sourceX) * channels;
+				const int i = y * 4 + x;
+				if (raw) {
+					for (int c = 0; c < 4; ++c) texels[c][i] = (c < channels) ? texel[c] : 0.0f;
+				} else if (channels >= 3) {
+					texels[0][i] = texel[0];
+					texels[1][i] = texel[1];
+					texels[2][i] = texel[2];
+					texels[3][i] = (channels == 4) ? texel[3] : 255.0f;
+				} else {
+					texels[0][i] = texels[1][i] = texels[2][i] = texel[0];
+					texels[3][i] = (channels == 2) ? texel[1] : 255.0f;
+				}
+			}
+		}
+	}
+
+	// Picks the nearest palette entry for every texel over channels [firstChannel, firstChannel + channelCount)
+	// and returns the summed squared error.
+	float fitIndices(const BlockTexels& texels, const int firstChannel, const int channelCount, const float palette[][4], const int paletteCount, unsigned char indices[16]) {
+		float totalError = 0.0f;
+#ifdef BLOCK_COMPRESSION_SSE2
+		for (int group = 0; group < 16; group += 4) {
+			__m128 values[4];
+			for (int c = 0; c < channelCount; ++c) values[c] = _mm_loadu_ps(&texels[firstChannel + c][group]);
+
+			__m128 bestError = _mm_set1_ps(FLT_MAX);
+			__m128i bestIndex = _mm_setzero_si128();
+			for (int p = 0; p < paletteCount; ++p) {
+				__m128 error = _mm_setzero_ps();
+				for (int c = 0; c < channelCount; ++c) {
+					const __m128 difference = _mm_sub_ps(values[c], _mm_set1_ps(palette[p][c]));
+					error = _mm_add_ps(error, _mm_mul_ps(difference, difference));
+				}
+				const __m128i closer = _mm_castps_si128(_mm_cmplt_ps(error, bestError));
+				bestError = _mm_min_ps(error, bestError);
+				bestIndex = _mm_or_si128(_mm_and_si128(closer, _mm_set1_epi32(p)), _mm_andnot_si128(closer, bestIndex));
+			}
+
+			alignas(16) int groupIndices[4];
+			alignas(16) float groupErrors[4];
+			_mm_store_si128(reinterpret_cast<__m128i*>(groupIndices), bestIndex);
+			_mm_store_ps(groupErrors, bestError);
+			for (int i = 0; i < 4; ++i) {
+				indices[group + i] = static_cast<unsigned char>(groupIndices[i]);
+				totalError += groupErrors[i];
+			}
+		}
+#else
+		for (int i = 0; i < 16; ++i) {
+			float bestError = FLT_MAX;
+			for (int p = 0; p < paletteCount; ++p) {
+				float error = 0.0f;
+				for (int c = 0; c < channelCount; ++c) {
+					const float difference = texels[firstChannel + c][i] - palette[p][c];
+					error += difference * difference;
+				}
+				if (error < bestError) {
+					bestError = error;
+					indices[i] = static_cast<unsigned char>(p);
+				}
+			}
+			totalError += bestError;
+		}
+#endif
+		return totalError;
+	}
+
+	// Endpoints at the extremes of the texels projected onto the principal axis (power iteration on the
+	// covariance) or, for the fast path, onto the bounding box diagonal.
+	void findEndpoints(const BlockTexels& texels, const int channelCount, const bool usePrincipalAxis, float endpoint0[4], float endpoint1[4]) {
+		float mean[4] = {};
+		float minimum[4];
+		float maximum[4];
+		for (int c = 0; c < channelCount; ++c) {
+			minimum[c] = FLT_MAX;
+			maximum[c] = -FLT_MAX;
+			for (int i = 0; i < 16; ++i) {
+				mean[c] += texels[c][i];
+				minimum[c] = std::min(minimum[c], texels[c][i]);
+				maximum[c] = std::max(maximum[c], texels[c][i]);
+			}
+			mean[c] /= 16.0f;
+		}
+
+		float axis[4] = {};
+		for (int c = 0; c < channelCount; ++c) axis[c] = maximum[c] - minimum[c];
+		if (usePrincipalAxis) {
+			float covariance[4][4] = {};
+			for (int i = 0; i < 16; ++i) {
+				for (int a = 0; a < channelCount; ++a) {
+					for (int b = 0; b < channelCount; ++b) covariance[a][b] += (texels[a][i] - mean[a]) * (texels[b][i] - mean[b]);
+				}
+			}
+			for (int iteration = 0; iteration < 8; ++iteration) {
+				float next[4] = {};
+				float largest = 0.0f;
+				for (int a = 0; a < channelCount; ++a) {
+					for (int b = 0; b < channelCount; ++b) next[a] += covariance[a][b] * axis[b];
+					largest = std::max(largest, std::fabs(next[a]));
+				}
+				if (largest < 1e-6f) break;
+				for (int a = 0; a < channelCount; ++a) axis[a] = next[a] / largest;
+			}
+		}
+
+		float length = 0.0f;
+		for (int c = 0; c < channelCount; ++c) length += axis[c] * axis[c];
+		if (length < 1e-12f) {
+			for (int c = 0; c < channelCount; ++c) endpoint0[c] = endpoint1[c] = mean[c];
+			return;
+		}
+		length = std::sqrt(length);
+		for (int c = 0; c < channelCount; ++c) axis[c] /= length;
+
+		float lowest = FLT_MAX;
+		float highest = -FLT_MAX;
+		for (int i = 0; i < 16; ++i) {
+			float projection = 0.0f;
+			for (int c = 0; c < channelCount; ++c) projection += (texels[c][i] - mean[c]) * axis[c];
+			lowest = std::min(lowest, projection);
+			highest = std::max(highest, projection);
+		}
+		for (int c = 0; c < channelCount; ++c) {
+			endpoint0[c] = std::min(255.0f, std::max(0.0f, mean[c] + lowest * axis[c]));
+			endpoint1[c] = std::min(255.0f, std::max(0.0f, mean[c] + highest * axis[c]));
+		}
+	}
+
+	// Least-squares endpoints for fixed indices, where weights[index] is how far along endpoint0 -> endpoint1 that index sits.
+	void refineEndpoints(const BlockTexels& texels, const int channelCount, const unsigned char indices[16], const float* weights, float endpoint0[4], float endpoint1[4]) {
+		float a = 0.0f, b = 0.0f, c = 0.0f;
+		float x[4] = {}, y[4] = {};
+		for (int i = 0; i < 16; ++i) {
+			const float weight = weights[indices[i]];
+			a += (1.0f - weight) * (1.0f - weight);
+			b += (1.0f - weight) * weight;
+			c += weight * weight;
+			for (int channel = 0; channel < channelCount; ++channel) {
+				x[channel] += (1.0f - weight) * texels[channel][i];
+				y[channel] += weight * texels[channel][i];
+			}
+		}
+
+		const float determinant = a * c - b * b;
+		if (std::fabs(determinant) < 1e-6f) return;
+		for (int channel = 0; channel < channelCount; ++channel) {
+			endpoint0[channel] = std::min(255.0f, std::max(0.0f, (c * x[channel] - b * y[channel]) / determinant));
+			endpoint1[channel] = std::min(255.0f, std::max(0.0f, (a * y[channel] - b * x[channel]) / determinant));
+		}
+	}
+
+	int refinementPasses(const BlockQuality quality) {
+		return quality == BlockQuality::High ? 3 : quality == BlockQuality::Normal ? 1 : 0;
+	}
+
+	unsigned short packRgb565(const float color[4]) {
+		const unsigned red = static_cast<unsigned>(color[0] * 31.0f / 255.0f + 0.5f);
+		const unsigned green = static_cast<unsigned>(color[1] * 63.0f / 255.0f + 0.5f);
+		const unsigned blue = static_cast<unsigned>(color[2] * 31.0f / 255.0f + 0.5f);
+		return static_cast<unsigned short>((red << 11) | (green << 5) | blue);
+	}
+
+	void unpackRgb565(const unsigned short packed, float color[4]) {
+		const unsigned red = (packed >> 11) & 31u;
+		const unsigned green = (packed >> 5) & 63u;
+		const unsigned blue = packed & 31u;
+		color[0] = static_cast<float>((red << 3) | (red >> 2));
+		color[1] = static_cast<float>((green << 2) | (green >> 4));
+		color[2] = static_cast<float>((blue << 3) | (blue >> 2));
+		color[3] = 255.0f;
+	}
+
+	void bc1Palette(const unsigned short color0, const unsigned short color1, const bool fourColor, float palette[4][4]) {
+		unpackRgb565(color0, palette[0]);
+		unpackRgb565(color1, palette[1]);
+		for (int c = 0; c < 4; ++c) {
+			if (fourColor) {
+				palette[2][c] = std::floor((2.0f * palette[0][c] + palette[1][c] + 1.0f) / 3.0f);
+				palette[3][c] = std::floor((palette[0][c] + 2.0f * palette[1][c] + 1.0f) / 3.0f);
+			} else {
+				palette[2][c] = std::floor((palette[0][c] + palette[1][c]) / 2.0f);
+				palette[3][c] = 0.0f;
+			}
+		}
+	}
+
+	void encodeBC1(const BlockTexels& texels, const BlockQuality quality, unsigned char* output) {
+		const float WEIGHTS[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+		float endpoint0[4], endpoint1[4];
+		findEndpoints(texels, 3, quality != BlockQuality::Fast, endpoint0, endpoint1);
+
+		float bestError = FLT_MAX;
+		unsigned short bestColor0 = 0, bestColor1 = 0;
+		unsigned char bestIndices[16] = {};
+		for (int pass = 0; pass <= refinementPasses(quality); ++pass) {
+			unsigned short color0 = packRgb565(endpoint0);
+			unsigned short color1 = packRgb565(endpoint1);
+			if (color0 < color1) {
+				std::swap(color0, color1);
+				for (int c = 0; c < 3; ++c) std::swap(endpoint0[c], endpoint1[c]);
+			}
+
+			float palette[4][4];
+			unsigned char indices[16];
+			bc1Palette(color0, color1, true, palette);
+			const float error = fitIndices(texels, 0, 3, palette, color0 == color1 ? 1 : 4, indices);
+			if (error < bestError) {
+				bestError = error;
+				bestColor0 = color0;
+				bestColor1 = color1;
+				std::copy(indices, indices + 16, bestIndices);
+			}
+			if (color0 == color1) break;
+			refineEndpoints(texels, 3, indices, WEIGHTS, endpoint0, endpoint1);
+		}
+
+		unsigned indexBits = 0;
+		for (int i = 0; i < 16; ++i) indexBits |= static_cast<unsigned>(bestIndices[i]) << (i * 2);
+		output[0] = static_cast<unsigned char>(bestColor0 & 0xFF);
+		output[1] = static_cast<unsigned char>(bestColor0 >> 8);
+		output[2] = static_cast<unsigned char>(bestColor1 & 0xFF);
+		output[3] = static_cast<unsigned char>(bestColor1 >> 8);
+		for (int i = 0; i < 4; ++i) output[4 + i] = static_cast<unsigned char>((indexBits >> (i * 8)) & 0xFF);
+	}
+
+	void bc4Palette(const int value0, const int value1, float palette[8][4]) {
+		palette[0][0] = static_cast<float>(value0);
+		palette[1][0] = static_cast<float>(value1);
+		if (value0 > value1) {
+			for (int i = 1; i < 7; ++i) palette[i + 1][0] = static_cast<float>(((7 - i) * value0 + i * value1 + 3) / 7);
+		} else {
+			for (int i = 1; i < 5; ++i) palette[i + 1][0] = static_cast<float>(((5 - i) * value0 + i * value1 + 2) / 5);
+			palette[6][0] = 0.0f;
+			palette[7][0] = 255.0f;
+		}
+	}
+
+	// Eight-value mode spans the block's range; six-value mode (value0 <= value1) keeps explicit 0 and 255
+	// entries, which wins when a few texels sit at the extremes.
+	void encodeBC4(const BlockTexels& texels, const int channel, const BlockQuality quality, unsigned char* output) {
+		float minimum = 255.0f, maximum = 0.0f;
+		float innerMinimum = 255.0f, innerMaximum = 0.0f;
+		for (int i = 0; i < 16; ++i) {
+			const float value = texels[channel][i];
+			minimum = std::min(minimum, value);
+			maximum = std::max(maximum, value);
+			if (value > 0.0f && value < 255.0f) {
+				innerMinimum = std::min(innerMinimum, value);
+				innerMaximum = std::max(innerMaximum, value);
+			}
+		}
+
+		float bestError = FLT_MAX;
+		int bestValue0 = 0, bestValue1 = 0;
+		unsigned char bestIndices[16] = {};
+		const auto tryEndpoints = [&](const int value0, const int value1) {
+			float palette[8][4];
+			unsigned char indices[16];
+			bc4Palette(value0, value1, palette);
+			const float error = fitIndices(texels, channel, 1, palette, value0 == value1 ? 1 : 8, indices);
+			if (error < bestError) {
+				bestError = error;
+				bestValue0 = value0;
+				bestValue1 = value1;
+				std::copy(indices, indices + 16, bestIndices);
+			}
+		};
+
+		const int high = static_cast<int>(maximum + 0.5f);
+		const int low = static_cast<int>(minimum + 0.5f);
+		tryEndpoints(high, low);
+		if (quality != BlockQuality::Fast && innerMinimum <= innerMaximum && (minimum == 0.0f || maximum == 255.0f)) {
+			tryEndpoints(static_cast<int>(innerMinimum + 0.5f), static_cast<int>(innerMaximum + 0.5f));
+		}
+		if (quality == BlockQuality::High && high > low) {
+			for (int shrinkHigh = 0; shrinkHigh < 4; ++shrinkHigh) {
+				for (int shrinkLow = 0; shrinkLow < 4; ++shrinkLow) {
+					if (high - shrinkHigh > low + shrinkLow) tryEndpoints(high - shrinkHigh, low + shrinkLow);
+				}
+			}
+		}
+
+		output[0] = static_cast<unsigned char>(bestValue0);
+		output[1] = static_cast<unsigned char>(bestValue1);
+		unsigned long long indexBits = 0;
+		for (int i = 0; i < 16; ++i) indexBits |= static_cast<unsigned long long>(bestIndices[i]) << (i * 3);
+		for (int i = 0; i < 6; ++i) output[2 + i] = static_cast<unsigned char>((indexBits >> (i * 8)) & 0xFF);
+	}
+
+	// Mode 6 only: one RGBA subset, 7-bit endpoints plus a p-bit each, 4-bit indices.
+	void encodeBC7(const BlockTexels& texels, const BlockQuality quality, unsigned char* output) {
+		float weights[16];
+		for (int i = 0; i < 16; ++i) weights[i] = BC7_WEIGHTS[i] / 64.0f;
+
+		float endpoint0[4], endpoint1[4];
+		findEndpoints(texels, 4, quality != BlockQuality::Fast, endpoint0, endpoint1);
+
+		float bestError = FLT_MAX;
+		int bestQuantized[2][4] = {};
+		int bestPBits[2] = {};
+		unsigned char bestIndices[16] = {};
+		for (int pass = 0; pass <= refinementPasses(quality); ++pass) {
+			unsigned char passIndices[16] = {};
+			float passError = FLT_MAX;
+			for (int pBitCombination = 0; pBitCombination < 4; ++pBitCombination) {
+				const int pBits[2] = { pBitCombination & 1, pBitCombination >> 1 };
+				if (quality == BlockQuality::Fast && pBits[0] != pBits[1]) continue;
+
+				int quantized[2][4];
+				int expanded[2][4];
+				for (int c = 0; c < 4; ++c) {
+					quantized[0][c] = std::min(127, std::max(0, static_cast<int>((endpoint0[c] - pBits[0]) / 2.0f + 0.5f)));
+					quantized[1][c] = std::min(127, std::max(0, static_cast<int>((endpoint1[c] - pBits[1]) / 2.0f + 0.5f)));
+					expanded[0][c] = (quantized[0][c] << 1) | pBits[0];
+					expanded[1][c] = (quantized[1][c] << 1) | pBits[1];
+				}
+
+				float palette[16][4];
+				for (int i = 0; i < 16; ++i) {
+					for (int c = 0; c < 4; ++c) palette[i][c] = static_cast<float>(((64 - BC7_WEIGHTS[i]) * expanded[0][c] + BC7_WEIGHTS[i] * expanded[1][c] + 32) >> 6);
+				}
+				unsigned char indices[16];
+				const float error = fitIndices(texels, 0, 4, palette, 16, indices);
+				if (error < passError) {
+					passError = error;
+					std::copy(indices, indices + 16, passIndices);
+				}
+				if (error < bestError) {
+					bestError = error;
+					std::copy(&quantized[0][0], &quantized[0][0] + 8, &bestQuantized[0][0]);
+					bestPBits[0] = pBits[0];
+					bestPBits[1] = pBits[1];
+					std::copy(indices, indices + 16, bestIndices);
+				}
+			}
+			refineEndpoints(texels, 4, passIndices, weights, endpoint0, endpoint1);
+		}
+
+		if (bestIndices[0] & 8) {
+			for (int c = 0; c < 4; ++c) std::swap(bestQuantized[0][c], bestQuantized[1][c]);
+			std::swap(bestPBits[0], bestPBits[1]);
+			for (int i = 0; i < 16; ++i) bestIndices[i] = static_cast<unsigned char>(15 - bestIndices[i]);
+		}
+
+		std::fill(output, output + 16, 0);
+		BitWriter writer = { output, 0 };
+		writer.write(1u << 6, 7);
+		for (int c = 0; c < 4; ++c) {
+			writer.write(bestQuantized[0][c], 7);
+			writer.write(bestQuantized[1][c], 7);
+		}
+		writer.write(bestPBits[0], 1);
+		writer.write(bestPBits[1], 1);
+		writer.write(bestIndices[0], 3);
+		for (int i = 1; i < 16; ++i) writer.write(bestIndices[i], 4);
+	}
+
+	void encodeBlock(const unsigned char* pixels, const int width, const int height, const int channels, const int blockX, const int blockY, const BlockFormat format, const BlockQuality quality, unsigned char* output) {
+		BlockTexels texels;
+		const bool raw = format == BlockFormat::BC4 || format == BlockFormat::BC5;
+		fetchBlock(pixels, width, height, channels, blockX, blockY, raw, texels);
+
+		switch (format) {
+		case BlockFormat::BC1:
+			encodeBC1(texels, quality, output);
+			break;
+		case BlockFormat::BC3:
+			encodeBC4(texels, 3, quality, output);
+			encodeBC1(texels, quality, output + 8);
+			break;
+		case BlockFormat::BC4:
+			encodeBC4(texels, 0, quality, output);
+			break;
+		case BlockFormat::BC5:
+			encodeBC4(texels, 0, quality, output);
+			encodeBC4(texels, 1, quality, output + 8);
+			break;
+		case BlockFormat::BC7:
+			encodeBC7(texels, quality, output);
+			break;
+		}
+	}
+
+	void decodeBC1(const unsigned char* block, const bool alwaysFourColor, unsigned char texels[16][4]) {
+		const unsigned short color0 = static_cast<unsigned short>(block[0] | (block[1] << 8));
+		const unsigned short color1 = static_cast<unsigned short>(block[2] | (block[3] << 8));
+		float palette[4][4];
+		bc1Palette(color0, color1, alwaysFourColor || color0 > color1, palette);
+		const unsigned indexBits = block[4] | (block[5] << 8) | (block[6] << 16) | (static_cast<unsigned>(block[7]) << 24);
+		for (int i = 0; i < 16; ++i) {
+			const unsigned index = (indexBits >> (i * 2)) & 3u;
+			for (int c = 0; c < 3; ++c) texels[i][c] = static_cast<unsigned char>(palette[index][c]);
+			texels[i][3] = (!alwaysFourColor && color0 <= color1 && index == 3) ? 0 : 255;
+		}
+	}
+
+	void decodeBC4(const unsigned char* block, unsigned char texels[16][4], const int channel) {
+		float palette[8][4];
+		bc4Palette(block[0], block[1], palette);
+		unsigned long long indexBits = 0;
+		for (int i = 0; i < 6; ++i) indexBits |= static_cast<unsigned long long>(block[2 + i]) << (i * 8);
+		for (int i = 0; i < 16; ++i) texels[i][channel] = static_cast<unsigned char>(palette[(indexBits >> (i * 3)) & 7u][0]);
+	}
+
+	void decodeBC7(const unsigned char* block, unsigned char texels[16][4]) {
+		BitReader reader = { block, 0 };
+		if (reader.read(7) != (1u << 6)) {
+			for (int i = 0; i < 16; ++i) texels[i][0] = texels[i][1] = texels[i][2] = texels[i][3] = 0;
+			return;
+		}
+
+		int endpoints[2][4];
+		for (int c = 0; c < 4; ++c) {
+			endpoints[0][c] = static_cast<int>(reader.read(7)) << 1;
+			endpoints[1][c] = static_cast<int>(reader.read(7)) << 1;
+		}
+		const int pBit0 = static_cast<int>(reader.read(1));
+		const int pBit1 = static_cast<int>(reader.read(1));
+		for (int c = 0; c < 4; ++c) {
+			endpoints[0][c] |= pBit0;
+			endpoints[1][c] |= pBit1;
+		}
+		for (int i = 0; i < 16; ++i) {
+			const int weight = BC7_WEIGHTS[reader.read(i == 0 ? 3 : 4)];
+			for (int c = 0; c < 4; ++c) texels[i][c] = static_cast<unsigned char>(((64 - weight) * endpoints[0][c] + weight * endpoints[1][c] + 32) >> 6);
+		}
+	}
+}
+
+std::size_t blockBytes(const BlockFormat format) {
+	return (format == BlockFormat::BC1 || format == BlockFormat::BC4) ? 8 : 16;
+}
+
+std::size_t compressedImageSize(const BlockFormat format, const int width, const int height) {
+	return static_cast<std::size_t>((width + 3) / 4) * ((height + 3) / 4) * blockBytes(format);
+}
+
+unsigned blockFormatGLInternalFormat(const BlockFormat format) {
+	switch (format) {
+	case BlockFormat::BC1: return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+	case BlockFormat::BC3: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+	case BlockFormat::BC4: return GL_COMPRESSED_RED_RGTC1;
+	case BlockFormat::BC5: return GL_COMPRESSED_RG_RGTC2;
+	case BlockFormat::BC7: return GL_COMPRESSED_RGBA_BPTC_UNORM;
+	}
+	return 0;
+}
+
+bool isBlockFormatSupported(const BlockFormat format) {
+	switch (format) {
+	case BlockFormat::BC1:
+	case BlockFormat::BC3:
+		return GLAD_GL_EXT_texture_compression_s3tc != 0;
+	case BlockFormat::BC4:
+	case BlockFormat::BC5:
+		return true;
+	case BlockFormat::BC7:
+		return GLAD_GL_ARB_texture_compression_bptc != 0;
+	}
+	return false;
+}
+
+const char* blockFormatName(const BlockFormat format) {
+	switch (format) {
+	case BlockFormat::BC1: return "BC1";
+	case BlockFormat::BC3: return "BC3";
+	case BlockFormat::BC4: return "BC4";
+	case BlockFormat::BC5: return "BC5";
+	case BlockFormat::BC7: return "BC7";
+	}
+	return "unknown";
+}
+
+BlockFormat chooseBlockFormat(const unsigned char* pixels, const int width, const int height, const int channels, const bool isNormalMap, const bool preferBC7) {
+	if (channels == 1) return BlockFormat::BC4;
+	if (isNormalMap) return BlockFormat::BC5;
+
+	bool hasAlpha = false;
+	if (channels == 2 || channels == 4) {
+		const std::size_t texelCount = static_cast<std::size_t>(width) * height;
+		for (std::size_t i = 0; i < texelCount && !hasAlpha; ++i) hasAlpha = pixels[i * channels + channels - 1] != 255;
+	}
+	if (preferBC7) return BlockFormat::BC7;
+	return hasAlpha ? BlockFormat::BC3 : BlockFormat::BC1;
+}
+
+void compressImage(const unsigned char* pixels, const int width, const int height, const int channels, const BlockFormat format, const BlockQuality quality, unsigned threadCount, std::vector<unsigned char>& output) {
+	const int blocksWide = (width + 3) / 4;
+	const int blocksHigh = (height + 3) / 4;
+	const std::size_t bytesPerBlock = blockBytes(format);
+	output.assign(compressedImageSize(format, width, height), 0);
+
+	if (threadCount == 0) threadCount = std::max(1u, std::thread::hardware_concurrency());
+	threadCount = std::min(threadCount, static_cast<unsigned>(blocksHigh));
+
+	const auto encodeRows = [&](const int firstRow, const int lastRow) {
+		for (int blockY = firstRow; blockY < lastRow; ++blockY) {
+			for (int blockX = 0; blockX < blocksWide; ++blockX) {
+				encodeBlock(pixels, width, height, channels, blockX, blockY, format, quality, &output[(static_cast<std::size_t>(blockY) * blocksWide + blockX) * bytesPerBlock]);
+			}
+		}
+	};
+
+	std::vector<std::thread> threads;
+	for (unsigned t = 1; t < threadCount; ++t) threads.emplace_back(encodeRows, blocksHigh * t / threadCount, blocksHigh * (t + 1) / threadCount);
+	encodeRows(0, blocksHigh / std::max(1u, threadCount));
+	for (std::thread& thread : threads) thread.join();
+}
+
+void decompressImage(const unsigned char* blocks, const int width, const int height, const BlockFormat format, std::vector<unsigned char>& rgbaPixels) {
+	const int blocksWide = (width + 3) / 4;
+	const int blocksHigh = (height + 3) / 4;
+	const std::size_t bytesPerBlock = blockBytes(format);
+	rgbaPixels.assign(static_cast<std::size_t>(width) * height * 4, 0);
+
+	for (int blockY = 0; blockY < blocksHigh; ++blockY) {
+		for (int blockX = 0; blockX < blocksWide; ++blockX) {
+			const unsigned char* block = blocks + (static_cast<std::size_t>(blockY) * blocksWide + blockX) * bytesPerBlock;
+			unsigned char texels[16][4] = {};
+			switch (format) {
+			case BlockFormat::BC1:
+				decodeBC1(block, false, texels);
+				break;
+			case BlockFormat::BC3:
+				decodeBC1(block + 8, true, texels);
+				decodeBC4(block, texels, 3);
+				break;
+			case BlockFormat::BC4:
+				decodeBC4(block, texels, 0);
+				break;
+			case BlockFormat::BC5:
+				decodeBC4(block, texels, 0);
+				decodeBC4(block + 8, texels, 1);
+				break;
+			case BlockFormat::BC7:
+				decodeBC7(block, texels);
+				break;
+			}
+
+			for (int y = 0; y < 4 && blockY * 4 + y < height; ++y) {
+				for (int x = 0; x < 4 && blockX * 4 + x < width; ++x) {
+					unsigned char* pixel = &rgbaPixels[(static_cast<std::size_t>(blockY * 4 + y) * width + blockX * 4 + x) * 4];
+					std::copy(texels[y * 4 + x], texels[y * 4 + x] + 4, pixel);
+				}
+			}
+		}
+	}
+}
+
+double blockCompressionPsnr(const unsigned char* pixels, const int width, const int height, const int channels, const BlockFormat format, const std::vector<unsigned char>& rgbaPixels) {
+	const bool raw = format == BlockFormat::BC4 || format == BlockFormat::BC5;
+	const int comparedChannels = (format == BlockFormat::BC4) ? 1 : (format == BlockFormat::BC5) ? 2 : (format == BlockFormat::BC1 || (channels != 2 && channels != 4)) ? 3 : 4;
+
+	double squaredError = 0.0;
+	for (std::size_t i = 0, count = static_cast<std::size_t>(width) * height; i < count; ++i) {
+		const unsigned char* source = pixels + i * channels;
+		for (int c = 0; c < comparedChannels; ++c) {
+			int original;
+			if (raw) original = (c < channels) ? source[c] : 0;
+			else if (channels >= 3) original = (c < 3) ? source[c] : (channels == 4 ? source[3] : 255);
+			else original = (c < 3) ? source[0] : (channels == 2 ? source[1] : 255);
+			const double difference = original - rgbaPixels[i * 4 + c];
+			squaredError += difference * difference;
+		}
+	}
+
+	const double meanSquaredError = squaredError / (static_cast<double>(width) * height * comparedChannels);
+	return meanSquaredError > 0.0 ? 10.0 * std::log10(255.0 * 255.0 / meanSquaredError) : 99.0;
+}
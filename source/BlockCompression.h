@@ -0,0 +1,36 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Values match CookedPayload so cooked files can store the format directly.
+enum class BlockFormat : std::uint32_t {
+	BC1 = 1,
+	BC3 = 2,
+	BC4 = 3,
+	BC5 = 4,
+	BC7 = 5
+};
+
+enum class BlockQuality {
+	Fast,
+	Normal,
+	High
+};
+
+std::size_t blockBytes(const BlockFormat format);
+std::size_t compressedImageSize(const BlockFormat format, const int width, const int height);
+unsigned blockFormatGLInternalFormat(const BlockFormat format);
+bool isBlockFormatSupported(const BlockFormat format);
+const char* blockFormatName(const BlockFormat format);
+
+// BC4 for one channel, BC5 for two-channel data or normal maps, BC3 (or BC7 when preferred) when any
+// texel is not fully opaque, BC1 otherwise.
+BlockFormat chooseBlockFormat(const unsigned char* pixels, const int width, const int height, const int channels, const bool isNormalMap, const bool preferBC7);
+
+// Encodes an 8-bit image with 1-4 channels; rows of blocks are spread over threadCount threads (0 = all cores).
+void compressImage(const unsigned char* pixels, const int width, const int height, const int channels, const BlockFormat format, const BlockQuality quality, unsigned threadCount, std::vector<unsigned char>& output);
+void decompressImage(const unsigned char* blocks, const int width, const int height, const BlockFormat format, std::vector<unsigned char>& rgbaPixels);
+
+// PSNR over the channels the format actually stores, comparing against the RGBA8 decode.
+double blockCompressionPsnr(const unsigned char* pixels, const int width, const int height, const int channels, const BlockFormat format, const std::vector<unsigned char>& rgbaPixels);
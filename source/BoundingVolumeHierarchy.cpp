@@ -0,0 +1,296 @@
+#include "BoundingVolumeHierarchy.h"
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/gtx/intersect.hpp>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+	const int BIN_COUNT = 16;
+	const std::uint32_t MIN_LEAF_OBJECTS = 2;
+	const std::uint32_t MAX_LEAF_OBJECTS = 8;
+	// Past this depth splits just halve the range, which keeps the traversal stacks bounded.
+	const int MAX_SAH_DEPTH = 48;
+	const int STACK_SIZE = 128;
+	const float TRAVERSAL_COST = 1.0f;
+
+	struct Box {
+		glm::vec3 minimum;
+		glm::vec3 maximum;
+
+		Box() : minimum(std::numeric_limits<float>::max()), maximum(-std::numeric_limits<float>::max()) {}
+
+		void grow(const glm::vec3& pointMinimum, const glm::vec3& pointMaximum) {
+			minimum = glm::min(minimum, pointMinimum);
+			maximum = glm::max(maximum, pointMaximum);
+		}
+
+		float area() const {
+			const glm::vec3 size = glm::max(maximum - minimum, glm::vec3(0.0f));
+			return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+		}
+	};
+
+	glm::vec3 objectMinimum(const ObjectBounds& bounds, const std::uint32_t object) {
+		return glm::vec3(bounds.centerX[object] - bounds.extentX[object], bounds.centerY[object] - bounds.extentY[object], bounds.centerZ[object] - bounds.extentZ[object]);
+	}
+
+	glm::vec3 objectMaximum(const ObjectBounds& bounds, const std::uint32_t object) {
+		return glm::vec3(bounds.centerX[object] + bounds.extentX[object], bounds.centerY[object] + bounds.extentY[object], bounds.centerZ[object] + bounds.extentZ[object]);
+	}
+
+	float nodeArea(const BvhNode& node) {
+		Box box;
+		box.grow(node.boundsMin, node.boundsMax);
+		return box.area();
+	}
+
+	// Entry distance of the ray into the box, or infinity if it misses or the box is beyond limit.
+	float intersectBox(const glm::vec3& origin, const glm::vec3& inverseDirection, const BvhNode& node, const float limit) {
+		const glm::vec3 t0 = (node.boundsMin - origin) * inverseDirection;
+		const glm::vec3 t1 = (node.boundsMax - origin) * inverseDirection;
+		const glm::vec3 entries = glm::min(t0, t1), exits = glm::max(t0, t1);
+		const float entry = std::max(std::max(entries.x, entries.y), std::max(entries.z, 0.0f));
+		const float exit = std::min(std::min(exits.x, exits.y), std::min(exits.z, limit));
+		return (entry <= exit) ? entry : std::numeric_limits<float>::infinity();
+	}
+
+	// The ray goes into object space unnormalized, so hit distances stay in world-space ray units.
+	bool intersectObject(const glm::vec3& origin, const glm::vec3& direction, const IndexedMesh& mesh, const glm::mat4& model, const std::uint32_t object, RayHit& hit) {
+		const glm::mat4 inverseModel = glm::inverse(model);
+		const glm::vec3 localOrigin(inverseModel * glm::vec4(origin, 1.0f));
+		const glm::vec3 localDirection(inverseModel * glm::vec4(direction, 0.0f));
+		const int stride = mesh.floatsPerVertex();
+		bool found = false;
+		for (std::size_t i = 0; i + 2 < mesh.indices.size(); i += 3) {
+			const float* a = &mesh.vertices[mesh.indices[i] * stride];
+			const float* b = &mesh.vertices[mesh.indices[i + 1] * stride];
+			const float* c = &mesh.vertices[mesh.indices[i + 2] * stride];
+			glm::vec2 barycentric;
+			float distance;
+			if (glm::intersectRayTriangle(localOrigin, localDirection, glm::vec3(a[0], a[1], a[2]), glm::vec3(b[0], b[1], b[2]), glm::vec3(c[0], c[1], c[2]), barycentric, distance)
+				&& distance >= 0.0f && distance < hit.distance) {
+				hit.object = object;
+				hit.triangle = static_cast<std::uint32_t>(i / 3);
+				hit.distance = distance;
+				hit.barycentric = barycentric;
+				found = true;
+			}
+		}
+		return found;
+	}
+
+	bool boxInsidePlane(const glm::vec4& plane, const ObjectBounds& bounds, const std::uint32_t object) {
+		const float reach = std::abs(plane.x) * bounds.extentX[object] + std::abs(plane.y) * bounds.extentY[object] + std::abs(plane.z) * bounds.extentZ[object];
+		return plane.x * bounds.centerX[object] + plane.y * bounds.centerY[object] + plane.z * bounds.centerZ[object] + plane.w + reach >= 0.0f;
+	}
+}
+
+void BoundingVolumeHierarchy::build(const ObjectBounds& bounds) {
+	const std::uint32_t objectCount = static_cast<std::uint32_t>(bounds.size());
+	nodeList.clear();
+	objectIndices.resize(objectCount);
+	centroids.resize(objectCount);
+	for (std::uint32_t i = 0; i < objectCount; ++i) {
+		objectIndices[i] = i;
+		centroids[i] = glm::vec3(bounds.centerX[i], bounds.centerY[i], bounds.centerZ[i]);
+	}
+	if (objectCount == 0) return;
+	nodeList.reserve(2 * objectCount / MIN_LEAF_OBJECTS + 1);
+	buildNode(bounds, 0, objectCount, 0);
+}
+
+std::uint32_t BoundingVolumeHierarchy::buildNode(const ObjectBounds& bounds, const std::uint32_t first, const std::uint32_t count, const int depth) {
+	const std::uint32_t index = static_cast<std::uint32_t>(nodeList.size());
+	nodeList.push_back(BvhNode());
+
+	Box nodeBox, centroidBox;
+	for (std::uint32_t i = first; i < first + count; ++i) {
+		const std::uint32_t object = objectIndices[i];
+		nodeBox.grow(objectMinimum(bounds, object), objectMaximum(bounds, object));
+		centroidBox.grow(centroids[object], centroids[object]);
+	}
+	nodeList[index].boundsMin = nodeBox.minimum;
+	nodeList[index].boundsMax = nodeBox.maximum;
+	nodeList[index].offset = first;
+	nodeList[index].objectCount = count;
+	if (count <= MIN_LEAF_OBJECTS) return index;
+
+	// Bin centroids along each axis and sweep the bins from both ends for the cheapest split.
+	int bestAxis = -1, bestBin = 0;
+	float bestCost = std::numeric_limits<float>::max();
+	const glm::vec3 centroidExtent = centroidBox.maximum - centroidBox.minimum;
+	for (int axis = 0; axis < 3 && depth < MAX_SAH_DEPTH; ++axis) {
+		if (centroidExtent[axis] <= 0.0f) continue;
+		const float binScale = BIN_COUNT / centroidExtent[axis];
+		Box binBoxes[BIN_COUNT];
+		std::uint32_t binCounts[BIN_COUNT] = {};
+		for (std::uint32_t i = first; i < first + count; ++i) {
+			const std::uint32_t object = objectIndices[i];
+			const int bin = std::min(BIN_COUNT - 1, static_cast<int>((centroids[object][axis] - centroidBox.minimum[axis]) * binScale));
+			binBoxes[bin].grow(objectMinimum(bounds, object), objectMaximum(bounds, object));
+			++binCounts[bin];
+		}
+
+		float rightAreas[BIN_COUNT];
+		std::uint32_t rightCounts[BIN_COUNT];
+		Box rightBox;
+		std::uint32_t rightCount = 0;
+		for (int bin = BIN_COUNT - 1; bin > 0; --bin) {
+			rightBox.grow(binBoxes[bin].minimum, binBoxes[bin].maximum);
+			rightCount += binCounts[bin];
+			rightAreas[bin] = rightBox.area();
+			rightCounts[bin] = rightCount;
+		}
+		Box leftBox;
+		std::uint32_t leftCount = 0;
+		for (int bin = 1; bin < BIN_COUNT; ++bin) {
+			leftBox.grow(binBoxes[bin - 1].minimum, binBoxes[bin - 1].maximum);
+			leftCount += binCounts[bin - 1];
+			if (leftCount == 0 || rightCounts[bin] == 0) continue;
+			const float cost = leftBox.area() * leftCount + rightAreas[bin] * rightCounts[bin];
+			if (cost < bestCost) {
+				bestCost = cost;
+				bestAxis = axis;
+				bestBin = bin;
+			}
+		}
+	}
+
+	const float leafCost = nodeBox.area() * count;
+	const float splitCost = TRAVERSAL_COST * nodeBox.area() + bestCost;
+	if (count <= MAX_LEAF_OBJECTS && (bestAxis < 0 || splitCost >= leafCost)) return index;
+
+	std::uint32_t leftCount = count / 2;
+	if (bestAxis >= 0) {
+		const float binScale = BIN_COUNT / centroidExtent[bestAxis];
+		const float axisMinimum = centroidBox.minimum[bestAxis];
+		const std::vector<std::uint32_t>::iterator begin = objectIndices.begin() + first;
+		leftCount = static_cast<std::uint32_t>(std::partition(begin, begin + count, [&](const std::uint32_t object) {
+			return std::min(BIN_COUNT - 1, static_cast<int>((centroids[object][bestAxis] - axisMinimum) * binScale)) < bestBin;
+		}) - begin);
+	}
+
+	buildNode(bounds, first, leftCount, depth + 1);
+	const std::uint32_t right = buildNode(bounds, first + leftCount, count - leftCount, depth + 1);
+	nodeList[index].offset = right;
+	nodeList[index].objectCount = 0;
+	return index;
+}
+
+// Children always come after their parent, so one backwards pass updates every box bottom up.
+void BoundingVolumeHierarchy::refit(const ObjectBounds& bounds) {
+	for (std::size_t i = nodeList.size(); i-- > 0;) {
+		BvhNode& node = nodeList[i];
+		Box box;
+		if (node.objectCount > 0) {
+			for (std::uint32_t j = node.offset; j < node.offset + node.objectCount; ++j) box.grow(objectMinimum(bounds, objectIndices[j]), objectMaximum(bounds, objectIndices[j]));
+		}
+		else {
+			box.grow(nodeList[i + 1].boundsMin, nodeList[i + 1].boundsMax);
+			box.grow(nodeList[node.offset].boundsMin, nodeList[node.offset].boundsMax);
+		}
+		node.boundsMin = box.minimum;
+		node.boundsMax = box.maximum;
+	}
+}
+
+// Each node carries the planes its parent still straddles; a node entirely inside all of them
+// hands over its whole subtree, which is one contiguous run of the object index list.
+void BoundingVolumeHierarchy::queryFrustum(const Frustum& frustum, const ObjectBounds& bounds, std::vector<std::uint32_t>& visible) const {
+	visible.clear();
+	if (nodeList.empty()) return;
+
+	struct Entry {
+		std::uint32_t node;
+		std::uint32_t planeMask;
+	};
+	Entry stack[STACK_SIZE];
+	int stackSize = 0;
+	stack[stackSize++] = { 0, 0x3F };
+	while (stackSize > 0) {
+		const Entry entry = stack[--stackSize];
+		const BvhNode& node = nodeList[entry.node];
+		const glm::vec3 center = (node.boundsMin + node.boundsMax) * 0.5f;
+		const glm::vec3 extents = (node.boundsMax - node.boundsMin) * 0.5f;
+		std::uint32_t planeMask = entry.planeMask;
+		bool outside = false;
+		for (int p = 0; p < 6 && !outside; ++p) {
+			if (!(planeMask & (1u << p))) continue;
+			const glm::vec4& plane = frustum.planes[p];
+			const float distance = glm::dot(glm::vec3(plane), center) + plane.w;
+			const float reach = glm::dot(glm::abs(glm::vec3(plane)), extents);
+			if (distance + reach < 0.0f) outside = true;
+			else if (distance - reach >= 0.0f) planeMask &= ~(1u << p);
+		}
+		if (outside) continue;
+
+		if (planeMask == 0) {
+			std::uint32_t firstLeaf = entry.node, lastLeaf = entry.node;
+			while (nodeList[firstLeaf].objectCount == 0) ++firstLeaf;
+			while (nodeList[lastLeaf].objectCount == 0) lastLeaf = nodeList[lastLeaf].offset;
+			visible.insert(visible.end(), objectIndices.begin() + nodeList[firstLeaf].offset, objectIndices.begin() + nodeList[lastLeaf].offset + nodeList[lastLeaf].objectCount);
+		}
+		else if (node.objectCount > 0) {
+			for (std::uint32_t i = node.offset; i < node.offset + node.objectCount; ++i) {
+				const std::uint32_t object = objectIndices[i];
+				bool inside = true;
+				for (int p = 0; p < 6 && inside; ++p) inside = !(planeMask & (1u << p)) || boxInsidePlane(frustum.planes[p], bounds, object);
+				if (inside) visible.push_back(object);
+			}
+		}
+		else {
+			stack[stackSize++] = { node.offset, planeMask };
+			stack[stackSize++] = { entry.node + 1, planeMask };
+		}
+	}
+}
+
+bool BoundingVolumeHierarchy::intersectRay(const glm::vec3& origin, const glm::vec3& direction, const IndexedMesh& mesh, const glm::mat4* models, RayHit& hit) const {
+	hit.distance = std::numeric_limits<float>::infinity();
+	if (nodeList.empty()) return false;
+
+	const glm::vec3 inverseDirection = 1.0f / direction;
+	bool found = false;
+	std::uint32_t stack[STACK_SIZE];
+	int stackSize = 0;
+	if (intersectBox(origin, inverseDirection, nodeList[0], hit.distance) != std::numeric_limits<float>::infinity()) stack[stackSize++] = 0;
+	while (stackSize > 0) {
+		const BvhNode& node = nodeList[stack[--stackSize]];
+		if (node.objectCount > 0) {
+			for (std::uint32_t i = node.offset; i < node.offset + node.objectCount; ++i) found |= intersectObject(origin, direction, mesh, models[objectIndices[i]], objectIndices[i], hit);
+			continue;
+		}
+
+		// Visit the nearer child first so the closest hit so far prunes the farther one.
+		std::uint32_t nearChild = static_cast<std::uint32_t>(&node - nodeList.data()) + 1, farChild = node.offset;
+		float nearDistance = intersectBox(origin, inverseDirection, nodeList[nearChild], hit.distance);
+		float farDistance = intersectBox(origin, inverseDirection, nodeList[farChild], hit.distance);
+		if (farDistance < nearDistance) {
+			std::swap(nearChild, farChild);
+			std::swap(nearDistance, farDistance);
+		}
+		if (farDistance != std::numeric_limits<float>::infinity()) stack[stackSize++] = farChild;
+		if (nearDistance != std::numeric_limits<float>::infinity()) stack[stackSize++] = nearChild;
+	}
+	return found;
+}
+
+float BoundingVolumeHierarchy::cost() const {
+	if (nodeList.empty()) return 0.0f;
+	float total = 0.0f;
+	for (const BvhNode& node : nodeList) total += nodeArea(node) * (node.objectCount > 0 ? static_cast<float>(node.objectCount) : TRAVERSAL_COST);
+	const float rootArea = nodeArea(nodeList[0]);
+	return rootArea > 0.0f ? total / rootArea : 0.0f;
+}
+
+const std::vector<BvhNode>& BoundingVolumeHierarchy::nodes() const {
+	return nodeList;
+}
+
+bool intersectRayBruteForce(const glm::vec3& origin, const glm::vec3& direction, const IndexedMesh& mesh, const glm::mat4* models, const std::size_t objectCount, RayHit& hit) {
+	hit.distance = std::numeric_limits<float>::infinity();
+	bool found = false;
+	for (std::size_t i = 0; i < objectCount; ++i) found |= intersectObject(origin, direction, mesh, models[i], static_cast<std::uint32_t>(i), hit);
+	return found;
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include "FrustumCulling.h"
+#include "MeshBuilder.h"
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// 32 bytes, so two nodes share a cache line. Nodes are stored depth first: an interior node's left
+// child follows it directly and `offset` is its right child; a leaf's `offset` is its first entry in
+// the object index list.
+struct BvhNode {
+	glm::vec3 boundsMin;
+	std::uint32_t offset;
+	glm::vec3 boundsMax;
+	std::uint32_t objectCount;
+};
+
+// distance is the ray parameter, not a length: the hit is at origin + distance * direction.
+struct RayHit {
+	std::uint32_t object;
+	std::uint32_t triangle;
+	float distance;
+	glm::vec2 barycentric;
+};
+
+// Binned surface area heuristic build over ObjectBounds boxes. Objects that move keep the
+// topology and only have their boxes refitted; rebuild once the tree has drifted too far.
+class BoundingVolumeHierarchy {
+public:
+	void build(const ObjectBounds& bounds);
+	void refit(const ObjectBounds& bounds);
+
+	// Same result as cullBoxes, in tree order rather than index order.
+	void queryFrustum(const Frustum& frustum, const ObjectBounds& bounds, std::vector<std::uint32_t>& visible) const;
+	// Every object is an instance of mesh placed by models[object]; leaves test its triangles
+	// with glm::intersectRayTriangle in object space. Returns the closest hit in front of origin.
+	bool intersectRay(const glm::vec3& origin, const glm::vec3& direction, const IndexedMesh& mesh, const glm::mat4* models, RayHit& hit) const;
+
+	// Surface area heuristic cost of the current tree relative to the root's area.
+	float cost() const;
+	const std::vector<BvhNode>& nodes() const;
+
+private:
+	std::uint32_t buildNode(const ObjectBounds& bounds, const std::uint32_t first, const std::uint32_t count, const int depth);
+
+	std::vector<BvhNode> nodeList;
+	std::vector<std::uint32_t> objectIndices;
+	std::vector<glm::vec3> centroids;
+};
+
+// Closest hit over every object, for checking intersectRay.
+bool intersectRayBruteForce(const glm::vec3& origin, const glm::vec3& direction, const IndexedMesh& mesh, const glm::mat4* models, const std::size_t objectCount, RayHit& hit);
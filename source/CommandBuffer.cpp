@@ -0,0 +1,132 @@
+#include "CommandBuffer.h"
+#include "JobSystem.h"
+#include <glad/glad.h>
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+namespace {
+	const std::size_t INITIAL_ARENA_BYTES = 64 * 1024;
+}
+
+CommandBuffer::CommandBuffer() : used(0), commands(0) {}
+
+void CommandBuffer::reset() {
+	used = 0;
+	commands = 0;
+}
+
+// Every command is a multiple of four bytes, so each one starts suitably aligned for its fields.
+template <typename Command>
+Command& CommandBuffer::append(const CommandType type) {
+	static_assert(sizeof(Command) % 4 == 0, "commands must keep the arena 4-byte aligned");
+	if (used + sizeof(Command) > arena.size()) arena.resize(std::max(INITIAL_ARENA_BYTES, 2 * arena.size() + sizeof(Command)));
+	Command* command = new (&arena[used]) Command;
+	command->header.type = type;
+	command->header.size = static_cast<std::uint16_t>(sizeof(Command));
+	used += sizeof(Command);
+	++commands;
+	return *command;
+}
+
+void CommandBuffer::bindProgram(const unsigned program) {
+	append<BindProgramCommand>(CommandType::BindProgram).program = program;
+}
+
+void CommandBuffer::bindVertexArray(const unsigned vertexArray) {
+	append<BindVertexArrayCommand>(CommandType::BindVertexArray).vertexArray = vertexArray;
+}
+
+void CommandBuffer::bindTexture(const unsigned unit, const unsigned texture) {
+	BindTextureCommand& command = append<BindTextureCommand>(CommandType::BindTexture);
+	command.unit = unit;
+	command.texture = texture;
+}
+
+void CommandBuffer::setVec3(const int location, const glm::vec3& value) {
+	SetVec3Command& command = append<SetVec3Command>(CommandType::SetVec3);
+	command.location = location;
+	std::memcpy(command.value, &value[0], sizeof(command.value));
+}
+
+void CommandBuffer::setMat4(const int location, const glm::mat4& value) {
+	SetMat4Command& command = append<SetMat4Command>(CommandType::SetMat4);
+	command.location = location;
+	std::memcpy(command.value, &value[0][0], sizeof(command.value));
+}
+
+void CommandBuffer::drawElements(const unsigned mode, const int indexCount, const unsigned indexType, const int instanceCount) {
+	DrawElementsCommand& command = append<DrawElementsCommand>(CommandType::DrawElements);
+	command.mode = mode;
+	command.indexCount = indexCount;
+	command.indexType = indexType;
+	command.instanceCount = instanceCount;
+}
+
+void CommandBuffer::replay() const {
+	std::size_t offset = 0;
+	while (offset < used) {
+		const unsigned char* bytes = &arena[offset];
+		const CommandHeader& header = *reinterpret_cast<const CommandHeader*>(bytes);
+		switch (header.type) {
+		case CommandType::BindProgram:
+			glUseProgram(reinterpret_cast<const BindProgramCommand*>(bytes)->program);
+			break;
+		case CommandType::BindVertexArray:
+			glBindVertexArray(reinterpret_cast<const BindVertexArrayCommand*>(bytes)->vertexArray);
+			break;
+		case CommandType::BindTexture: {
+			const BindTextureCommand* command = reinterpret_cast<const BindTextureCommand*>(bytes);
+			glActiveTexture(GL_TEXTURE0 + command->unit);
+			glBindTexture(GL_TEXTURE_2D, command->texture);
+			break;
+		}
+		case CommandType::SetVec3: {
+			const SetVec3Command* command = reinterpret_cast<const SetVec3Command*>(bytes);
+			glUniform3fv(command->location, 1, command->value);
+			break;
+		}
+		case CommandType::SetMat4: {
+			const SetMat4Command* command = reinterpret_cast<const SetMat4Command*>(bytes);
+			glUniformMatrix4fv(command->location, 1, GL_FALSE, command->value);
+			break;
+		}
+		case CommandType::DrawElements: {
+			const DrawElementsCommand* command = reinterpret_cast<const DrawElementsCommand*>(bytes);
+			if (command->instanceCount > 0) glDrawElementsInstanced(command->mode, command->indexCount, command->indexType, NULL, command->instanceCount);
+			else glDrawElements(command->mode, command->indexCount, command->indexType, NULL);
+			break;
+		}
+		}
+		offset += header.size;
+	}
+}
+
+std::size_t CommandBuffer::commandCount() const {
+	return commands;
+}
+
+std::size_t CommandBuffer::byteSize() const {
+	return used;
+}
+
+void recordCommandBuffers(std::vector<CommandBuffer>& buffers, const std::size_t itemCount, JobSystem* jobSystem, const std::function<void(CommandBuffer&, const std::size_t, const std::size_t)>& record) {
+	const std::size_t bufferCount = buffers.size();
+	if (bufferCount == 0) return;
+	const std::size_t chunkSize = (itemCount + bufferCount - 1) / bufferCount;
+	const auto recordChunks = [&](const std::size_t first, const std::size_t last) {
+		for (std::size_t index = first; index < last; ++index) {
+			CommandBuffer& buffer = buffers[index];
+			buffer.reset();
+			const std::size_t begin = std::min(itemCount, index * chunkSize);
+			record(buffer, begin, std::min(itemCount, begin + chunkSize));
+		}
+	};
+
+	if (jobSystem) parallelFor(*jobSystem, bufferCount, recordChunks, 1);
+	else recordChunks(0, bufferCount);
+}
+
+void replayCommandBuffers(const std::vector<CommandBuffer>& buffers) {
+	for (const CommandBuffer& buffer : buffers) buffer.replay();
+}
@@ -0,0 +1,97 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+class JobSystem;
+
+enum class CommandType : std::uint16_t {
+	BindProgram,
+	BindVertexArray,
+	BindTexture,
+	SetVec3,
+	SetMat4,
+	DrawElements
+};
+
+// Every command starts with this header; size covers the header and payload, so replay can step
+// over commands it does not need to look inside.
+struct CommandHeader {
+	CommandType type;
+	std::uint16_t size;
+};
+
+struct BindProgramCommand {
+	CommandHeader header;
+	unsigned program;
+};
+
+struct BindVertexArrayCommand {
+	CommandHeader header;
+	unsigned vertexArray;
+};
+
+struct BindTextureCommand {
+	CommandHeader header;
+	unsigned unit;
+	unsigned texture;
+};
+
+struct SetVec3Command {
+	CommandHeader header;
+	int location;
+	float value[3];
+};
+
+struct SetMat4Command {
+	CommandHeader header;
+	int location;
+	float value[16];
+};
+
+// instanceCount 0 issues a plain glDrawElements.
+struct DrawElementsCommand {
+	CommandHeader header;
+	unsigned mode;
+	int indexCount;
+	unsigned indexType;
+	int instanceCount;
+};
+
+// GL calls encoded as plain structs into one linear arena, so any thread can record while only
+// the context thread replays. reset() rewinds the arena but keeps its memory, so a buffer that is
+// reused every frame stops allocating once it has seen its largest frame. Uniforms are recorded
+// by location (ShaderProgram::uniformLocation), which is safe to look up from any thread.
+class CommandBuffer {
+public:
+	CommandBuffer();
+
+	void reset();
+	void bindProgram(const unsigned program);
+	void bindVertexArray(const unsigned vertexArray);
+	void bindTexture(const unsigned unit, const unsigned texture);
+	void setVec3(const int location, const glm::vec3& value);
+	void setMat4(const int location, const glm::mat4& value);
+	void drawElements(const unsigned mode, const int indexCount, const unsigned indexType, const int instanceCount = 0);
+
+	// Must run on the thread that owns the GL context.
+	void replay() const;
+	std::size_t commandCount() const;
+	std::size_t byteSize() const;
+
+private:
+	template <typename Command>
+	Command& append(const CommandType type);
+
+	std::vector<unsigned char> arena;
+	std::size_t used;
+	std::size_t commands;
+};
+
+// Resets buffers and records items [0, itemCount) across them in contiguous ranges, one job per
+// buffer on jobSystem (or all on the calling thread without one), so replaying the buffers in
+// order issues the items in order.
+void recordCommandBuffers(std::vector<CommandBuffer>& buffers, const std::size_t itemCount, JobSystem* jobSystem, const std::function<void(CommandBuffer&, const std::size_t, const std::size_t)>& record);
+void replayCommandBuffers(const std::vector<CommandBuffer>& buffers);
@@ -0,0 +1,234 @@
+#include "CookedMesh.h"
+#include "MappedFile.h"
+#include "MeshImport.h"
+#include "MeshOptimizer.h"
+#include "VertexQuantization.h"
+#include <glad/glad.h>
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+namespace {
+	const char COOKED_MESH_MAGIC[4] = { 'C', 'M', 'S', 'H' };
+
+	std::uint64_t alignOffset(const std::uint64_t offset) {
+		return (offset + COOKED_MESH_ALIGNMENT - 1) / COOKED_MESH_ALIGNMENT * COOKED_MESH_ALIGNMENT;
+	}
+
+	// Compares by subtraction, so a corrupt offset near 2^64 cannot wrap around the file size.
+	bool sectionFits(const std::uint64_t offset, const std::uint64_t bytes, const std::uint64_t fileSize) {
+		return offset <= fileSize && bytes <= fileSize - offset;
+	}
+
+	template <typename Index>
+	bool indicesInRange(const Index* indices, const std::uint32_t indexCount, const std::uint32_t vertexCount) {
+		Index largest = 0;
+		for (std::uint32_t i = 0; i < indexCount; ++i) largest = std::max(largest, indices[i]);
+		return indexCount == 0 || largest < vertexCount;
+	}
+
+	void storeVec3(const glm::vec3& value, float* out) {
+		out[0] = value.x;
+		out[1] = value.y;
+		out[2] = value.z;
+	}
+
+	glm::vec3 vertexPosition(const IndexedMesh& mesh, const std::size_t vertex) {
+		const float* position = &mesh.vertices[vertex * mesh.floatsPerVertex()];
+		return glm::vec3(position[0], position[1], position[2]);
+	}
+}
+
+std::string cookedMeshPath(const char* sourcePath) {
+	std::filesystem::path path(sourcePath);
+	return (path.parent_path() / "cooked" / path.stem()).string() + ".cmesh";
+}
+
+bool cookMesh(const char* sourcePath, const char* outputPath) {
+	IndexedMesh mesh;
+	if (!importMesh(sourcePath, mesh, false)) return false;
+	optimizeMesh(mesh, false);
+	QuantizedMesh quantized;
+	if (mesh.vertices.empty() || !quantizeMesh(mesh, quantized, false)) {
+		std::cout << "There was an error cooking the mesh " << sourcePath << ':' << '\n' << "no position + texture coordinate triangles" << '\n';
+		return false;
+	}
+
+	CookedMeshHeader header;
+	std::memset(&header, 0, sizeof(header));
+	std::memcpy(header.magic, COOKED_MESH_MAGIC, sizeof(COOKED_MESH_MAGIC));
+	header.version = COOKED_MESH_VERSION;
+	header.vertexCount = static_cast<std::uint32_t>(quantized.vertices.size());
+	header.vertexStride = sizeof(QuantizedVertex);
+	header.indexCount = static_cast<std::uint32_t>(quantized.indices.size());
+	header.indexSize = mesh.fitsShortIndices() ? sizeof(std::uint16_t) : sizeof(std::uint32_t);
+	header.submeshCount = static_cast<std::uint32_t>(quantized.submeshes.size());
+	header.halfFloatTextureCoordinates = quantized.halfFloatTextureCoordinates ? 1 : 0;
+	storeVec3(quantized.positionScale, header.positionScale);
+	storeVec3(quantized.positionBias, header.positionBias);
+
+	// The sphere is centred on the box rather than fitted exactly; it only has to be conservative.
+	glm::vec3 minimum(vertexPosition(mesh, 0)), maximum(minimum);
+	for (std::size_t i = 1; i < mesh.vertexCount(); ++i) {
+		minimum = glm::min(minimum, vertexPosition(mesh, i));
+		maximum = glm::max(maximum, vertexPosition(mesh, i));
+	}
+	const glm::vec3 center = (minimum + maximum) * 0.5f;
+	float radiusSquared = 0.0f;
+	for (std::size_t i = 0; i < mesh.vertexCount(); ++i) {
+		const glm::vec3 offset = vertexPosition(mesh, i) - center;
+		radiusSquared = std::max(radiusSquared, glm::dot(offset, offset));
+	}
+	storeVec3(minimum, header.boundsMin);
+	storeVec3(maximum, header.boundsMax);
+	storeVec3(center, header.sphereCenter);
+	header.sphereRadius = std::sqrt(radiusSquared);
+
+	std::vector<CookedSubmesh> submeshes(header.submeshCount);
+	for (std::uint32_t s = 0; s < header.submeshCount; ++s) {
+		const MeshRange& range = quantized.submeshes[s];
+		glm::vec3 submeshMinimum(vertexPosition(mesh, mesh.indices[range.firstIndex])), submeshMaximum(submeshMinimum);
+		for (std::uint32_t i = range.firstIndex; i < range.firstIndex + range.indexCount; ++i) {
+			submeshMinimum = glm::min(submeshMinimum, vertexPosition(mesh, mesh.indices[i]));
+			submeshMaximum = glm::max(submeshMaximum, vertexPosition(mesh, mesh.indices[i]));
+		}
+		submeshes[s].firstIndex = range.firstIndex;
+		submeshes[s].indexCount = range.indexCount;
+		storeVec3(submeshMinimum, submeshes[s].boundsMin);
+		storeVec3(submeshMaximum, submeshes[s].boundsMax);
+	}
+
+	std::vector<std::uint16_t> shortIndices;
+	const void* indexData = quantized.indices.data();
+	if (header.indexSize == sizeof(std::uint16_t)) {
+		shortIndices.assign(quantized.indices.begin(), quantized.indices.end());
+		indexData = shortIndices.data();
+	}
+	const std::uint64_t vertexBytes = static_cast<std::uint64_t>(header.vertexCount) * header.vertexStride;
+	const std::uint64_t indexBytes = static_cast<std::uint64_t>(header.indexCount) * header.indexSize;
+	const std::uint64_t submeshBytes = static_cast<std::uint64_t>(header.submeshCount) * sizeof(CookedSubmesh);
+	header.vertexOffset = alignOffset(sizeof(header));
+	header.indexOffset = alignOffset(header.vertexOffset + vertexBytes);
+	header.submeshOffset = alignOffset(header.indexOffset + indexBytes);
+
+	std::error_code error;
+	std::filesystem::create_directories(std::filesystem::path(outputPath).parent_path(), error);
+	std::ofstream output(outputPath, std::ios::binary | std::ios::trunc);
+	const char padding[COOKED_MESH_ALIGNMENT] = {};
+	output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	output.write(padding, header.vertexOffset - sizeof(header));
+	output.write(reinterpret_cast<const char*>(quantized.vertices.data()), vertexBytes);
+	output.write(padding, header.indexOffset - header.vertexOffset - vertexBytes);
+	output.write(static_cast<const char*>(indexData), indexBytes);
+	output.write(padding, header.submeshOffset - header.indexOffset - indexBytes);
+	output.write(reinterpret_cast<const char*>(submeshes.data()), submeshBytes);
+
+	if (!output) {
+		std::cout << "There was an error writing the cooked mesh " << outputPath << '\n';
+		return false;
+	}
+	std::cout << "Cooked " << sourcePath << " -> " << outputPath << " (" << header.vertexCount << " vertices, " << header.indexCount / 3 << " triangles, "
+		<< header.submeshCount << " submeshes, " << (header.submeshOffset + submeshBytes) / 1024 << " KB)" << '\n';
+	return true;
+}
+
+int cookMeshDirectory(const char* sourceDirectory, const char* outputDirectory) {
+	int failures = 0;
+	std::error_code error;
+	for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(sourceDirectory, error)) {
+		std::string extension = entry.path().extension().string();
+		std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+		if (!entry.is_regular_file() || (extension != ".obj" && extension != ".gltf" && extension != ".glb")) continue;
+
+		const std::string outputPath = (std::filesystem::path(outputDirectory) / entry.path().stem()).string() + ".cmesh";
+		if (!cookMesh(entry.path().string().c_str(), outputPath.c_str())) ++failures;
+	}
+	if (error) {
+		std::cout << "Could not read the mesh directory " << sourceDirectory << '\n';
+		++failures;
+	}
+	return failures;
+}
+
+const CookedMeshHeader* validateCookedMesh(const MappedFile& file) {
+	if (file.size() < sizeof(CookedMeshHeader)) return NULL;
+
+	const CookedMeshHeader* header = reinterpret_cast<const CookedMeshHeader*>(file.data());
+	if (std::memcmp(header->magic, COOKED_MESH_MAGIC, sizeof(COOKED_MESH_MAGIC)) != 0 || header->version != COOKED_MESH_VERSION) return NULL;
+	if (header->vertexStride != sizeof(QuantizedVertex) || (header->indexSize != sizeof(std::uint16_t) && header->indexSize != sizeof(std::uint32_t))) return NULL;
+	if (header->vertexOffset % COOKED_MESH_ALIGNMENT != 0 || header->indexOffset % COOKED_MESH_ALIGNMENT != 0 || header->submeshOffset % COOKED_MESH_ALIGNMENT != 0) return NULL;
+	if (!sectionFits(header->vertexOffset, static_cast<std::uint64_t>(header->vertexCount) * header->vertexStride, file.size())
+		|| !sectionFits(header->indexOffset, static_cast<std::uint64_t>(header->indexCount) * header->indexSize, file.size())
+		|| !sectionFits(header->submeshOffset, static_cast<std::uint64_t>(header->submeshCount) * sizeof(CookedSubmesh), file.size())) return NULL;
+
+	const CookedSubmesh* submeshes = cookedSubmeshes(*header, file.data());
+	for (std::uint32_t s = 0; s < header->submeshCount; ++s) {
+		if (static_cast<std::uint64_t>(submeshes[s].firstIndex) + submeshes[s].indexCount > header->indexCount) return NULL;
+	}
+	// An index past the vertices would have the GPU read outside the vertex buffer.
+	const unsigned char* indices = file.data() + header->indexOffset;
+	if (header->indexSize == sizeof(std::uint16_t)) {
+		if (!indicesInRange(reinterpret_cast<const std::uint16_t*>(indices), header->indexCount, header->vertexCount)) return NULL;
+	}
+	else if (!indicesInRange(reinterpret_cast<const std::uint32_t*>(indices), header->indexCount, header->vertexCount)) return NULL;
+	return header;
+}
+
+const CookedSubmesh* cookedSubmeshes(const CookedMeshHeader& header, const unsigned char* fileData) {
+	return reinterpret_cast<const CookedSubmesh*>(fileData + header.submeshOffset);
+}
+
+MeshBuffers uploadCookedMesh(const CookedMeshHeader& header, const unsigned char* fileData) {
+	MeshBuffers buffers = createMeshBuffers(fileData + header.vertexOffset, header.vertexCount, header.vertexStride, quantizedVertexLayout(header.halfFloatTextureCoordinates != 0),
+		fileData + header.indexOffset, header.indexCount, header.indexSize == sizeof(std::uint16_t) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT);
+	buffers.positionScale = glm::vec3(header.positionScale[0], header.positionScale[1], header.positionScale[2]);
+	buffers.positionBias = glm::vec3(header.positionBias[0], header.positionBias[1], header.positionBias[2]);
+	return buffers;
+}
+
+IndexedMesh readCookedMeshPositions(const CookedMeshHeader& header, const unsigned char* fileData) {
+	const glm::vec3 positionScale(header.positionScale[0], header.positionScale[1], header.positionScale[2]);
+	const glm::vec3 positionBias(header.positionBias[0], header.positionBias[1], header.positionBias[2]);
+	IndexedMesh mesh;
+	mesh.attributeSizes.push_back(3);
+	mesh.vertices.resize(static_cast<std::size_t>(header.vertexCount) * 3);
+	const QuantizedVertex* vertices = reinterpret_cast<const QuantizedVertex*>(fileData + header.vertexOffset);
+	for (std::uint32_t i = 0; i < header.vertexCount; ++i) {
+		const glm::vec3 position = dequantizePosition(vertices[i], positionScale, positionBias);
+		storeVec3(position, &mesh.vertices[static_cast<std::size_t>(i) * 3]);
+	}
+
+	const unsigned char* indices = fileData + header.indexOffset;
+	if (header.indexSize == sizeof(std::uint16_t)) {
+		const std::uint16_t* shortIndices = reinterpret_cast<const std::uint16_t*>(indices);
+		mesh.indices.assign(shortIndices, shortIndices + header.indexCount);
+	}
+	else {
+		const std::uint32_t* longIndices = reinterpret_cast<const std::uint32_t*>(indices);
+		mesh.indices.assign(longIndices, longIndices + header.indexCount);
+	}
+
+	const CookedSubmesh* submeshes = cookedSubmeshes(header, fileData);
+	for (std::uint32_t s = 0; s < header.submeshCount; ++s) mesh.submeshes.push_back({ submeshes[s].firstIndex, submeshes[s].indexCount });
+	return mesh;
+}
+
+bool loadCookedMesh(const char* path, MeshBuffers& buffers, IndexedMesh* positions) {
+	MappedFile file;
+	const CookedMeshHeader* header = file.open(path) ? validateCookedMesh(file) : NULL;
+	if (!header) {
+		std::cout << "There was an error loading the cooked mesh " << path << '\n';
+		return false;
+	}
+	buffers = uploadCookedMesh(*header, file.data());
+	if (positions) {
+		*positions = readCookedMeshPositions(*header, file.data());
+		positions->name = path;
+	}
+	return true;
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include "MeshBuilder.h"
+#include <cstdint>
+#include <string>
+
+class MappedFile;
+
+const std::uint32_t COOKED_MESH_VERSION = 1;
+const std::uint32_t COOKED_MESH_ALIGNMENT = 16;
+
+struct CookedSubmesh {
+	std::uint32_t firstIndex;
+	std::uint32_t indexCount;
+	float boundsMin[3];
+	float boundsMax[3];
+};
+
+// A .cmesh file is this header followed by the QuantizedVertex stream, the index buffer (16-bit
+// when every index fits) and the submesh table, each starting on a COOKED_MESH_ALIGNMENT boundary.
+// Bounds are in object space, after dequantization.
+struct CookedMeshHeader {
+	char magic[4];
+	std::uint32_t version;
+	std::uint32_t vertexCount;
+	std::uint32_t vertexStride;
+	std::uint32_t indexCount;
+	std::uint32_t indexSize;
+	std::uint32_t submeshCount;
+	std::uint32_t halfFloatTextureCoordinates;
+	float positionScale[3];
+	float positionBias[3];
+	float boundsMin[3];
+	float boundsMax[3];
+	float sphereCenter[3];
+	float sphereRadius;
+	std::uint64_t vertexOffset;
+	std::uint64_t indexOffset;
+	std::uint64_t submeshOffset;
+};
+
+std::string cookedMeshPath(const char* sourcePath);
+// Imports, optimizes and quantizes the source mesh, then writes it out.
+bool cookMesh(const char* sourcePath, const char* outputPath);
+int cookMeshDirectory(const char* sourceDirectory, const char* outputDirectory);
+
+const CookedMeshHeader* validateCookedMesh(const MappedFile& file);
+const CookedSubmesh* cookedSubmeshes(const CookedMeshHeader& header, const unsigned char* fileData);
+// Hands the mapped vertex and index sections straight to glBufferData.
+MeshBuffers uploadCookedMesh(const CookedMeshHeader& header, const unsigned char* fileData);
+// A position-only {3} mesh with the dequantized positions, 32-bit indices and the submeshes, for
+// CPU work such as picking and occlusion culling.
+IndexedMesh readCookedMeshPositions(const CookedMeshHeader& header, const unsigned char* fileData);
+// Maps, validates and uploads a .cmesh in one go, also filling positions when it is given; the
+// mapping is closed before returning.
+bool loadCookedMesh(const char* path, MeshBuffers& buffers, IndexedMesh* positions = NULL);
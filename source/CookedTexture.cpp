@@ -0,0 +1,165 @@
+#include "CookedTexture.h"
+#include "MappedFile.h"
+#include <glad/glad.h>
+#include <stb_image.h>
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+namespace {
+	const char COOKED_TEXTURE_MAGIC[4] = { 'C', 'T', 'E', 'X' };
+
+	std::uint64_t alignOffset(const std::uint64_t offset) {
+		return (offset + COOKED_TEXTURE_ALIGNMENT - 1) / COOKED_TEXTURE_ALIGNMENT * COOKED_TEXTURE_ALIGNMENT;
+	}
+
+	unsigned uncompressedFormat(const std::uint32_t channels) {
+		return (channels == 4) ? GL_RGBA : (channels == 3) ? GL_RGB : (channels == 2) ? GL_RG : GL_RED;
+	}
+}
+
+std::string cookedTexturePath(const char* sourcePath) {
+	std::filesystem::path path(sourcePath);
+	return (path.parent_path() / "cooked" / path.stem()).string() + ".ctex";
+}
+
+bool cookTexture(const char* sourcePath, const char* outputPath, const TextureCookOptions& options) {
+	int width, height, channels;
+	unsigned char* pixels = stbi_load(sourcePath, &width, &height, &channels, 0);
+	if (!pixels) {
+		std::cout << "There was an error loading the texture " << sourcePath << ':' << '\n' << stbi_failure_reason() << '\n';
+		return false;
+	}
+
+	std::vector<MipLevel> mipLevels;
+	generateMipChain(pixels, width, height, channels, true, options.mipFilter, mipLevels);
+
+	BlockFormat blockFormat = BlockFormat::BC1;
+	double psnr = 0.0;
+	std::vector<std::vector<unsigned char> > compressedLevels;
+	if (options.compress) {
+		std::string fileName = std::filesystem::path(sourcePath).filename().string();
+		std::transform(fileName.begin(), fileName.end(), fileName.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+		blockFormat = chooseBlockFormat(pixels, width, height, channels, fileName.find("normal") != std::string::npos, options.preferBC7);
+
+		compressedLevels.resize(mipLevels.size() + 1);
+		compressImage(pixels, width, height, channels, blockFormat, options.quality, 0, compressedLevels[0]);
+		for (std::size_t i = 0; i < mipLevels.size(); ++i) {
+			compressImage(mipLevels[i].pixels.data(), mipLevels[i].width, mipLevels[i].height, channels, blockFormat, options.quality, 0, compressedLevels[i + 1]);
+		}
+
+		std::vector<unsigned char> decoded;
+		decompressImage(compressedLevels[0].data(), width, height, blockFormat, decoded);
+		psnr = blockCompressionPsnr(pixels, width, height, channels, blockFormat, decoded);
+	}
+
+	CookedTextureHeader header;
+	std::memset(&header, 0, sizeof(header));
+	std::memcpy(header.magic, COOKED_TEXTURE_MAGIC, sizeof(COOKED_TEXTURE_MAGIC));
+	header.version = COOKED_TEXTURE_VERSION;
+	header.width = width;
+	header.height = height;
+	header.channels = channels;
+	header.payload = options.compress ? static_cast<std::uint32_t>(blockFormat) : static_cast<std::uint32_t>(CookedPayload::Uncompressed);
+	header.isSrgb = 1;
+	header.levelCount = static_cast<std::uint32_t>(std::min<std::size_t>(mipLevels.size() + 1, COOKED_TEXTURE_MAX_LEVELS));
+
+	std::vector<const unsigned char*> levelData(header.levelCount);
+	std::uint64_t offset = alignOffset(sizeof(header));
+	for (std::uint32_t i = 0; i < header.levelCount; ++i) {
+		CookedTextureLevel& level = header.levels[i];
+		level.width = (i == 0) ? width : mipLevels[i - 1].width;
+		level.height = (i == 0) ? height : mipLevels[i - 1].height;
+		level.offset = offset;
+		if (options.compress) {
+			level.size = compressedLevels[i].size();
+			levelData[i] = compressedLevels[i].data();
+		} else {
+			level.size = static_cast<std::uint64_t>(level.width) * level.height * channels;
+			levelData[i] = (i == 0) ? pixels : mipLevels[i - 1].pixels.data();
+		}
+		offset = alignOffset(offset + level.size);
+	}
+
+	std::error_code error;
+	std::filesystem::create_directories(std::filesystem::path(outputPath).parent_path(), error);
+	std::ofstream output(outputPath, std::ios::binary | std::ios::trunc);
+	const char padding[COOKED_TEXTURE_ALIGNMENT] = {};
+	output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	std::uint64_t written = sizeof(header);
+	for (std::uint32_t i = 0; i < header.levelCount; ++i) {
+		output.write(padding, header.levels[i].offset - written);
+		output.write(reinterpret_cast<const char*>(levelData[i]), header.levels[i].size);
+		written = header.levels[i].offset + header.levels[i].size;
+	}
+	stbi_image_free(pixels);
+
+	if (!output) {
+		std::cout << "There was an error writing the cooked texture " << outputPath << '\n';
+		return false;
+	}
+	std::cout << "Cooked " << sourcePath << " -> " << outputPath << " (" << width << 'x' << height << ", " << header.levelCount << " levels, " << written / 1024 << " KB";
+	if (options.compress) std::cout << ", " << blockFormatName(blockFormat) << " at " << psnr << " dB PSNR";
+	std::cout << ")" << '\n';
+	return true;
+}
+
+int cookTextureDirectory(const char* sourceDirectory, const char* outputDirectory, const TextureCookOptions& options) {
+	int failures = 0;
+	std::error_code error;
+	for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(sourceDirectory, error)) {
+		std::string extension = entry.path().extension().string();
+		std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+		if (!entry.is_regular_file() || (extension != ".jpg" && extension != ".jpeg" && extension != ".png")) continue;
+
+		const std::string outputPath = (std::filesystem::path(outputDirectory) / entry.path().stem()).string() + ".ctex";
+		if (!cookTexture(entry.path().string().c_str(), outputPath.c_str(), options)) ++failures;
+	}
+	if (error) {
+		std::cout << "Could not read the texture directory " << sourceDirectory << '\n';
+		++failures;
+	}
+	return failures;
+}
+
+const CookedTextureHeader* validateCookedTexture(const MappedFile& file) {
+	if (file.size() < sizeof(CookedTextureHeader)) return NULL;
+
+	const CookedTextureHeader* header = reinterpret_cast<const CookedTextureHeader*>(file.data());
+	if (std::memcmp(header->magic, COOKED_TEXTURE_MAGIC, sizeof(COOKED_TEXTURE_MAGIC)) != 0 || header->version != COOKED_TEXTURE_VERSION) return NULL;
+	if (header->levelCount == 0 || header->levelCount > COOKED_TEXTURE_MAX_LEVELS || header->channels == 0 || header->channels > 4) return NULL;
+	if (header->payload > static_cast<std::uint32_t>(CookedPayload::BC7) || header->width == 0 || header->height == 0) return NULL;
+	if (header->width > static_cast<std::uint32_t>(std::numeric_limits<int>::max()) || header->height > static_cast<std::uint32_t>(std::numeric_limits<int>::max())) return NULL;
+	const std::uint64_t fileSize = file.size();
+	for (std::uint32_t i = 0; i < header->levelCount; ++i) {
+		const CookedTextureLevel& level = header->levels[i];
+		if (level.width != std::max<std::uint32_t>(1, header->width >> i) || level.height != std::max<std::uint32_t>(1, header->height >> i)) return NULL;
+		if (level.offset > fileSize || level.size > fileSize - level.offset) return NULL;
+		const std::uint64_t expectedSize = (header->payload == static_cast<std::uint32_t>(CookedPayload::Uncompressed))
+			? static_cast<std::uint64_t>(level.width) * level.height * header->channels
+			: compressedImageSize(static_cast<BlockFormat>(header->payload), level.width, level.height);
+		if (level.size != expectedSize) return NULL;
+	}
+	return header;
+}
+
+bool uploadCookedTexture(const CookedTextureHeader& header, const unsigned char* fileData) {
+	const bool isCompressed = header.payload != static_cast<std::uint32_t>(CookedPayload::Uncompressed);
+	const BlockFormat blockFormat = static_cast<BlockFormat>(header.payload);
+	if (isCompressed && !isBlockFormatSupported(blockFormat)) return false;
+
+	const unsigned format = isCompressed ? blockFormatGLInternalFormat(blockFormat) : uncompressedFormat(header.channels);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<int>(header.levelCount - 1));
+	for (std::uint32_t i = 0; i < header.levelCount; ++i) {
+		const CookedTextureLevel& level = header.levels[i];
+		if (isCompressed) glCompressedTexImage2D(GL_TEXTURE_2D, static_cast<int>(i), format, level.width, level.height, 0, static_cast<int>(level.size), fileData + level.offset);
+		else glTexImage2D(GL_TEXTURE_2D, static_cast<int>(i), format, level.width, level.height, 0, format, GL_UNSIGNED_BYTE, fileData + level.offset);
+	}
+	return true;
+}
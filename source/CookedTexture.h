@@ -0,0 +1,56 @@
+#pragma once
+#include "BlockCompression.h"
+#include "MipChain.h"
+#include <cstdint>
+#include <string>
+
+class MappedFile;
+
+const std::uint32_t COOKED_TEXTURE_VERSION = 1;
+const std::uint32_t COOKED_TEXTURE_MAX_LEVELS = 16;
+const std::uint32_t COOKED_TEXTURE_ALIGNMENT = 16;
+
+enum class CookedPayload : std::uint32_t {
+	Uncompressed = 0,
+	BC1 = static_cast<std::uint32_t>(BlockFormat::BC1),
+	BC3 = static_cast<std::uint32_t>(BlockFormat::BC3),
+	BC4 = static_cast<std::uint32_t>(BlockFormat::BC4),
+	BC5 = static_cast<std::uint32_t>(BlockFormat::BC5),
+	BC7 = static_cast<std::uint32_t>(BlockFormat::BC7)
+};
+
+struct TextureCookOptions {
+	MipFilter mipFilter = MipFilter::Kaiser;
+	bool compress = false;
+	bool preferBC7 = false;
+	BlockQuality quality = BlockQuality::Normal;
+};
+
+struct CookedTextureLevel {
+	std::uint32_t width;
+	std::uint32_t height;
+	std::uint64_t offset;
+	std::uint64_t size;
+};
+
+// A .ctex file is this header followed by every mip level, each starting on a COOKED_TEXTURE_ALIGNMENT
+// boundary, so the runtime can hand pointers into the mapping straight to GL.
+struct CookedTextureHeader {
+	char magic[4];
+	std::uint32_t version;
+	std::uint32_t width;
+	std::uint32_t height;
+	std::uint32_t channels;
+	std::uint32_t payload;
+	std::uint32_t isSrgb;
+	std::uint32_t levelCount;
+	CookedTextureLevel levels[COOKED_TEXTURE_MAX_LEVELS];
+};
+
+std::string cookedTexturePath(const char* sourcePath);
+// Source files whose name contains "normal" are treated as normal maps when compressing.
+bool cookTexture(const char* sourcePath, const char* outputPath, const TextureCookOptions& options);
+int cookTextureDirectory(const char* sourceDirectory, const char* outputDirectory, const TextureCookOptions& options);
+
+const CookedTextureHeader* validateCookedTexture(const MappedFile& file);
+bool uploadCookedTexture(const CookedTextureHeader& header, const unsigned char* fileData);
@@ -0,0 +1,9 @@
+#pragma once
+#include "MeshBuilder.h"
+
+// Unindexed cube: 36 vertices of position (xyz) followed by texture coordinate (uv).
+const int CUBE_VERTEX_COUNT = 36;
+extern const float CUBE_VERTICES[CUBE_VERTEX_COUNT * 5];
+
+// Welded and indexed: attribute 0 is the position and attribute 1 the texture coordinate.
+IndexedMesh buildCubeMesh();
@@ -0,0 +1,43 @@
+#include "FixedTimestep.h"
+#include <cmath>
+
+FixedTimestep::FixedTimestep(const double stepSeconds, const int maxStepsPerFrame) : step(stepSeconds), maxStepsPerFrame(maxStepsPerFrame), accumulator(0.0), stepCount(0), dropped(0.0), frameFirstStep(0), frameDropped(0.0) {}
+
+int FixedTimestep::advance(const double frameSeconds) {
+	frameFirstStep = stepCount;
+	frameDropped = dropped;
+	if (frameSeconds > 0.0) accumulator += frameSeconds;
+	int steps = 0;
+	while (accumulator >= step && steps < maxStepsPerFrame) {
+		accumulator -= step;
+		++steps;
+	}
+	if (accumulator >= step) {
+		// Keep the fraction into the next step so interpolation stays continuous.
+		const double excess = std::floor(accumulator / step) * step;
+		dropped += excess;
+		accumulator -= excess;
+	}
+	stepCount += steps;
+	return steps;
+}
+
+float FixedTimestep::alpha() const {
+	return static_cast<float>(accumulator / step);
+}
+
+double FixedTimestep::stepStartSeconds(const int index) const {
+	return static_cast<double>(frameFirstStep + index) * step + frameDropped;
+}
+
+double FixedTimestep::stepSeconds() const {
+	return step;
+}
+
+std::uint64_t FixedTimestep::steps() const {
+	return stepCount;
+}
+
+double FixedTimestep::droppedSeconds() const {
+	return dropped;
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include <cstdint>
+
+// Turns variable frame times into a whole number of fixed simulation steps, so the simulation
+// advances the same way at any frame rate or vsync setting. The time left over after the last
+// step becomes alpha(), the fraction of the way into the next step, which rendering uses to blend
+// the previous and current step's states; that draws the scene up to one step behind.
+class FixedTimestep {
+public:
+	explicit FixedTimestep(const double stepSeconds = 1.0 / 60.0, const int maxStepsPerFrame = 8);
+
+	// Adds one frame's elapsed time and returns how many steps to run now. Anything beyond
+	// maxStepsPerFrame steps is dropped, so a frame that falls behind slows the simulation down
+	// for a moment instead of queueing even more steps for the next frame.
+	int advance(const double frameSeconds);
+	float alpha() const;
+	// When the index-th of the steps the last advance() returned starts, on the clock of the summed
+	// frame times: its place in the step sequence plus the time dropped before it. It depends only
+	// on the step, not on how steps were grouped into frames.
+	double stepStartSeconds(const int index) const;
+
+	double stepSeconds() const;
+	std::uint64_t steps() const;
+	double droppedSeconds() const;
+
+private:
+	double step;
+	int maxStepsPerFrame;
+	double accumulator;
+	std::uint64_t stepCount;
+	double dropped;
+	std::uint64_t frameFirstStep;
+	double frameDropped;
+};
@@ -0,0 +1,33 @@
+#include "FrameConstants.h"
+#include <glad/glad.h>
+#include <cstring>
+
+void bindFrameConstantsBlock(const unsigned program) {
+	unsigned blockIndex = glGetUniformBlockIndex(program, "FrameConstants");
+	if (blockIndex != GL_INVALID_INDEX) glUniformBlockBinding(program, blockIndex, FRAME_CONSTANTS_BINDING);
+}
+
+FrameConstantsBuffer::FrameConstantsBuffer() : buffer(0), uploaded(), hasUploaded(false) {}
+
+void FrameConstantsBuffer::create() {
+	glGenBuffers(1, &buffer);
+	glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameConstants), NULL, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	hasUploaded = false;
+}
+
+void FrameConstantsBuffer::update(const FrameConstants& constants) {
+	glBindBufferBase(GL_UNIFORM_BUFFER, FRAME_CONSTANTS_BINDING, buffer);
+	if (hasUploaded && std::memcmp(&uploaded, &constants, sizeof(FrameConstants)) == 0) return;
+
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameConstants), &constants);
+	uploaded = constants;
+	hasUploaded = true;
+}
+
+void FrameConstantsBuffer::destroy() {
+	glDeleteBuffers(1, &buffer);
+	buffer = 0;
+	hasUploaded = false;
+}
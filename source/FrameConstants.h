@@ -0,0 +1,26 @@
+#pragma once
+#include <glm/glm.hpp>
+
+const unsigned FRAME_CONSTANTS_BINDING = 0;
+
+// Mirrors the std140 FrameConstants block in VertexShader.txt; mat4 members need no padding.
+struct FrameConstants {
+	glm::mat4 view;
+	glm::mat4 projection;
+};
+
+void bindFrameConstantsBlock(const unsigned program);
+
+class FrameConstantsBuffer {
+public:
+	FrameConstantsBuffer();
+
+	void create();
+	void update(const FrameConstants& constants);
+	void destroy();
+
+private:
+	unsigned buffer;
+	FrameConstants uploaded;
+	bool hasUploaded;
+};
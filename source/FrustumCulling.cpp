@@ -0,0 +1,137 @@
+#include "FrustumCulling.h"
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FRUSTUM_CULLING_SSE2 1
+#endif
+
+namespace {
+	// Arrays are padded to whole groups of four so the SIMD loops never load past the end.
+	const std::size_t LANES = 4;
+
+	std::size_t appendLanes(const int mask, const std::size_t first, const std::size_t count, std::uint32_t* visible, std::size_t visibleCount) {
+		// Branchless compaction: every lane is written, but only visible ones advance the cursor.
+		const std::size_t lanes = (count - first < LANES) ? count - first : LANES;
+		for (std::size_t lane = 0; lane < lanes; ++lane) {
+			visible[visibleCount] = static_cast<std::uint32_t>(first + lane);
+			visibleCount += (mask >> lane) & 1;
+		}
+		return visibleCount;
+	}
+
+	float planeDistance(const glm::vec4& plane, const ObjectBounds& bounds, const std::size_t i) {
+		return plane.x * bounds.centerX[i] + plane.y * bounds.centerY[i] + plane.z * bounds.centerZ[i] + plane.w;
+	}
+
+#ifdef FRUSTUM_CULLING_SSE2
+	__m128 planeDistance4(const glm::vec4& plane, const __m128 x, const __m128 y, const __m128 z) {
+		return _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.x), x), _mm_mul_ps(_mm_set1_ps(plane.y), y)), _mm_mul_ps(_mm_set1_ps(plane.z), z)), _mm_set1_ps(plane.w));
+	}
+#endif
+}
+
+Frustum extractFrustum(const glm::mat4& viewProjection) {
+	const glm::vec4 rowX(viewProjection[0][0], viewProjection[1][0], viewProjection[2][0], viewProjection[3][0]);
+	const glm::vec4 rowY(viewProjection[0][1], viewProjection[1][1], viewProjection[2][1], viewProjection[3][1]);
+	const glm::vec4 rowZ(viewProjection[0][2], viewProjection[1][2], viewProjection[2][2], viewProjection[3][2]);
+	const glm::vec4 rowW(viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3]);
+
+	Frustum frustum;
+	frustum.planes[0] = rowW + rowX;
+	frustum.planes[1] = rowW - rowX;
+	frustum.planes[2] = rowW + rowY;
+	frustum.planes[3] = rowW - rowY;
+	frustum.planes[4] = rowW + rowZ;
+	frustum.planes[5] = rowW - rowZ;
+	for (glm::vec4& plane : frustum.planes) plane /= glm::length(glm::vec3(plane));
+	return frustum;
+}
+
+ObjectBounds::ObjectBounds() : count(0) {}
+
+void ObjectBounds::resize(const std::size_t newCount) {
+	count = newCount;
+	const std::size_t padded = (newCount + LANES - 1) / LANES * LANES;
+	for (std::vector<float>* component : { &centerX, &centerY, &centerZ, &extentX, &extentY, &extentZ, &radius }) component->resize(padded, 0.0f);
+}
+
+void ObjectBounds::set(const std::size_t index, const glm::vec3& center, const glm::vec3& extents) {
+	centerX[index] = center.x;
+	centerY[index] = center.y;
+	centerZ[index] = center.z;
+	extentX[index] = extents.x;
+	extentY[index] = extents.y;
+	extentZ[index] = extents.z;
+	radius[index] = glm::length(extents);
+}
+
+std::size_t ObjectBounds::size() const {
+	return count;
+}
+
+void transformBounds(const glm::mat4& model, const glm::vec3& center, const glm::vec3& extents, glm::vec3& worldCenter, glm::vec3& worldExtents) {
+	worldCenter = glm::vec3(model * glm::vec4(center, 1.0f));
+	worldExtents = glm::abs(glm::vec3(model[0])) * extents.x + glm::abs(glm::vec3(model[1])) * extents.y + glm::abs(glm::vec3(model[2])) * extents.z;
+}
+
+// A box is outside once its most positive corner along some plane normal is behind that plane.
+std::size_t cullBoxes(const Frustum& frustum, const ObjectBounds& bounds, std::uint32_t* visible) {
+#ifdef FRUSTUM_CULLING_SSE2
+	const __m128 zero = _mm_setzero_ps();
+	std::size_t visibleCount = 0;
+	for (std::size_t i = 0; i < bounds.size(); i += LANES) {
+		const __m128 x = _mm_loadu_ps(&bounds.centerX[i]), y = _mm_loadu_ps(&bounds.centerY[i]), z = _mm_loadu_ps(&bounds.centerZ[i]);
+		const __m128 extentX = _mm_loadu_ps(&bounds.extentX[i]), extentY = _mm_loadu_ps(&bounds.extentY[i]), extentZ = _mm_loadu_ps(&bounds.extentZ[i]);
+		__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+		for (const glm::vec4& plane : frustum.planes) {
+			const __m128 reach = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(std::abs(plane.x)), extentX), _mm_mul_ps(_mm_set1_ps(std::abs(plane.y)), extentY)), _mm_mul_ps(_mm_set1_ps(std::abs(plane.z)), extentZ));
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(planeDistance4(plane, x, y, z), reach), zero));
+		}
+		visibleCount = appendLanes(_mm_movemask_ps(inside), i, bounds.size(), visible, visibleCount);
+	}
+	return visibleCount;
+#else
+	return cullBoxesScalar(frustum, bounds, visible);
+#endif
+}
+
+std::size_t cullSpheres(const Frustum& frustum, const ObjectBounds& bounds, std::uint32_t* visible) {
+#ifdef FRUSTUM_CULLING_SSE2
+	const __m128 zero = _mm_setzero_ps();
+	std::size_t visibleCount = 0;
+	for (std::size_t i = 0; i < bounds.size(); i += LANES) {
+		const __m128 x = _mm_loadu_ps(&bounds.centerX[i]), y = _mm_loadu_ps(&bounds.centerY[i]), z = _mm_loadu_ps(&bounds.centerZ[i]);
+		const __m128 radius = _mm_loadu_ps(&bounds.radius[i]);
+		__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+		for (const glm::vec4& plane : frustum.planes) inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(planeDistance4(plane, x, y, z), radius), zero));
+		visibleCount = appendLanes(_mm_movemask_ps(inside), i, bounds.size(), visible, visibleCount);
+	}
+	return visibleCount;
+#else
+	return cullSpheresScalar(frustum, bounds, visible);
+#endif
+}
+
+std::size_t cullBoxesScalar(const Frustum& frustum, const ObjectBounds& bounds, std::uint32_t* visible) {
+	std::size_t visibleCount = 0;
+	for (std::size_t i = 0; i < bounds.size(); ++i) {
+		bool inside = true;
+		for (const glm::vec4& plane : frustum.planes) {
+			const float reach = std::abs(plane.x) * bounds.extentX[i] + std::abs(plane.y) * bounds.extentY[i] + std::abs(plane.z) * bounds.extentZ[i];
+			inside = inside && planeDistance(plane, bounds, i) + reach >= 0.0f;
+		}
+		if (inside) visible[visibleCount++] = static_cast<std::uint32_t>(i);
+	}
+	return visibleCount;
+}
+
+std::size_t cullSpheresScalar(const Frustum& frustum, const ObjectBounds& bounds, std::uint32_t* visible) {
+	std::size_t visibleCount = 0;
+	for (std::size_t i = 0; i < bounds.size(); ++i) {
+		bool inside = true;
+		for (const glm::vec4& plane : frustum.planes) inside = inside && planeDistance(plane, bounds, i) + bounds.radius[i] >= 0.0f;
+		if (inside) visible[visibleCount++] = static_cast<std::uint32_t>(i);
+	}
+	return visibleCount;
+}
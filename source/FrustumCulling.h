@@ -0,0 +1,44 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Left, right, bottom, top, near and far planes as (normal, distance) with inward-facing unit
+// normals, so dot(normal, point) + distance >= 0 inside.
+struct Frustum {
+	glm::vec4 planes[6];
+};
+
+// Gribb-Hartmann extraction from the combined matrix; pass projection * view for world-space
+// planes.
+Frustum extractFrustum(const glm::mat4& viewProjection);
+
+// World-space bounds in structure-of-arrays form so four objects load into one register per
+// component. Each object has a box (centre and half extents) and the sphere around that box.
+class ObjectBounds {
+public:
+	ObjectBounds();
+
+	void resize(const std::size_t count);
+	void set(const std::size_t index, const glm::vec3& center, const glm::vec3& extents);
+	std::size_t size() const;
+
+	std::vector<float> centerX, centerY, centerZ;
+	std::vector<float> extentX, extentY, extentZ;
+	std::vector<float> radius;
+
+private:
+	std::size_t count;
+};
+
+// The world-space box around an object-space box after model (Arvo's method).
+void transformBounds(const glm::mat4& model, const glm::vec3& center, const glm::vec3& extents, glm::vec3& worldCenter, glm::vec3& worldExtents);
+
+// Each writes the indices of the objects that intersect the frustum to visible, in increasing
+// order, and returns how many there are; visible needs room for bounds.size() entries. The SSE2
+// paths test four objects per instruction and match the scalar ones exactly.
+std::size_t cullBoxes(const Frustum& frustum, const ObjectBounds& bounds, std::uint32_t* visible);
+std::size_t cullSpheres(const Frustum& frustum, const ObjectBounds& bounds, std::uint32_t* visible);
+std::size_t cullBoxesScalar(const Frustum& frustum, const ObjectBounds& bounds, std::uint32_t* visible);
+std::size_t cullSpheresScalar(const Frustum& frustum, const ObjectBounds& bounds, std::uint32_t* visible);
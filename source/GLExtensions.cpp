@@ -0,0 +1,41 @@
+#include "GLExtensions.h"
+#include <cstring>
+
+int GLAD_GL_ARB_get_program_binary = 0;
+PFNGLGETPROGRAMBINARYPROC glad_glGetProgramBinary = NULL;
+PFNGLPROGRAMBINARYPROC glad_glProgramBinary = NULL;
+PFNGLPROGRAMPARAMETERIPROC glad_glProgramParameteri = NULL;
+int GLAD_GL_KHR_parallel_shader_compile = 0;
+PFNGLMAXSHADERCOMPILERTHREADSKHRPROC glad_glMaxShaderCompilerThreadsKHR = NULL;
+int GLAD_GL_EXT_texture_compression_s3tc = 0;
+int GLAD_GL_ARB_texture_compression_bptc = 0;
+
+bool hasGLExtension(const char* name) {
+	int extensionCount = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+	for (int i = 0; i < extensionCount; ++i) {
+		const char* extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, static_cast<unsigned>(i)));
+		if (extension && std::strcmp(extension, name) == 0) return true;
+	}
+	return false;
+}
+
+void loadGLExtensions(GLADloadproc load) {
+	const bool coreProgramBinary = GLVersion.major > 4 || (GLVersion.major == 4 && GLVersion.minor >= 1);
+	if (coreProgramBinary || hasGLExtension("GL_ARB_get_program_binary")) {
+		glad_glGetProgramBinary = reinterpret_cast<PFNGLGETPROGRAMBINARYPROC>(load("glGetProgramBinary"));
+		glad_glProgramBinary = reinterpret_cast<PFNGLPROGRAMBINARYPROC>(load("glProgramBinary"));
+		glad_glProgramParameteri = reinterpret_cast<PFNGLPROGRAMPARAMETERIPROC>(load("glProgramParameteri"));
+		GLAD_GL_ARB_get_program_binary = glad_glGetProgramBinary && glad_glProgramBinary && glad_glProgramParameteri;
+	}
+
+	if (hasGLExtension("GL_KHR_parallel_shader_compile")) {
+		glad_glMaxShaderCompilerThreadsKHR = reinterpret_cast<PFNGLMAXSHADERCOMPILERTHREADSKHRPROC>(load("glMaxShaderCompilerThreadsKHR"));
+	} else if (hasGLExtension("GL_ARB_parallel_shader_compile")) {
+		glad_glMaxShaderCompilerThreadsKHR = reinterpret_cast<PFNGLMAXSHADERCOMPILERTHREADSKHRPROC>(load("glMaxShaderCompilerThreadsARB"));
+	}
+	GLAD_GL_KHR_parallel_shader_compile = glad_glMaxShaderCompilerThreadsKHR != NULL;
+
+	GLAD_GL_EXT_texture_compression_s3tc = hasGLExtension("GL_EXT_texture_compression_s3tc");
+	GLAD_GL_ARB_texture_compression_bptc = GLVersion.major > 4 || (GLVersion.major == 4 && GLVersion.minor >= 2) || hasGLExtension("GL_ARB_texture_compression_bptc");
+}
@@ -0,0 +1,378 @@
+#include "GLStateCache.h"
+#include <iostream>
+
+namespace {
+	const GLuint UNKNOWN_NAME = ~0u;
+	const GLint UNKNOWN_VALUE = -1;
+	const int TEXTURE_UNIT_COUNT = 32;
+
+	const GLenum BUFFER_TARGETS[] = { GL_ARRAY_BUFFER, GL_ELEMENT_ARRAY_BUFFER, GL_UNIFORM_BUFFER, GL_PIXEL_UNPACK_BUFFER, GL_PIXEL_PACK_BUFFER, GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER };
+	const GLenum BUFFER_BINDINGS[] = { GL_ARRAY_BUFFER_BINDING, GL_ELEMENT_ARRAY_BUFFER_BINDING, GL_UNIFORM_BUFFER_BINDING, GL_PIXEL_UNPACK_BUFFER_BINDING, GL_PIXEL_PACK_BUFFER_BINDING, GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER };
+	const int BUFFER_TARGET_COUNT = sizeof(BUFFER_TARGETS) / sizeof(BUFFER_TARGETS[0]);
+	const GLenum TEXTURE_TARGETS[] = { GL_TEXTURE_2D, GL_TEXTURE_CUBE_MAP, GL_TEXTURE_2D_ARRAY, GL_TEXTURE_3D };
+	const GLenum TEXTURE_BINDINGS[] = { GL_TEXTURE_BINDING_2D, GL_TEXTURE_BINDING_CUBE_MAP, GL_TEXTURE_BINDING_2D_ARRAY, GL_TEXTURE_BINDING_3D };
+	const int TEXTURE_TARGET_COUNT = sizeof(TEXTURE_TARGETS) / sizeof(TEXTURE_TARGETS[0]);
+	const GLenum CAPABILITIES[] = { GL_DEPTH_TEST, GL_BLEND, GL_CULL_FACE, GL_SCISSOR_TEST, GL_STENCIL_TEST };
+	const int CAPABILITY_COUNT = sizeof(CAPABILITIES) / sizeof(CAPABILITIES[0]);
+
+	struct ShadowState {
+		GLuint program;
+		GLuint vertexArray;
+		GLuint buffers[BUFFER_TARGET_COUNT];
+		GLint activeUnit;
+		GLuint textures[TEXTURE_UNIT_COUNT][TEXTURE_TARGET_COUNT];
+		GLint enabled[CAPABILITY_COUNT];
+		GLint depthFunc;
+		GLint depthMask;
+		GLint blendFunc[4];
+		GLint cullFace;
+		GLint viewport[4];
+		bool viewportKnown;
+	};
+
+	ShadowState shadow;
+	GLStateStatistics frameCounts = {};
+	GLStateStatistics lastFrameCounts = {};
+	bool installed = false;
+
+	PFNGLUSEPROGRAMPROC realUseProgram;
+	PFNGLBINDVERTEXARRAYPROC realBindVertexArray;
+	PFNGLDELETEVERTEXARRAYSPROC realDeleteVertexArrays;
+	PFNGLBINDBUFFERPROC realBindBuffer;
+	PFNGLBINDBUFFERBASEPROC realBindBufferBase;
+	PFNGLBINDBUFFERRANGEPROC realBindBufferRange;
+	PFNGLDELETEBUFFERSPROC realDeleteBuffers;
+	PFNGLACTIVETEXTUREPROC realActiveTexture;
+	PFNGLBINDTEXTUREPROC realBindTexture;
+	PFNGLDELETETEXTURESPROC realDeleteTextures;
+	PFNGLENABLEPROC realEnable;
+	PFNGLDISABLEPROC realDisable;
+	PFNGLDEPTHFUNCPROC realDepthFunc;
+	PFNGLDEPTHMASKPROC realDepthMask;
+	PFNGLBLENDFUNCPROC realBlendFunc;
+	PFNGLBLENDFUNCSEPARATEPROC realBlendFuncSeparate;
+	PFNGLCULLFACEPROC realCullFace;
+	PFNGLVIEWPORTPROC realViewport;
+
+	// Returns true when the call has to reach GL.
+	bool changes(const bool differs) {
+		if (differs) ++frameCounts.issued;
+		else ++frameCounts.elided;
+		return differs;
+	}
+
+	int bufferSlot(const GLenum target) {
+		for (int i = 0; i < BUFFER_TARGET_COUNT; ++i) {
+			if (BUFFER_TARGETS[i] == target) return i;
+		}
+		return -1;
+	}
+
+	int textureSlot(const GLenum target) {
+		for (int i = 0; i < TEXTURE_TARGET_COUNT; ++i) {
+			if (TEXTURE_TARGETS[i] == target) return i;
+		}
+		return -1;
+	}
+
+	int capabilitySlot(const GLenum capability) {
+		for (int i = 0; i < CAPABILITY_COUNT; ++i) {
+			if (CAPABILITIES[i] == capability) return i;
+		}
+		return -1;
+	}
+
+	void APIENTRY cachedUseProgram(GLuint program) {
+		if (!changes(shadow.program != program)) return;
+		realUseProgram(program);
+		shadow.program = program;
+	}
+
+	// The element array binding belongs to the vertex array, so it is unknown after a switch.
+	void APIENTRY cachedBindVertexArray(GLuint array) {
+		if (!changes(shadow.vertexArray != array)) return;
+		realBindVertexArray(array);
+		shadow.vertexArray = array;
+		shadow.buffers[bufferSlot(GL_ELEMENT_ARRAY_BUFFER)] = UNKNOWN_NAME;
+	}
+
+	void APIENTRY cachedDeleteVertexArrays(GLsizei n, const GLuint* arrays) {
+		++frameCounts.issued;
+		realDeleteVertexArrays(n, arrays);
+		for (GLsizei i = 0; i < n; ++i) {
+			if (arrays[i] != 0 && arrays[i] == shadow.vertexArray) {
+				shadow.vertexArray = 0;
+				shadow.buffers[bufferSlot(GL_ELEMENT_ARRAY_BUFFER)] = UNKNOWN_NAME;
+			}
+		}
+	}
+
+	void APIENTRY cachedBindBuffer(GLenum target, GLuint buffer) {
+		const int slot = bufferSlot(target);
+		if (slot < 0) {
+			++frameCounts.issued;
+			realBindBuffer(target, buffer);
+			return;
+		}
+		if (!changes(shadow.buffers[slot] != buffer)) return;
+		realBindBuffer(target, buffer);
+		shadow.buffers[slot] = buffer;
+	}
+
+	// Indexed bindings are not shadowed, but they also replace the generic binding of the target.
+	void APIENTRY cachedBindBufferBase(GLenum target, GLuint index, GLuint buffer) {
+		++frameCounts.issued;
+		realBindBufferBase(target, index, buffer);
+		const int slot = bufferSlot(target);
+		if (slot >= 0) shadow.buffers[slot] = buffer;
+	}
+
+	void APIENTRY cachedBindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size) {
+		++frameCounts.issued;
+		realBindBufferRange(target, index, buffer, offset, size);
+		const int slot = bufferSlot(target);
+		if (slot >= 0) shadow.buffers[slot] = buffer;
+	}
+
+	void APIENTRY cachedDeleteBuffers(GLsizei n, const GLuint* buffers) {
+		++frameCounts.issued;
+		realDeleteBuffers(n, buffers);
+		for (GLsizei i = 0; i < n; ++i) {
+			for (int slot = 0; slot < BUFFER_TARGET_COUNT; ++slot) {
+				if (buffers[i] != 0 && shadow.buffers[slot] == buffers[i]) shadow.buffers[slot] = 0;
+			}
+		}
+	}
+
+	void APIENTRY cachedActiveTexture(GLenum texture) {
+		const GLint unit = static_cast<GLint>(texture - GL_TEXTURE0);
+		if (!changes(shadow.activeUnit != unit)) return;
+		realActiveTexture(texture);
+		shadow.activeUnit = unit;
+	}
+
+	void APIENTRY cachedBindTexture(GLenum target, GLuint texture) {
+		const int slot = textureSlot(target);
+		const GLint unit = shadow.activeUnit;
+		if (slot < 0 || unit < 0 || unit >= TEXTURE_UNIT_COUNT) {
+			++frameCounts.issued;
+			realBindTexture(target, texture);
+			return;
+		}
+		if (!changes(shadow.textures[unit][slot] != texture)) return;
+		realBindTexture(target, texture);
+		shadow.textures[unit][slot] = texture;
+	}
+
+	void APIENTRY cachedDeleteTextures(GLsizei n, const GLuint* textures) {
+		++frameCounts.issued;
+		realDeleteTextures(n, textures);
+		for (GLsizei i = 0; i < n; ++i) {
+			for (int unit = 0; unit < TEXTURE_UNIT_COUNT; ++unit) {
+				for (int slot = 0; slot < TEXTURE_TARGET_COUNT; ++slot) {
+					if (textures[i] != 0 && shadow.textures[unit][slot] == textures[i]) shadow.textures[unit][slot] = 0;
+				}
+			}
+		}
+	}
+
+	void APIENTRY cachedEnable(GLenum capability) {
+		const int slot = capabilitySlot(capability);
+		if (slot >= 0 && !changes(shadow.enabled[slot] != GL_TRUE)) return;
+		if (slot < 0) ++frameCounts.issued;
+		realEnable(capability);
+		if (slot >= 0) shadow.enabled[slot] = GL_TRUE;
+	}
+
+	void APIENTRY cachedDisable(GLenum capability) {
+		const int slot = capabilitySlot(capability);
+		if (slot >= 0 && !changes(shadow.enabled[slot] != GL_FALSE)) return;
+		if (slot < 0) ++frameCounts.issued;
+		realDisable(capability);
+		if (slot >= 0) shadow.enabled[slot] = GL_FALSE;
+	}
+
+	void APIENTRY cachedDepthFunc(GLenum func) {
+		if (!changes(shadow.depthFunc != static_cast<GLint>(func))) return;
+		realDepthFunc(func);
+		shadow.depthFunc = static_cast<GLint>(func);
+	}
+
+	void APIENTRY cachedDepthMask(GLboolean flag) {
+		if (!changes(shadow.depthMask != static_cast<GLint>(flag))) return;
+		realDepthMask(flag);
+		shadow.depthMask = static_cast<GLint>(flag);
+	}
+
+	void APIENTRY cachedBlendFuncSeparate(GLenum sourceColor, GLenum destinationColor, GLenum sourceAlpha, GLenum destinationAlpha) {
+		const GLint factors[4] = { static_cast<GLint>(sourceColor), static_cast<GLint>(destinationColor), static_cast<GLint>(sourceAlpha), static_cast<GLint>(destinationAlpha) };
+		if (!changes(factors[0] != shadow.blendFunc[0] || factors[1] != shadow.blendFunc[1] || factors[2] != shadow.blendFunc[2] || factors[3] != shadow.blendFunc[3])) return;
+		realBlendFuncSeparate(sourceColor, destinationColor, sourceAlpha, destinationAlpha);
+		for (int i = 0; i < 4; ++i) shadow.blendFunc[i] = factors[i];
+	}
+
+	void APIENTRY cachedBlendFunc(GLenum source, GLenum destination) {
+		const GLint factors[4] = { static_cast<GLint>(source), static_cast<GLint>(destination), static_cast<GLint>(source), static_cast<GLint>(destination) };
+		if (!changes(factors[0] != shadow.blendFunc[0] || factors[1] != shadow.blendFunc[1] || factors[2] != shadow.blendFunc[2] || factors[3] != shadow.blendFunc[3])) return;
+		realBlendFunc(source, destination);
+		for (int i = 0; i < 4; ++i) shadow.blendFunc[i] = factors[i];
+	}
+
+	void APIENTRY cachedCullFace(GLenum mode) {
+		if (!changes(shadow.cullFace != static_cast<GLint>(mode))) return;
+		realCullFace(mode);
+		shadow.cullFace = static_cast<GLint>(mode);
+	}
+
+	void APIENTRY cachedViewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+		if (!changes(!shadow.viewportKnown || shadow.viewport[0] != x || shadow.viewport[1] != y || shadow.viewport[2] != width || shadow.viewport[3] != height)) return;
+		realViewport(x, y, width, height);
+		shadow.viewport[0] = x;
+		shadow.viewport[1] = y;
+		shadow.viewport[2] = width;
+		shadow.viewport[3] = height;
+		shadow.viewportKnown = true;
+	}
+
+	template <typename Function>
+	void swapEntryPoint(Function& gladPointer, Function& real, Function cached) {
+		real = gladPointer;
+		gladPointer = cached;
+	}
+
+	// Compares one shadowed value against GL, skipping values the shadow does not know.
+	bool matches(const char* name, const GLint expected, const GLint actual) {
+		if (expected == UNKNOWN_VALUE || expected == actual) return true;
+		std::cout << "There was an error verifying the GL state cache: " << name << " is " << actual << " but the cache holds " << expected << '\n';
+		return false;
+	}
+}
+
+void installGLStateCache() {
+	if (installed) return;
+	swapEntryPoint(glad_glUseProgram, realUseProgram, cachedUseProgram);
+	swapEntryPoint(glad_glBindVertexArray, realBindVertexArray, cachedBindVertexArray);
+	swapEntryPoint(glad_glDeleteVertexArrays, realDeleteVertexArrays, cachedDeleteVertexArrays);
+	swapEntryPoint(glad_glBindBuffer, realBindBuffer, cachedBindBuffer);
+	swapEntryPoint(glad_glBindBufferBase, realBindBufferBase, cachedBindBufferBase);
+	swapEntryPoint(glad_glBindBufferRange, realBindBufferRange, cachedBindBufferRange);
+	swapEntryPoint(glad_glDeleteBuffers, realDeleteBuffers, cachedDeleteBuffers);
+	swapEntryPoint(glad_glActiveTexture, realActiveTexture, cachedActiveTexture);
+	swapEntryPoint(glad_glBindTexture, realBindTexture, cachedBindTexture);
+	swapEntryPoint(glad_glDeleteTextures, realDeleteTextures, cachedDeleteTextures);
+	swapEntryPoint(glad_glEnable, realEnable, cachedEnable);
+	swapEntryPoint(glad_glDisable, realDisable, cachedDisable);
+	swapEntryPoint(glad_glDepthFunc, realDepthFunc, cachedDepthFunc);
+	swapEntryPoint(glad_glDepthMask, realDepthMask, cachedDepthMask);
+	swapEntryPoint(glad_glBlendFunc, realBlendFunc, cachedBlendFunc);
+	swapEntryPoint(glad_glBlendFuncSeparate, realBlendFuncSeparate, cachedBlendFuncSeparate);
+	swapEntryPoint(glad_glCullFace, realCullFace, cachedCullFace);
+	swapEntryPoint(glad_glViewport, realViewport, cachedViewport);
+	installed = true;
+	invalidateGLStateCache();
+}
+
+void uninstallGLStateCache() {
+	if (!installed) return;
+	glad_glUseProgram = realUseProgram;
+	glad_glBindVertexArray = realBindVertexArray;
+	glad_glDeleteVertexArrays = realDeleteVertexArrays;
+	glad_glBindBuffer = realBindBuffer;
+	glad_glBindBufferBase = realBindBufferBase;
+	glad_glBindBufferRange = realBindBufferRange;
+	glad_glDeleteBuffers = realDeleteBuffers;
+	glad_glActiveTexture = realActiveTexture;
+	glad_glBindTexture = realBindTexture;
+	glad_glDeleteTextures = realDeleteTextures;
+	glad_glEnable = realEnable;
+	glad_glDisable = realDisable;
+	glad_glDepthFunc = realDepthFunc;
+	glad_glDepthMask = realDepthMask;
+	glad_glBlendFunc = realBlendFunc;
+	glad_glBlendFuncSeparate = realBlendFuncSeparate;
+	glad_glCullFace = realCullFace;
+	glad_glViewport = realViewport;
+	installed = false;
+}
+
+void invalidateGLStateCache() {
+	shadow.program = UNKNOWN_NAME;
+	shadow.vertexArray = UNKNOWN_NAME;
+	for (int slot = 0; slot < BUFFER_TARGET_COUNT; ++slot) shadow.buffers[slot] = UNKNOWN_NAME;
+	shadow.activeUnit = UNKNOWN_VALUE;
+	for (int unit = 0; unit < TEXTURE_UNIT_COUNT; ++unit) {
+		for (int slot = 0; slot < TEXTURE_TARGET_COUNT; ++slot) shadow.textures[unit][slot] = UNKNOWN_NAME;
+	}
+	for (int slot = 0; slot < CAPABILITY_COUNT; ++slot) shadow.enabled[slot] = UNKNOWN_VALUE;
+	shadow.depthFunc = UNKNOWN_VALUE;
+	shadow.depthMask = UNKNOWN_VALUE;
+	for (int i = 0; i < 4; ++i) shadow.blendFunc[i] = UNKNOWN_VALUE;
+	shadow.cullFace = UNKNOWN_VALUE;
+	shadow.viewportKnown = false;
+}
+
+void endGLStateFrame() {
+	lastFrameCounts = frameCounts;
+	frameCounts = GLStateStatistics();
+}
+
+const GLStateStatistics& glStateStatistics() {
+	return lastFrameCounts;
+}
+
+void reportGLStateCache() {
+	const std::size_t total = lastFrameCounts.issued + lastFrameCounts.elided;
+	std::cout << "GL state cache: " << lastFrameCounts.issued << " calls issued, " << lastFrameCounts.elided << " elided";
+	if (total > 0) std::cout << " (" << 100.0 * lastFrameCounts.elided / total << "%)";
+	std::cout << " last frame" << '\n';
+}
+
+bool verifyGLStateCache() {
+	GLint value = 0;
+	bool verified = true;
+	glGetIntegerv(GL_CURRENT_PROGRAM, &value);
+	verified = matches("GL_CURRENT_PROGRAM", static_cast<GLint>(shadow.program), value) && verified;
+	glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &value);
+	verified = matches("GL_VERTEX_ARRAY_BINDING", static_cast<GLint>(shadow.vertexArray), value) && verified;
+	for (int slot = 0; slot < BUFFER_TARGET_COUNT; ++slot) {
+		glGetIntegerv(BUFFER_BINDINGS[slot], &value);
+		verified = matches("buffer binding", static_cast<GLint>(shadow.buffers[slot]), value) && verified;
+	}
+	glGetIntegerv(GL_ACTIVE_TEXTURE, &value);
+	verified = matches("GL_ACTIVE_TEXTURE", shadow.activeUnit == UNKNOWN_VALUE ? UNKNOWN_VALUE : static_cast<GLint>(GL_TEXTURE0 + shadow.activeUnit), value) && verified;
+	if (shadow.activeUnit != UNKNOWN_VALUE) {
+		// Texture bindings are per unit, so each query goes through the real active texture entry point.
+		const PFNGLACTIVETEXTUREPROC activeTexture = installed ? realActiveTexture : glad_glActiveTexture;
+		GLint unitCount = 0;
+		glGetIntegerv(GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS, &unitCount);
+		for (int unit = 0; unit < TEXTURE_UNIT_COUNT && unit < unitCount; ++unit) {
+			activeTexture(GL_TEXTURE0 + unit);
+			for (int slot = 0; slot < TEXTURE_TARGET_COUNT; ++slot) {
+				glGetIntegerv(TEXTURE_BINDINGS[slot], &value);
+				verified = matches("texture binding", static_cast<GLint>(shadow.textures[unit][slot]), value) && verified;
+			}
+		}
+		activeTexture(GL_TEXTURE0 + shadow.activeUnit);
+	}
+	for (int slot = 0; slot < CAPABILITY_COUNT; ++slot) {
+		verified = matches("capability", shadow.enabled[slot], glIsEnabled(CAPABILITIES[slot])) && verified;
+	}
+	glGetIntegerv(GL_DEPTH_FUNC, &value);
+	verified = matches("GL_DEPTH_FUNC", shadow.depthFunc, value) && verified;
+	GLboolean depthMask = GL_FALSE;
+	glGetBooleanv(GL_DEPTH_WRITEMASK, &depthMask);
+	verified = matches("GL_DEPTH_WRITEMASK", shadow.depthMask, depthMask) && verified;
+	const GLenum blendQueries[4] = { GL_BLEND_SRC_RGB, GL_BLEND_DST_RGB, GL_BLEND_SRC_ALPHA, GL_BLEND_DST_ALPHA };
+	for (int i = 0; i < 4; ++i) {
+		glGetIntegerv(blendQueries[i], &value);
+		verified = matches("blend factor", shadow.blendFunc[i], value) && verified;
+	}
+	glGetIntegerv(GL_CULL_FACE_MODE, &value);
+	verified = matches("GL_CULL_FACE_MODE", shadow.cullFace, value) && verified;
+	if (shadow.viewportKnown) {
+		GLint viewport[4];
+		glGetIntegerv(GL_VIEWPORT, viewport);
+		for (int i = 0; i < 4; ++i) verified = matches("GL_VIEWPORT", shadow.viewport[i], viewport[i]) && verified;
+	}
+	return verified;
+}
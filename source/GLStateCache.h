@@ -0,0 +1,26 @@
+#pragma once
+#include <glad/glad.h>
+#include <cstddef>
+
+struct GLStateStatistics {
+	std::size_t issued;
+	std::size_t elided;
+};
+
+// Swaps glad's pointers for the program, vertex array, buffer, texture, active unit, enable,
+// depth, blend, cull face and viewport entry points with wrappers that shadow the state and drop
+// calls that would not change it, so every caller goes through the cache without edits. Deleting a
+// bound vertex array, buffer or texture resets its shadow the way GL resets the binding. Install
+// once the context is current and loaded; state the shadow has not seen starts out unknown.
+void installGLStateCache();
+void uninstallGLStateCache();
+// For code that changes state behind glad's back, such as another library sharing the context.
+void invalidateGLStateCache();
+
+// Counts cover the wrapped calls since the last endGLStateFrame(), which moves them into
+// glStateStatistics().
+void endGLStateFrame();
+const GLStateStatistics& glStateStatistics();
+void reportGLStateCache();
+// Compares every shadowed value the cache knows against glGet queries, printing mismatches.
+bool verifyGLStateCache();
@@ -0,0 +1,69 @@
+#include "InstanceBuffer.h"
+#include <glad/glad.h>
+
+InstanceBuffer::InstanceBuffer() : buffer(0), capacity(0), instanceCount(0) {}
+
+// A mat4 attribute occupies four consecutive locations, one column each.
+void InstanceBuffer::create(const unsigned vertexArray, const unsigned firstAttribute, const std::size_t capacity) {
+	glGenBuffers(1, &buffer);
+	glBindVertexArray(vertexArray);
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+	this->capacity = 0;
+	reserve(capacity);
+	for (unsigned column = 0; column < 4; ++column) {
+		glEnableVertexAttribArray(firstAttribute + column);
+		glVertexAttribPointer(firstAttribute + column, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), reinterpret_cast<void*>(column * sizeof(glm::vec4)));
+		glVertexAttribDivisor(firstAttribute + column, 1);
+	}
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	instanceCount = 0;
+}
+
+void InstanceBuffer::reserve(const std::size_t count) {
+	if (count > capacity) capacity = count;
+	glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(glm::mat4), NULL, GL_STREAM_DRAW);
+}
+
+void InstanceBuffer::update(const glm::mat4* matrices, const std::size_t count) {
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+	reserve(count);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, count * sizeof(glm::mat4), matrices);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	instanceCount = count;
+}
+
+// Lets callers compose matrices straight into driver memory instead of through a staging array.
+glm::mat4* InstanceBuffer::map(const std::size_t count) {
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+	if (count > capacity) reserve(count);
+	instanceCount = count;
+	if (count == 0) return NULL;
+	return static_cast<glm::mat4*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, count * sizeof(glm::mat4), GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+}
+
+void InstanceBuffer::unmap() {
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+	if (instanceCount > 0 && !glUnmapBuffer(GL_ARRAY_BUFFER)) instanceCount = 0;
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// The vertex array this buffer was created for must be bound.
+void InstanceBuffer::drawArrays(const unsigned mode, const int vertexCount) const {
+	if (instanceCount > 0) glDrawArraysInstanced(mode, 0, vertexCount, static_cast<int>(instanceCount));
+}
+
+void InstanceBuffer::drawElements(const unsigned mode, const int indexCount, const unsigned indexType) const {
+	if (instanceCount > 0) glDrawElementsInstanced(mode, indexCount, indexType, NULL, static_cast<int>(instanceCount));
+}
+
+std::size_t InstanceBuffer::count() const {
+	return instanceCount;
+}
+
+void InstanceBuffer::destroy() {
+	glDeleteBuffers(1, &buffer);
+	buffer = 0;
+	capacity = 0;
+	instanceCount = 0;
+}
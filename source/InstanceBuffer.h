@@ -0,0 +1,27 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <cstddef>
+
+// Per-instance model matrices streamed into a GL_ARRAY_BUFFER that feeds four vec4 attributes
+// with a divisor of 1. Every update orphans the previous storage, so writing never waits on
+// draws still reading last frame's matrices.
+class InstanceBuffer {
+public:
+	InstanceBuffer();
+
+	void create(const unsigned vertexArray, const unsigned firstAttribute, const std::size_t capacity);
+	void update(const glm::mat4* matrices, const std::size_t count);
+	glm::mat4* map(const std::size_t count);
+	void unmap();
+	void drawArrays(const unsigned mode, const int vertexCount) const;
+	void drawElements(const unsigned mode, const int indexCount, const unsigned indexType) const;
+	std::size_t count() const;
+	void destroy();
+
+private:
+	void reserve(const std::size_t count);
+
+	unsigned buffer;
+	std::size_t capacity;
+	std::size_t instanceCount;
+};
@@ -0,0 +1,194 @@
+#include "JobSystem.h"
+#include <cstring>
+
+namespace {
+	const int SPINS_BEFORE_SLEEP = 64;
+
+	// Which system and slot the calling thread belongs to; set by create() and each worker.
+	thread_local const JobSystem* currentSystem = NULL;
+	thread_local unsigned currentIndex = 0;
+}
+
+WorkStealingQueue::WorkStealingQueue() : top(0), bottom(0) {
+	for (std::int64_t i = 0; i < CAPACITY; ++i) jobs[i].store(NULL, std::memory_order_relaxed);
+}
+
+// The orderings follow Le et al.'s C11 Chase-Lev deque, with its standalone fences folded into
+// sequentially consistent accesses, which ThreadSanitizer can follow.
+bool WorkStealingQueue::push(Job* job) {
+	const std::int64_t b = bottom.load(std::memory_order_relaxed);
+	const std::int64_t t = top.load(std::memory_order_acquire);
+	if (b - t >= CAPACITY) return false;
+	jobs[b & (CAPACITY - 1)].store(job, std::memory_order_relaxed);
+	bottom.store(b + 1, std::memory_order_release);
+	return true;
+}
+
+Job* WorkStealingQueue::pop() {
+	const std::int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+	bottom.store(b, std::memory_order_seq_cst);
+	std::int64_t t = top.load(std::memory_order_seq_cst);
+	if (t > b) {
+		bottom.store(b + 1, std::memory_order_relaxed);
+		return NULL;
+	}
+	Job* job = jobs[b & (CAPACITY - 1)].load(std::memory_order_relaxed);
+	if (t == b) {
+		// The last job: whoever moves top past it first gets it.
+		if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) job = NULL;
+		bottom.store(b + 1, std::memory_order_relaxed);
+	}
+	return job;
+}
+
+Job* WorkStealingQueue::steal() {
+	std::int64_t t = top.load(std::memory_order_seq_cst);
+	const std::int64_t b = bottom.load(std::memory_order_seq_cst);
+	if (t >= b) return NULL;
+	Job* job = jobs[t & (CAPACITY - 1)].load(std::memory_order_relaxed);
+	if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) return NULL;
+	return job;
+}
+
+JobSystem::JobSystem() : stopping(false), workEpoch(0), sleepingWorkers(0) {}
+
+void JobSystem::create(unsigned workerCount) {
+	if (workerCount == 0) workerCount = std::thread::hardware_concurrency() > 1 ? std::thread::hardware_concurrency() - 1 : 0;
+	stopping.store(false);
+	for (unsigned i = 0; i <= workerCount; ++i) {
+		ThreadState* thread = new ThreadState;
+		thread->jobBlocks.emplace_back(new Job[JOBS_PER_BLOCK]());
+		thread->nextJob = 0;
+		thread->index = i;
+		threads.push_back(thread);
+	}
+	currentSystem = this;
+	currentIndex = 0;
+	for (unsigned i = 1; i <= workerCount; ++i) workers.emplace_back(&JobSystem::workerLoop, this, i);
+}
+
+void JobSystem::destroy() {
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		stopping.store(true);
+	}
+	wakeWorkers.notify_all();
+	for (std::thread& worker : workers) worker.join();
+	workers.clear();
+	for (ThreadState* thread : threads) delete thread;
+	threads.clear();
+	if (currentSystem == this) currentSystem = NULL;
+}
+
+unsigned JobSystem::threadCount() const {
+	return static_cast<unsigned>(threads.size());
+}
+
+JobSystem::ThreadState& JobSystem::currentThread() {
+	return *threads[currentSystem == this ? currentIndex : 0];
+}
+
+// Slots are handed out in turn, skipping any whose job has not finished, such as a parallelFor
+// root still waiting on its children. When every slot is taken the thread gets a new block, so
+// any number of jobs can be in flight; blocks are only freed by destroy().
+Job* JobSystem::allocateJob() {
+	ThreadState& thread = currentThread();
+	const std::size_t slotCount = thread.jobBlocks.size() * JOBS_PER_BLOCK;
+	for (std::size_t tried = 0; tried < slotCount; ++tried) {
+		const std::size_t slot = thread.nextJob;
+		thread.nextJob = (slot + 1) % slotCount;
+		Job* job = &thread.jobBlocks[slot / JOBS_PER_BLOCK][slot % JOBS_PER_BLOCK];
+		if (job->unfinishedJobs.load(std::memory_order_acquire) == 0) return job;
+	}
+	thread.jobBlocks.emplace_back(new Job[JOBS_PER_BLOCK]());
+	thread.nextJob = slotCount + 1;
+	return &thread.jobBlocks.back()[0];
+}
+
+Job* JobSystem::createJob(JobFunction function, const void* data, const std::size_t bytes) {
+	Job* job = allocateJob();
+	job->function = function;
+	job->parent = NULL;
+	job->unfinishedJobs.store(1, std::memory_order_relaxed);
+	if (bytes > 0) std::memcpy(job->data, data, bytes < JOB_DATA_BYTES ? bytes : JOB_DATA_BYTES);
+	return job;
+}
+
+// The parent cannot finish in between, since it is still running or has not been run yet.
+Job* JobSystem::createChildJob(Job* parent, JobFunction function, const void* data, const std::size_t bytes) {
+	parent->unfinishedJobs.fetch_add(1, std::memory_order_relaxed);
+	Job* job = createJob(function, data, bytes);
+	job->parent = parent;
+	return job;
+}
+
+// Bumping the epoch before checking for sleepers pairs with workers counting themselves as
+// sleeping before checking the epoch, so one side always sees the other and no wakeup is lost.
+void JobSystem::run(Job* job) {
+	if (!currentThread().queue.push(job)) {
+		execute(job);
+		return;
+	}
+	workEpoch.fetch_add(1, std::memory_order_seq_cst);
+	if (sleepingWorkers.load(std::memory_order_seq_cst) > 0) {
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		wakeWorkers.notify_all();
+	}
+}
+
+void JobSystem::wait(const Job* job) {
+	ThreadState& thread = currentThread();
+	while (job->unfinishedJobs.load(std::memory_order_acquire) > 0) {
+		Job* next = findJob(thread);
+		if (next) execute(next);
+		else std::this_thread::yield();
+	}
+}
+
+Job* JobSystem::findJob(ThreadState& thread) {
+	Job* job = thread.queue.pop();
+	if (job) return job;
+	const std::size_t count = threads.size();
+	for (std::size_t offset = 1; offset < count; ++offset) {
+		job = threads[(thread.index + offset) % count]->queue.steal();
+		if (job) return job;
+	}
+	return NULL;
+}
+
+void JobSystem::execute(Job* job) {
+	job->function(job, job->data);
+	finish(job);
+}
+
+// parent is read first: once the count reaches zero the creating thread may reuse the slot.
+void JobSystem::finish(Job* job) {
+	Job* parent = job->parent;
+	const int unfinished = job->unfinishedJobs.fetch_sub(1, std::memory_order_acq_rel) - 1;
+	if (unfinished == 0 && parent) finish(parent);
+}
+
+void JobSystem::workerLoop(const unsigned index) {
+	currentSystem = this;
+	currentIndex = index;
+	ThreadState& thread = *threads[index];
+	int idleSpins = 0;
+	while (!stopping.load(std::memory_order_relaxed)) {
+		const unsigned epoch = workEpoch.load(std::memory_order_seq_cst);
+		Job* job = findJob(thread);
+		if (job) {
+			execute(job);
+			idleSpins = 0;
+			continue;
+		}
+		if (++idleSpins < SPINS_BEFORE_SLEEP) {
+			std::this_thread::yield();
+			continue;
+		}
+		std::unique_lock<std::mutex> lock(sleepMutex);
+		sleepingWorkers.fetch_add(1, std::memory_order_seq_cst);
+		wakeWorkers.wait(lock, [&]() { return stopping.load() || workEpoch.load(std::memory_order_seq_cst) != epoch; });
+		sleepingWorkers.fetch_sub(1, std::memory_order_seq_cst);
+		idleSpins = 0;
+	}
+}
@@ -0,0 +1,131 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct Job;
+typedef void (*JobFunction)(Job* job, const void* data);
+
+const std::size_t JOB_DATA_BYTES = 40;
+
+// A job finishes once its function has returned and every child created under it has finished,
+// which is what waiting on a parent means. Up to JOB_DATA_BYTES of payload are copied in at
+// creation, so a job is one cache line.
+struct alignas(64) Job {
+	JobFunction function;
+	Job* parent;
+	std::atomic<int> unfinishedJobs;
+	unsigned char data[JOB_DATA_BYTES];
+};
+
+// Chase-Lev deque: the owning thread pushes and pops at the bottom, thieves take from the top.
+// The capacity is fixed; push fails when it is full and the caller runs the job itself.
+class WorkStealingQueue {
+public:
+	WorkStealingQueue();
+
+	bool push(Job* job);
+	Job* pop();
+	Job* steal();
+
+private:
+	static const std::int64_t CAPACITY = 4096;
+
+	std::atomic<std::int64_t> top;
+	std::atomic<std::int64_t> bottom;
+	std::atomic<Job*> jobs[CAPACITY];
+};
+
+// A fixed pool of workers plus the thread that called create(), each with its own deque and
+// blocks of jobs. Jobs can only be created and run from those threads. A thread that waits keeps
+// running jobs (its own first, then stolen ones) until the job it waits for has finished.
+// Idle workers spin briefly and then sleep until more work is run.
+class JobSystem {
+public:
+	JobSystem();
+
+	// workerCount 0 uses one worker per core besides the calling thread.
+	void create(unsigned workerCount = 0);
+	void destroy();
+	unsigned threadCount() const;
+
+	Job* createJob(JobFunction function, const void* data = NULL, const std::size_t bytes = 0);
+	Job* createChildJob(Job* parent, JobFunction function, const void* data = NULL, const std::size_t bytes = 0);
+	void run(Job* job);
+	void wait(const Job* job);
+
+private:
+	struct alignas(64) ThreadState {
+		WorkStealingQueue queue;
+		std::vector<std::unique_ptr<Job[]>> jobBlocks;
+		std::size_t nextJob;
+		unsigned index;
+	};
+
+	// Each thread starts with one block of jobs and adds another whenever all of its slots hold
+	// jobs that have not finished.
+	static const std::size_t JOBS_PER_BLOCK = 4096;
+
+	ThreadState& currentThread();
+	Job* allocateJob();
+	Job* findJob(ThreadState& thread);
+	void execute(Job* job);
+	void finish(Job* job);
+	void workerLoop(const unsigned index);
+
+	std::vector<ThreadState*> threads;
+	std::vector<std::thread> workers;
+	std::atomic<bool> stopping;
+	std::atomic<unsigned> workEpoch;
+	std::atomic<unsigned> sleepingWorkers;
+	std::mutex sleepMutex;
+	std::condition_variable wakeWorkers;
+};
+
+namespace jobdetail {
+	template <typename Body>
+	struct ParallelForRange {
+		const Body* body;
+		std::size_t begin;
+		std::size_t end;
+		std::size_t grain;
+		JobSystem* system;
+	};
+
+	// Splits the range in half until it is no bigger than the grain, so the first halves to be
+	// stolen are the biggest ones.
+	template <typename Body>
+	void parallelForJob(Job* job, const void* data) {
+		ParallelForRange<Body> range = *static_cast<const ParallelForRange<Body>*>(data);
+		while (range.end - range.begin > range.grain) {
+			const std::size_t middle = range.begin + (range.end - range.begin) / 2;
+			ParallelForRange<Body> right = range;
+			right.begin = middle;
+			range.end = middle;
+			range.system->run(range.system->createChildJob(job, parallelForJob<Body>, &right, sizeof(right)));
+		}
+		(*range.body)(range.begin, range.end);
+	}
+}
+
+// Calls body(begin, end) over [0, count) in chunks and returns once every chunk has run. grain 0
+// picks chunks that give each thread about eight, so stealing can even out uneven work.
+template <typename Body>
+void parallelFor(JobSystem& system, const std::size_t count, const Body& body, std::size_t grain = 0) {
+	if (count == 0) return;
+	if (grain == 0) grain = count / (8 * system.threadCount()) + 1;
+	if (count <= grain || system.threadCount() == 1) {
+		body(std::size_t(0), count);
+		return;
+	}
+	static_assert(sizeof(jobdetail::ParallelForRange<Body>) <= JOB_DATA_BYTES, "a range must fit in a job");
+	const jobdetail::ParallelForRange<Body> range = { &body, 0, count, grain, &system };
+	Job* root = system.createJob(jobdetail::parallelForJob<Body>, &range, sizeof(range));
+	system.run(root);
+	system.wait(root);
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+// Bounded multi-producer/multi-consumer ring (Vyukov). Each cell carries a sequence number that tells
+// producers and consumers whether it is free for the current lap, so neither side ever takes a lock.
+template <typename T>
+class LockFreeQueue {
+public:
+	explicit LockFreeQueue(const std::size_t minimumCapacity) : mask(0), enqueuePosition(0), dequeuePosition(0) {
+		std::size_t capacity = 2;
+		while (capacity < minimumCapacity) capacity <<= 1;
+		cells.reset(new Cell[capacity]);
+		mask = capacity - 1;
+		for (std::size_t i = 0; i < capacity; ++i) cells[i].sequence.store(i, std::memory_order_relaxed);
+	}
+
+	bool push(const T& value) {
+		return pushValue(value);
+	}
+
+	// value is only moved from when the push succeeds, so a full queue can be retried with it.
+	bool push(T&& value) {
+		return pushValue(std::move(value));
+	}
+
+	bool pop(T& value) {
+		std::size_t position = dequeuePosition.load(std::memory_order_relaxed);
+		for (;;) {
+			Cell& cell = cells[position & mask];
+			const std::size_t sequence = cell.sequence.load(std::memory_order_acquire);
+			const std::ptrdiff_t difference = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position + 1);
+			if (difference == 0) {
+				if (dequeuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+					value = std::move(cell.value);
+					cell.sequence.store(position + mask + 1, std::memory_order_release);
+					return true;
+				}
+			} else if (difference < 0) {
+				return false;
+			} else {
+				position = dequeuePosition.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+private:
+	template <typename Value>
+	bool pushValue(Value&& value) {
+		std::size_t position = enqueuePosition.load(std::memory_order_relaxed);
+		for (;;) {
+			Cell& cell = cells[position & mask];
+			const std::size_t sequence = cell.sequence.load(std::memory_order_acquire);
+			const std::ptrdiff_t difference = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+			if (difference == 0) {
+				if (enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+					cell.value = std::forward<Value>(value);
+					cell.sequence.store(position + 1, std::memory_order_release);
+					return true;
+				}
+			} else if (difference < 0) {
+				return false;
+			} else {
+				position = enqueuePosition.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	struct Cell {
+		std::atomic<std::size_t> sequence;
+		T value;
+	};
+
+	std::unique_ptr<Cell[]> cells;
+	std::size_t mask;
+	alignas(64) std::atomic<std::size_t> enqueuePosition;
+	alignas(64) std::atomic<std::size_t> dequeuePosition;
+};
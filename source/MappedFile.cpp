@@ -0,0 +1,108 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+MappedFile::MappedFile() : mapping(NULL), length(0), fileHandle(INVALID_HANDLE_VALUE), mappingHandle(NULL) {}
+#else
+MappedFile::MappedFile() : mapping(NULL), length(0), fileDescriptor(-1) {}
+#endif
+
+MappedFile::~MappedFile() {
+	close();
+}
+
+bool MappedFile::open(const char* path) {
+	close();
+#ifdef _WIN32
+	fileHandle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (fileHandle == INVALID_HANDLE_VALUE) return false;
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart == 0) {
+		close();
+		return false;
+	}
+	length = static_cast<std::size_t>(fileSize.QuadPart);
+	mappingHandle = CreateFileMappingA(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mappingHandle) mapping = static_cast<const unsigned char*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+#else
+	fileDescriptor = ::open(path, O_RDONLY);
+	if (fileDescriptor < 0) return false;
+	struct stat fileStatus;
+	if (fstat(fileDescriptor, &fileStatus) != 0 || fileStatus.st_size == 0) {
+		close();
+		return false;
+	}
+	length = static_cast<std::size_t>(fileStatus.st_size);
+	void* view = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+	if (view != MAP_FAILED) mapping = static_cast<const unsigned char*>(view);
+#endif
+	if (!mapping) {
+		close();
+		return false;
+	}
+	return true;
+}
+
+void MappedFile::close() {
+#ifdef _WIN32
+	if (mapping) UnmapViewOfFile(mapping);
+	if (mappingHandle) CloseHandle(mappingHandle);
+	if (fileHandle != INVALID_HANDLE_VALUE) CloseHandle(fileHandle);
+	mappingHandle = NULL;
+	fileHandle = INVALID_HANDLE_VALUE;
+#else
+	if (mapping) munmap(const_cast<unsigned char*>(mapping), length);
+	if (fileDescriptor >= 0) ::close(fileDescriptor);
+	fileDescriptor = -1;
+#endif
+	mapping = NULL;
+	length = 0;
+}
+
+void MappedFile::prefetch() const {
+	if (!mapping) return;
+#ifdef _WIN32
+	WIN32_MEMORY_RANGE_ENTRY range = { const_cast<unsigned char*>(mapping), length };
+	PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#else
+	madvise(const_cast<unsigned char*>(mapping), length, MADV_WILLNEED);
+#endif
+	volatile unsigned char touched = 0;
+	for (std::size_t offset = 0; offset < length; offset += 4096) touched ^= mapping[offset];
+}
+
+const unsigned char* MappedFile::data() const {
+	return mapping;
+}
+
+std::size_t MappedFile::size() const {
+	return length;
+}
+
+bool evictFromFileCache(const char* path) {
+#ifdef _WIN32
+	// Opening a file without buffering makes the cache manager flush and purge its cached pages.
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_FLAG_NO_BUFFERING, NULL);
+	if (file == INVALID_HANDLE_VALUE) return false;
+	CloseHandle(file);
+	return true;
+#else
+	const int descriptor = ::open(path, O_RDONLY);
+	if (descriptor < 0) return false;
+	// Dirty pages are not dropped, so write back anything a cooker just produced first.
+	fdatasync(descriptor);
+	const bool evicted = posix_fadvise(descriptor, 0, 0, POSIX_FADV_DONTNEED) == 0;
+	::close(descriptor);
+	return evicted;
+#endif
+}
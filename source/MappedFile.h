@@ -0,0 +1,31 @@
+#pragma once
+#include <cstddef>
+
+// Read-only memory mapping of a whole file (MapViewOfFile on Windows, mmap elsewhere).
+class MappedFile {
+public:
+	MappedFile();
+	~MappedFile();
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool open(const char* path);
+	void close();
+	void prefetch() const;
+	const unsigned char* data() const;
+	std::size_t size() const;
+
+private:
+	const unsigned char* mapping;
+	std::size_t length;
+#ifdef _WIN32
+	void* fileHandle;
+	void* mappingHandle;
+#else
+	int fileDescriptor;
+#endif
+};
+
+// Drops the file's pages from the OS file cache so the next read comes from disk; benchmarks use it
+// to time cold loads. Returns false if the file could not be opened.
+bool evictFromFileCache(const char* path);
@@ -0,0 +1,185 @@
+#include "MeshBuilder.h"
+#include "MeshOptimizer.h"
+#include <glad/glad.h>
+#include <cstring>
+#include <iostream>
+
+namespace {
+	const std::uint32_t EMPTY_SLOT = 0xFFFFFFFFu;
+}
+
+int IndexedMesh::floatsPerVertex() const {
+	int floats = 0;
+	for (int size : attributeSizes) floats += size;
+	return floats;
+}
+
+std::size_t IndexedMesh::vertexCount() const {
+	const int floats = floatsPerVertex();
+	return floats ? vertices.size() / floats : 0;
+}
+
+bool IndexedMesh::fitsShortIndices() const {
+	return vertexCount() <= 0x10000;
+}
+
+MeshBuilder::MeshBuilder(const std::string& name, const std::vector<int>& attributeSizes) : stride(0), table(64, Slot{ EMPTY_SLOT, 0 }), uniqueVertexCount(0), inputVertexCount(0), submeshStart(0) {
+	mesh.name = name;
+	mesh.attributeSizes = attributeSizes;
+	stride = mesh.floatsPerVertex();
+	normalized.resize(stride);
+}
+
+// Mixes whole 32-bit words rather than bytes; the vertex is already normalized, so equal values
+// always hash equally.
+std::uint32_t MeshBuilder::hashVertex(const float* vertex) const {
+	std::uint64_t hash = 14695981039346656037ull;
+	for (int i = 0; i < stride; ++i) {
+		std::uint32_t word;
+		std::memcpy(&word, vertex + i, sizeof(word));
+		hash = (hash ^ word) * 0x9E3779B97F4A7C15ull;
+	}
+	return static_cast<std::uint32_t>(hash >> 32);
+}
+
+void MeshBuilder::growTable() {
+	std::vector<Slot> grown(table.size() * 2, Slot{ EMPTY_SLOT, 0 });
+	const std::size_t mask = grown.size() - 1;
+	for (const Slot& entry : table) {
+		if (entry.index == EMPTY_SLOT) continue;
+		std::size_t slot = entry.hash & mask;
+		while (grown[slot].index != EMPTY_SLOT) slot = (slot + 1) & mask;
+		grown[slot] = entry;
+	}
+	table.swap(grown);
+}
+
+std::uint32_t MeshBuilder::addVertex(const float* vertex) {
+	for (int i = 0; i < stride; ++i) normalized[i] = (vertex[i] == 0.0f) ? 0.0f : vertex[i];
+
+	// Slots carry the hash next to the index, so probing past other vertices never touches them.
+	const std::uint32_t hash = hashVertex(normalized.data());
+	const std::size_t mask = table.size() - 1;
+	std::size_t slot = hash & mask;
+	while (table[slot].index != EMPTY_SLOT) {
+		const std::uint32_t candidate = table[slot].index;
+		if (table[slot].hash == hash && std::memcmp(&mesh.vertices[static_cast<std::size_t>(candidate) * stride], normalized.data(), stride * sizeof(float)) == 0) {
+			mesh.indices.push_back(candidate);
+			return candidate;
+		}
+		slot = (slot + 1) & mask;
+	}
+
+	const std::uint32_t index = uniqueVertexCount++;
+	table[slot].index = index;
+	table[slot].hash = hash;
+	mesh.vertices.insert(mesh.vertices.end(), normalized.begin(), normalized.end());
+	mesh.indices.push_back(index);
+	if (static_cast<std::size_t>(uniqueVertexCount) * 2 > table.size()) growTable();
+	return index;
+}
+
+// The input indices are kept (offset per call) so the report can compare cache behaviour
+// before and after welding; an unindexed list always scores 3.
+void MeshBuilder::addTriangles(const float* vertices, const std::size_t vertexCount) {
+	for (std::size_t i = 0; i < vertexCount; ++i) {
+		inputIndices.push_back(inputVertexCount + static_cast<std::uint32_t>(i));
+		addVertex(vertices + i * stride);
+	}
+	inputVertexCount += static_cast<std::uint32_t>(vertexCount);
+}
+
+void MeshBuilder::addTriangles(const float* vertices, const std::uint32_t* indices, const std::size_t indexCount) {
+	std::uint32_t vertexCount = 0;
+	for (std::size_t i = 0; i < indexCount; ++i) {
+		inputIndices.push_back(inputVertexCount + indices[i]);
+		if (indices[i] >= vertexCount) vertexCount = indices[i] + 1;
+		addVertex(vertices + static_cast<std::size_t>(indices[i]) * stride);
+	}
+	inputVertexCount += vertexCount;
+}
+
+void MeshBuilder::beginSubmesh() {
+	if (mesh.indices.size() > submeshStart) mesh.submeshes.push_back({ static_cast<std::uint32_t>(submeshStart), static_cast<std::uint32_t>(mesh.indices.size() - submeshStart) });
+	submeshStart = mesh.indices.size();
+}
+
+IndexedMesh MeshBuilder::build(const bool report) {
+	beginSubmesh();
+	if (report) {
+		const std::size_t vertexCount = mesh.vertexCount();
+		const double reduction = inputVertexCount ? 100.0 * (inputVertexCount - vertexCount) / inputVertexCount : 0.0;
+		std::cout << "Mesh " << mesh.name << ": " << inputVertexCount << " -> " << vertexCount << " vertices (" << reduction << "% fewer), "
+			<< (mesh.fitsShortIndices() ? 16 : 32) << "-bit indices, ACMR " << simulateVertexCache(inputIndices.data(), inputIndices.size(), inputVertexCount, ACMR_CACHE_SIZE, CacheModel::Fifo).acmr << " -> "
+			<< simulateVertexCache(mesh.indices.data(), mesh.indices.size(), vertexCount, ACMR_CACHE_SIZE, CacheModel::Fifo).acmr << " (FIFO " << ACMR_CACHE_SIZE << ")" << '\n';
+	}
+
+	IndexedMesh result;
+	result.name = mesh.name;
+	result.attributeSizes = mesh.attributeSizes;
+	result.vertices.swap(mesh.vertices);
+	result.indices.swap(mesh.indices);
+	result.submeshes.swap(mesh.submeshes);
+	table.assign(64, Slot{ EMPTY_SLOT, 0 });
+	uniqueVertexCount = 0;
+	inputIndices.clear();
+	inputVertexCount = 0;
+	submeshStart = 0;
+	return result;
+}
+
+MeshBuffers createMeshBuffers(const void* vertices, const std::size_t vertexCount, const int stride, const std::vector<VertexAttributeLayout>& attributes, const void* indices, const std::size_t indexCount, const unsigned indexType) {
+	MeshBuffers buffers;
+	buffers.indexCount = static_cast<int>(indexCount);
+	buffers.indexType = indexType;
+	buffers.positionScale = glm::vec3(1.0f);
+	buffers.positionBias = glm::vec3(0.0f);
+
+	glGenVertexArrays(1, &buffers.vertexArray);
+	glBindVertexArray(buffers.vertexArray);
+
+	glGenBuffers(1, &buffers.vertexBuffer);
+	glBindBuffer(GL_ARRAY_BUFFER, buffers.vertexBuffer);
+	glBufferData(GL_ARRAY_BUFFER, vertexCount * stride, vertices, GL_STATIC_DRAW);
+	for (std::size_t attribute = 0; attribute < attributes.size(); ++attribute) {
+		const VertexAttributeLayout& layout = attributes[attribute];
+		glEnableVertexAttribArray(static_cast<unsigned>(attribute));
+		glVertexAttribPointer(static_cast<unsigned>(attribute), layout.components, layout.type, layout.normalized ? GL_TRUE : GL_FALSE, stride, reinterpret_cast<void*>(static_cast<std::size_t>(layout.offset)));
+	}
+
+	// The element array binding is VAO state, so it stays bound until the VAO is unbound.
+	glGenBuffers(1, &buffers.indexBuffer);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers.indexBuffer);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount * (indexType == GL_UNSIGNED_SHORT ? sizeof(std::uint16_t) : sizeof(std::uint32_t)), indices, GL_STATIC_DRAW);
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	return buffers;
+}
+
+MeshBuffers createMeshBuffers(const void* vertices, const std::size_t vertexCount, const int stride, const std::vector<VertexAttributeLayout>& attributes, const std::vector<std::uint32_t>& indices) {
+	if (vertexCount <= 0x10000) {
+		const std::vector<std::uint16_t> shortIndices(indices.begin(), indices.end());
+		return createMeshBuffers(vertices, vertexCount, stride, attributes, shortIndices.data(), shortIndices.size(), GL_UNSIGNED_SHORT);
+	}
+	return createMeshBuffers(vertices, vertexCount, stride, attributes, indices.data(), indices.size(), GL_UNSIGNED_INT);
+}
+
+MeshBuffers createMeshBuffers(const IndexedMesh& mesh) {
+	std::vector<VertexAttributeLayout> attributes;
+	int offset = 0;
+	for (int size : mesh.attributeSizes) {
+		attributes.push_back({ size, GL_FLOAT, false, offset });
+		offset += size * static_cast<int>(sizeof(float));
+	}
+	return createMeshBuffers(mesh.vertices.data(), mesh.vertexCount(), offset, attributes, mesh.indices);
+}
+
+void destroyMeshBuffers(MeshBuffers& buffers) {
+	glDeleteBuffers(1, &buffers.indexBuffer);
+	glDeleteBuffers(1, &buffers.vertexBuffer);
+	glDeleteVertexArrays(1, &buffers.vertexArray);
+	buffers.indexBuffer = buffers.vertexBuffer = buffers.vertexArray = 0;
+	buffers.indexCount = 0;
+}
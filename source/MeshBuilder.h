@@ -0,0 +1,87 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// A contiguous run of the index buffer drawn as one piece (a glTF primitive or an OBJ group).
+struct MeshRange {
+	std::uint32_t firstIndex;
+	std::uint32_t indexCount;
+};
+
+// Interleaved float vertices plus a triangle list. attributeSizes lists the float count of each
+// attribute in order, so {3, 2} is a position followed by a texture coordinate. submeshes covers
+// the index buffer in order, with one range for meshes that have no groups.
+struct IndexedMesh {
+	std::string name;
+	std::vector<int> attributeSizes;
+	std::vector<float> vertices;
+	std::vector<std::uint32_t> indices;
+	std::vector<MeshRange> submeshes;
+
+	int floatsPerVertex() const;
+	std::size_t vertexCount() const;
+	bool fitsShortIndices() const;
+};
+
+// Welds vertices whose attributes are bit-identical (after folding -0 into +0) through an
+// open-addressed hash table, so each unique vertex is stored once and referenced by index.
+class MeshBuilder {
+public:
+	MeshBuilder(const std::string& name, const std::vector<int>& attributeSizes);
+
+	void addTriangles(const float* vertices, const std::size_t vertexCount);
+	void addTriangles(const float* vertices, const std::uint32_t* indices, const std::size_t indexCount);
+	// Ends the current submesh; empty submeshes are dropped.
+	void beginSubmesh();
+	IndexedMesh build(const bool report = true);
+
+private:
+	struct Slot {
+		std::uint32_t index;
+		std::uint32_t hash;
+	};
+
+	std::uint32_t addVertex(const float* vertex);
+	std::uint32_t hashVertex(const float* vertex) const;
+	void growTable();
+
+	IndexedMesh mesh;
+	int stride;
+	std::vector<float> normalized;
+	std::vector<Slot> table;
+	std::uint32_t uniqueVertexCount;
+	std::vector<std::uint32_t> inputIndices;
+	std::uint32_t inputVertexCount;
+	std::size_t submeshStart;
+};
+
+// Object-space position = attribute * positionScale + positionBias, applied in VertexShader.txt;
+// float meshes use a scale of 1 and a bias of 0.
+struct MeshBuffers {
+	unsigned vertexArray;
+	unsigned vertexBuffer;
+	unsigned indexBuffer;
+	int indexCount;
+	unsigned indexType;
+	glm::vec3 positionScale;
+	glm::vec3 positionBias;
+};
+
+struct VertexAttributeLayout {
+	int components;
+	unsigned type;
+	bool normalized;
+	int offset;
+};
+
+// Uploads the vertices with one glVertexAttribPointer per layout entry, starting at attribute 0,
+// and the indices as they are (indexType is GL_UNSIGNED_SHORT or GL_UNSIGNED_INT). Nothing is
+// copied on the way, so the pointers can point straight into a mapped file.
+MeshBuffers createMeshBuffers(const void* vertices, const std::size_t vertexCount, const int stride, const std::vector<VertexAttributeLayout>& attributes, const void* indices, const std::size_t indexCount, const unsigned indexType);
+// As above, converting the indices to 16-bit first when every index fits.
+MeshBuffers createMeshBuffers(const void* vertices, const std::size_t vertexCount, const int stride, const std::vector<VertexAttributeLayout>& attributes, const std::vector<std::uint32_t>& indices);
+MeshBuffers createMeshBuffers(const IndexedMesh& mesh);
+void destroyMeshBuffers(MeshBuffers& buffers);
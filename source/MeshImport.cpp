@@ -0,0 +1,614 @@
+#include "MeshImport.h"
+#include "JobSystem.h"
+#include "MappedFile.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <utility>
+
+namespace {
+	const double POWERS_OF_TEN[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+	const int MAX_EXACT_POWER = 22;
+	const int MAX_MANTISSA_DIGITS = 19;
+
+	bool fail(std::string& error, const std::string& message) {
+		error = message;
+		return false;
+	}
+
+	bool isDigit(const char character) {
+		return static_cast<unsigned>(character - '0') < 10u;
+	}
+
+	const char* skipBlanks(const char* cursor, const char* end) {
+		while (cursor < end && (*cursor == ' ' || *cursor == '\t')) ++cursor;
+		return cursor;
+	}
+
+	const char* parseNumber(const char* cursor, const char* end, double& value) {
+		cursor = skipBlanks(cursor, end);
+		bool negative = false;
+		if (cursor < end && (*cursor == '-' || *cursor == '+')) negative = (*cursor++ == '-');
+
+		// Up to 19 significant digits are gathered into an integer and scaled once by an exact power of
+		// ten, which keeps the result within an ulp of a correctly rounded float.
+		std::uint64_t mantissa = 0;
+		int exponent = 0;
+		int digits = 0;
+		int significantDigits = 0;
+		for (; cursor < end && isDigit(*cursor); ++cursor, ++digits) {
+			if (significantDigits < MAX_MANTISSA_DIGITS) {
+				mantissa = mantissa * 10 + (*cursor - '0');
+				if (mantissa) ++significantDigits;
+			}
+			else {
+				++exponent;
+			}
+		}
+		if (cursor < end && *cursor == '.') {
+			for (++cursor; cursor < end && isDigit(*cursor); ++cursor, ++digits) {
+				if (significantDigits < MAX_MANTISSA_DIGITS) {
+					mantissa = mantissa * 10 + (*cursor - '0');
+					--exponent;
+					if (mantissa) ++significantDigits;
+				}
+			}
+		}
+		if (digits == 0) return NULL;
+
+		if (cursor + 1 < end && (*cursor == 'e' || *cursor == 'E')) {
+			const char* exponentCursor = cursor + 1;
+			bool negativeExponent = false;
+			if (*exponentCursor == '-' || *exponentCursor == '+') negativeExponent = (*exponentCursor++ == '-');
+			if (exponentCursor < end && isDigit(*exponentCursor)) {
+				int explicitExponent = 0;
+				for (; exponentCursor < end && isDigit(*exponentCursor); ++exponentCursor) explicitExponent = std::min(explicitExponent * 10 + (*exponentCursor - '0'), 10000);
+				exponent += negativeExponent ? -explicitExponent : explicitExponent;
+				cursor = exponentCursor;
+			}
+		}
+
+		double result = static_cast<double>(mantissa);
+		if (exponent < 0) result = (exponent >= -MAX_EXACT_POWER) ? result / POWERS_OF_TEN[-exponent] : result * std::pow(10.0, exponent);
+		else if (exponent > 0) result = (exponent <= MAX_EXACT_POWER) ? result * POWERS_OF_TEN[exponent] : result * std::pow(10.0, exponent);
+		value = negative ? -result : result;
+		return cursor;
+	}
+
+	// OBJ indices are 1-based, and negative values count back from the newest element.
+	const char* parseIndex(const char* cursor, const char* end, long long& value) {
+		bool negative = false;
+		if (cursor < end && (*cursor == '-' || *cursor == '+')) negative = (*cursor++ == '-');
+		if (cursor >= end || !isDigit(*cursor)) return NULL;
+		long long result = 0;
+		while (cursor < end && isDigit(*cursor)) result = result * 10 + (*cursor++ - '0');
+		value = negative ? -result : result;
+		return cursor;
+	}
+
+	bool resolveObjIndex(const long long index, const std::size_t count, std::size_t& resolved) {
+		const long long absolute = (index < 0) ? static_cast<long long>(count) + index : index - 1;
+		if (index == 0 || absolute < 0 || absolute >= static_cast<long long>(count)) return false;
+		resolved = static_cast<std::size_t>(absolute);
+		return true;
+	}
+
+	struct ObjCorner {
+		std::size_t position;
+		std::size_t textureCoordinate;
+		bool hasTextureCoordinate;
+	};
+
+	bool importObj(const MappedFile& file, MeshBuilder& builder, std::string& error) {
+		const char* cursor = reinterpret_cast<const char*>(file.data());
+		const char* const end = cursor + file.size();
+		std::vector<float> positions;
+		std::vector<float> textureCoordinates;
+		std::vector<ObjCorner> polygon;
+		float triangle[15];
+		std::size_t lineNumber = 0;
+
+		while (cursor < end) {
+			++lineNumber;
+			const char* lineEnd = static_cast<const char*>(std::memchr(cursor, '\n', end - cursor));
+			if (!lineEnd) lineEnd = end;
+			cursor = skipBlanks(cursor, lineEnd);
+
+			if (lineEnd - cursor > 2 && cursor[0] == 'v' && (cursor[1] == ' ' || cursor[1] == '\t')) {
+				float position[3];
+				const char* next = cursor + 1;
+				for (int axis = 0; axis < 3 && next; ++axis) next = parseFloat(next, lineEnd, position[axis]);
+				if (!next) {
+					return fail(error, "malformed vertex on line " + std::to_string(lineNumber));
+				}
+				positions.insert(positions.end(), position, position + 3);
+			}
+			else if (lineEnd - cursor > 3 && cursor[0] == 'v' && cursor[1] == 't' && (cursor[2] == ' ' || cursor[2] == '\t')) {
+				float textureCoordinate[2] = { 0.0f, 0.0f };
+				const char* next = parseFloat(cursor + 2, lineEnd, textureCoordinate[0]);
+				if (!next) {
+					return fail(error, "malformed texture coordinate on line " + std::to_string(lineNumber));
+				}
+				parseFloat(next, lineEnd, textureCoordinate[1]);
+				textureCoordinates.insert(textureCoordinates.end(), textureCoordinate, textureCoordinate + 2);
+			}
+			else if (lineEnd - cursor > 2 && cursor[0] == 'f' && (cursor[1] == ' ' || cursor[1] == '\t')) {
+				polygon.clear();
+				const char* next = skipBlanks(cursor + 1, lineEnd);
+				while (next < lineEnd && *next != '\r') {
+					long long positionIndex = 0, textureCoordinateIndex = 0, normalIndex = 0;
+					ObjCorner corner = { 0, 0, false };
+					next = parseIndex(next, lineEnd, positionIndex);
+					if (next && next < lineEnd && *next == '/') {
+						++next;
+						if (next < lineEnd && *next != '/') {
+							next = parseIndex(next, lineEnd, textureCoordinateIndex);
+							corner.hasTextureCoordinate = true;
+						}
+						if (next && next < lineEnd && *next == '/') next = parseIndex(next + 1, lineEnd, normalIndex);
+					}
+					if (!next || !resolveObjIndex(positionIndex, positions.size() / 3, corner.position)
+						|| (corner.hasTextureCoordinate && !resolveObjIndex(textureCoordinateIndex, textureCoordinates.size() / 2, corner.textureCoordinate))) {
+						return fail(error, "malformed or out of range face on line " + std::to_string(lineNumber));
+					}
+					polygon.push_back(corner);
+					next = skipBlanks(next, lineEnd);
+				}
+
+				// Polygons are fanned around their first corner.
+				for (std::size_t i = 2; i < polygon.size(); ++i) {
+					const ObjCorner* corners[3] = { &polygon[0], &polygon[i - 1], &polygon[i] };
+					for (int c = 0; c < 3; ++c) {
+						float* vertex = triangle + c * 5;
+						std::memcpy(vertex, &positions[corners[c]->position * 3], 3 * sizeof(float));
+						vertex[3] = corners[c]->hasTextureCoordinate ? textureCoordinates[corners[c]->textureCoordinate * 2] : 0.0f;
+						vertex[4] = corners[c]->hasTextureCoordinate ? textureCoordinates[corners[c]->textureCoordinate * 2 + 1] : 0.0f;
+					}
+					builder.addTriangles(triangle, 3);
+				}
+			}
+			else if ((lineEnd - cursor > 1 && (cursor[0] == 'o' || cursor[0] == 'g') && (cursor[1] == ' ' || cursor[1] == '\t'))
+				|| (lineEnd - cursor > 6 && std::memcmp(cursor, "usemtl", 6) == 0)) {
+				builder.beginSubmesh();
+			}
+			cursor = lineEnd + 1;
+		}
+		return true;
+	}
+
+	// Just enough JSON for glTF: a small DOM built by recursive descent over the mapped text.
+	struct JsonValue {
+		enum class Type { Null, Boolean, Number, String, Array, Object };
+
+		Type type = Type::Null;
+		double number = 0.0;
+		bool boolean = false;
+		std::string text;
+		std::vector<JsonValue> elements;
+		std::vector<std::pair<std::string, JsonValue>> members;
+
+		const JsonValue* find(const char* key) const {
+			for (const std::pair<std::string, JsonValue>& member : members) {
+				if (member.first == key) return &member.second;
+			}
+			return NULL;
+		}
+
+		const JsonValue* at(const std::size_t index) const {
+			return (type == Type::Array && index < elements.size()) ? &elements[index] : NULL;
+		}
+
+		double numberOr(const char* key, const double fallback) const {
+			const JsonValue* value = find(key);
+			return (value && value->type == Type::Number) ? value->number : fallback;
+		}
+	};
+
+	class JsonParser {
+	public:
+		JsonParser(const char* begin, const char* end) : cursor(begin), end(end) {}
+
+		bool parse(JsonValue& value) {
+			if (!parseValue(value, 0)) return false;
+			skipWhitespace();
+			return cursor == end;
+		}
+
+	private:
+		static const int MAX_DEPTH = 64;
+
+		void skipWhitespace() {
+			while (cursor < end && (*cursor == ' ' || *cursor == '\t' || *cursor == '\n' || *cursor == '\r')) ++cursor;
+		}
+
+		bool consume(const char* literal) {
+			const std::size_t length = std::strlen(literal);
+			if (static_cast<std::size_t>(end - cursor) < length || std::memcmp(cursor, literal, length) != 0) return false;
+			cursor += length;
+			return true;
+		}
+
+		bool parseString(std::string& text) {
+			if (cursor >= end || *cursor != '"') return false;
+			++cursor;
+			while (cursor < end && *cursor != '"') {
+				if (*cursor == '\\' && cursor + 1 < end) {
+					++cursor;
+					switch (*cursor) {
+					case 'n': text += '\n'; break;
+					case 't': text += '\t'; break;
+					case 'r': text += '\r'; break;
+					case 'b': text += '\b'; break;
+					case 'f': text += '\f'; break;
+					case 'u':
+						// Names and URIs glTF cares about are ASCII; other code points become '?'.
+						if (end - cursor < 5) return false;
+						text += '?';
+						cursor += 4;
+						break;
+					default: text += *cursor; break;
+					}
+					++cursor;
+				}
+				else {
+					text += *cursor++;
+				}
+			}
+			if (cursor >= end) return false;
+			++cursor;
+			return true;
+		}
+
+		bool parseValue(JsonValue& value, const int depth) {
+			skipWhitespace();
+			if (cursor >= end || depth > MAX_DEPTH) return false;
+
+			if (*cursor == '{') {
+				value.type = JsonValue::Type::Object;
+				++cursor;
+				skipWhitespace();
+				if (cursor < end && *cursor == '}') {
+					++cursor;
+					return true;
+				}
+				while (true) {
+					std::pair<std::string, JsonValue> member;
+					skipWhitespace();
+					if (!parseString(member.first)) return false;
+					skipWhitespace();
+					if (cursor >= end || *cursor++ != ':') return false;
+					if (!parseValue(member.second, depth + 1)) return false;
+					value.members.push_back(std::move(member));
+					skipWhitespace();
+					if (cursor < end && *cursor == ',') { ++cursor; continue; }
+					return cursor < end && *cursor++ == '}';
+				}
+			}
+			if (*cursor == '[') {
+				value.type = JsonValue::Type::Array;
+				++cursor;
+				skipWhitespace();
+				if (cursor < end && *cursor == ']') {
+					++cursor;
+					return true;
+				}
+				while (true) {
+					value.elements.emplace_back();
+					if (!parseValue(value.elements.back(), depth + 1)) return false;
+					skipWhitespace();
+					if (cursor < end && *cursor == ',') { ++cursor; continue; }
+					return cursor < end && *cursor++ == ']';
+				}
+			}
+			if (*cursor == '"') {
+				value.type = JsonValue::Type::String;
+				return parseString(value.text);
+			}
+			if (consume("true")) {
+				value.type = JsonValue::Type::Boolean;
+				value.boolean = true;
+				return true;
+			}
+			if (consume("false")) {
+				value.type = JsonValue::Type::Boolean;
+				return true;
+			}
+			if (consume("null")) return true;
+
+			// Doubles, since byte offsets past 2^24 would not survive a float.
+			const char* next = parseNumber(cursor, end, value.number);
+			if (!next) return false;
+			value.type = JsonValue::Type::Number;
+			cursor = next;
+			return true;
+		}
+
+		const char* cursor;
+		const char* end;
+	};
+
+	const int GLTF_BYTE = 5120;
+	const int GLTF_UNSIGNED_BYTE = 5121;
+	const int GLTF_SHORT = 5122;
+	const int GLTF_UNSIGNED_SHORT = 5123;
+	const int GLTF_UNSIGNED_INT = 5125;
+	const int GLTF_FLOAT = 5126;
+	const int GLTF_TRIANGLES = 4;
+	const std::uint32_t GLB_MAGIC = 0x46546C67;
+	const std::uint32_t GLB_JSON_CHUNK = 0x4E4F534A;
+	const std::uint32_t GLB_BINARY_CHUNK = 0x004E4942;
+
+	struct GltfBuffer {
+		const unsigned char* data;
+		std::size_t size;
+	};
+
+	struct GltfAccessor {
+		const unsigned char* data;
+		std::size_t count;
+		std::size_t stride;
+		int componentType;
+		int components;
+		bool normalized;
+	};
+
+	std::size_t gltfComponentSize(const int componentType) {
+		switch (componentType) {
+		case GLTF_BYTE: case GLTF_UNSIGNED_BYTE: return 1;
+		case GLTF_SHORT: case GLTF_UNSIGNED_SHORT: return 2;
+		case GLTF_UNSIGNED_INT: case GLTF_FLOAT: return 4;
+		default: return 0;
+		}
+	}
+
+	int gltfComponentCount(const std::string& type) {
+		if (type == "SCALAR") return 1;
+		if (type == "VEC2") return 2;
+		if (type == "VEC3") return 3;
+		if (type == "VEC4") return 4;
+		return 0;
+	}
+
+	float readGltfComponent(const unsigned char* source, const int componentType, const bool normalized) {
+		switch (componentType) {
+		case GLTF_FLOAT: { float value; std::memcpy(&value, source, sizeof(float)); return value; }
+		case GLTF_UNSIGNED_BYTE: return normalized ? *source / 255.0f : *source;
+		case GLTF_BYTE: { const float value = static_cast<float>(static_cast<std::int8_t>(*source)); return normalized ? std::max(value / 127.0f, -1.0f) : value; }
+		case GLTF_UNSIGNED_SHORT: { std::uint16_t value; std::memcpy(&value, source, 2); return normalized ? value / 65535.0f : value; }
+		case GLTF_SHORT: { std::int16_t value; std::memcpy(&value, source, 2); return normalized ? std::max(value / 32767.0f, -1.0f) : value; }
+		case GLTF_UNSIGNED_INT: { std::uint32_t value; std::memcpy(&value, source, 4); return static_cast<float>(value); }
+		default: return 0.0f;
+		}
+	}
+
+	// Indices are kept as integers all the way, since a float cannot hold every 32-bit index.
+	std::uint32_t readGltfIndex(const unsigned char* source, const int componentType) {
+		switch (componentType) {
+		case GLTF_UNSIGNED_BYTE: return *source;
+		case GLTF_UNSIGNED_SHORT: { std::uint16_t value; std::memcpy(&value, source, 2); return value; }
+		default: { std::uint32_t value; std::memcpy(&value, source, 4); return value; }
+		}
+	}
+
+	// JSON numbers arrive as doubles; a negative, fractional or huge size is malformed rather than
+	// something to cast.
+	bool readGltfSize(const JsonValue& object, const char* key, const double fallback, std::size_t& value) {
+		const double number = object.numberOr(key, fallback);
+		if (!(number >= 0.0) || number != std::floor(number) || number >= static_cast<double>(std::numeric_limits<std::size_t>::max())) return false;
+		value = static_cast<std::size_t>(number);
+		return true;
+	}
+
+	bool resolveGltfAccessor(const JsonValue& root, const std::vector<GltfBuffer>& buffers, const JsonValue& owner, const char* key, GltfAccessor& accessor, std::string& error) {
+		const JsonValue* accessors = root.find("accessors");
+		std::size_t index;
+		const JsonValue* description = (accessors && readGltfSize(owner, key, -1, index)) ? accessors->at(index) : NULL;
+		if (!description) return fail(error, "missing accessor");
+		if (description->find("sparse")) return fail(error, "sparse accessors are not supported");
+
+		const JsonValue* type = description->find("type");
+		const JsonValue* normalized = description->find("normalized");
+		accessor.componentType = static_cast<int>(description->numberOr("componentType", 0));
+		accessor.components = type ? gltfComponentCount(type->text) : 0;
+		accessor.normalized = normalized && normalized->boolean;
+		const std::size_t elementSize = gltfComponentSize(accessor.componentType) * accessor.components;
+		if (elementSize == 0) return fail(error, "unsupported accessor type");
+		if (!readGltfSize(*description, "count", 0, accessor.count)) return fail(error, "malformed accessor count");
+
+		const JsonValue* bufferViews = root.find("bufferViews");
+		std::size_t viewIndex;
+		const JsonValue* view = (bufferViews && readGltfSize(*description, "bufferView", -1, viewIndex)) ? bufferViews->at(viewIndex) : NULL;
+		if (!view) return fail(error, "accessors without a buffer view are not supported");
+		std::size_t bufferIndex;
+		if (!readGltfSize(*view, "buffer", -1, bufferIndex) || bufferIndex >= buffers.size()) return fail(error, "buffer view references a missing buffer");
+
+		const GltfBuffer& buffer = buffers[bufferIndex];
+		std::size_t viewOffset, viewLength, accessorOffset;
+		if (!readGltfSize(*view, "byteOffset", 0, viewOffset) || !readGltfSize(*view, "byteLength", 0, viewLength) || !readGltfSize(*description, "byteOffset", 0, accessorOffset)
+			|| !readGltfSize(*view, "byteStride", static_cast<double>(elementSize), accessor.stride)) return fail(error, "malformed buffer view or accessor offsets");
+		if (accessor.stride < elementSize) return fail(error, "byteStride is smaller than an element");
+		// Written as subtractions from checked sizes, so a huge count or offset cannot wrap around.
+		if (viewOffset > buffer.size || viewLength > buffer.size - viewOffset || accessorOffset > viewLength) return fail(error, "accessor runs past the end of its buffer");
+		if (accessor.count > 0 && (elementSize > viewLength - accessorOffset || accessor.count - 1 > (viewLength - accessorOffset - elementSize) / accessor.stride)) return fail(error, "accessor runs past the end of its buffer");
+
+		accessor.data = buffer.data + viewOffset + accessorOffset;
+		return true;
+	}
+
+	bool importGltf(const std::filesystem::path& path, const MappedFile& file, MeshBuilder& builder, std::string& error) {
+		const char* json = reinterpret_cast<const char*>(file.data());
+		std::size_t jsonSize = file.size();
+		GltfBuffer binaryChunk = { NULL, 0 };
+
+		std::uint32_t header[5];
+		if (file.size() >= sizeof(header) && (std::memcpy(header, file.data(), sizeof(header)), header[0] == GLB_MAGIC)) {
+			if (header[1] != 2 || header[2] > file.size() || header[4] != GLB_JSON_CHUNK || 20ull + header[3] > header[2]) return fail(error, "malformed .glb header");
+			json = reinterpret_cast<const char*>(file.data() + 20);
+			jsonSize = header[3];
+			const std::size_t binaryOffset = 20 + ((header[3] + 3) & ~3u);
+			std::uint32_t chunk[2];
+			if (binaryOffset + sizeof(chunk) <= header[2] && (std::memcpy(chunk, file.data() + binaryOffset, sizeof(chunk)), chunk[1] == GLB_BINARY_CHUNK)) {
+				if (binaryOffset + sizeof(chunk) + chunk[0] > header[2]) return fail(error, "malformed .glb binary chunk");
+				binaryChunk.data = file.data() + binaryOffset + sizeof(chunk);
+				binaryChunk.size = chunk[0];
+			}
+		}
+
+		JsonValue root;
+		JsonParser parser(json, json + jsonSize);
+		if (!parser.parse(root) || root.type != JsonValue::Type::Object) return fail(error, "malformed JSON");
+
+		// External buffers are mapped next to the .gltf; the first buffer of a .glb has no uri.
+		std::vector<std::unique_ptr<MappedFile>> bufferFiles;
+		std::vector<GltfBuffer> buffers;
+		const JsonValue* bufferList = root.find("buffers");
+		for (std::size_t i = 0; bufferList && i < bufferList->elements.size(); ++i) {
+			const JsonValue* uri = bufferList->elements[i].find("uri");
+			if (!uri) {
+				if (i != 0 || !binaryChunk.data) return fail(error, "buffer without a uri");
+				buffers.push_back(binaryChunk);
+				continue;
+			}
+			if (uri->text.compare(0, 5, "data:") == 0) return fail(error, "embedded data: buffers are not supported");
+			bufferFiles.emplace_back(new MappedFile());
+			const std::string bufferPath = (path.parent_path() / uri->text).string();
+			if (!bufferFiles.back()->open(bufferPath.c_str())) return fail(error, "could not map " + bufferPath);
+			buffers.push_back({ bufferFiles.back()->data(), bufferFiles.back()->size() });
+		}
+
+		std::vector<float> vertices;
+		std::vector<std::uint32_t> indices;
+		const JsonValue* meshes = root.find("meshes");
+		for (std::size_t m = 0; meshes && m < meshes->elements.size(); ++m) {
+			const JsonValue* primitives = meshes->elements[m].find("primitives");
+			for (std::size_t p = 0; primitives && p < primitives->elements.size(); ++p) {
+				const JsonValue& primitive = primitives->elements[p];
+				const JsonValue* attributes = primitive.find("attributes");
+				if (primitive.numberOr("mode", GLTF_TRIANGLES) != GLTF_TRIANGLES || !attributes || !attributes->find("POSITION")) continue;
+
+				GltfAccessor positions, textureCoordinates = { NULL, 0, 0, 0, 0, false };
+				if (!resolveGltfAccessor(root, buffers, *attributes, "POSITION", positions, error)) return false;
+				if (positions.components != 3) return fail(error, "POSITION must be VEC3");
+				const bool hasTextureCoordinates = attributes->find("TEXCOORD_0") != NULL;
+				if (hasTextureCoordinates && !resolveGltfAccessor(root, buffers, *attributes, "TEXCOORD_0", textureCoordinates, error)) return false;
+				if (hasTextureCoordinates && (textureCoordinates.components != 2 || textureCoordinates.count != positions.count)) return fail(error, "TEXCOORD_0 does not match POSITION");
+
+				vertices.resize(positions.count * 5);
+				const std::size_t positionComponentSize = gltfComponentSize(positions.componentType);
+				const std::size_t textureCoordinateComponentSize = gltfComponentSize(textureCoordinates.componentType);
+				for (std::size_t v = 0; v < positions.count; ++v) {
+					float* vertex = &vertices[v * 5];
+					for (int axis = 0; axis < 3; ++axis) vertex[axis] = readGltfComponent(positions.data + v * positions.stride + axis * positionComponentSize, positions.componentType, positions.normalized);
+					for (int component = 0; component < 2; ++component) {
+						vertex[3 + component] = hasTextureCoordinates ? readGltfComponent(textureCoordinates.data + v * textureCoordinates.stride + component * textureCoordinateComponentSize, textureCoordinates.componentType, textureCoordinates.normalized) : 0.0f;
+					}
+				}
+
+				if (primitive.find("indices")) {
+					GltfAccessor indexAccessor;
+					if (!resolveGltfAccessor(root, buffers, primitive, "indices", indexAccessor, error)) return false;
+					const int indexType = indexAccessor.componentType;
+					if (indexAccessor.components != 1 || (indexType != GLTF_UNSIGNED_BYTE && indexType != GLTF_UNSIGNED_SHORT && indexType != GLTF_UNSIGNED_INT)) return fail(error, "indices must be unsigned integer scalars");
+					indices.resize(indexAccessor.count);
+					for (std::size_t i = 0; i < indexAccessor.count; ++i) {
+						indices[i] = readGltfIndex(indexAccessor.data + i * indexAccessor.stride, indexType);
+						if (indices[i] >= positions.count) return fail(error, "index out of range");
+					}
+				}
+				else {
+					indices.resize(positions.count);
+					for (std::size_t i = 0; i < positions.count; ++i) indices[i] = static_cast<std::uint32_t>(i);
+				}
+				builder.beginSubmesh();
+				builder.addTriangles(vertices.data(), indices.data(), indices.size() - indices.size() % 3);
+			}
+		}
+		return true;
+	}
+
+	bool importMeshFile(const char* path, IndexedMesh& mesh, std::string& error) {
+		const std::filesystem::path filePath(path);
+		std::string extension = filePath.extension().string();
+		std::transform(extension.begin(), extension.end(), extension.begin(), [](const char character) { return static_cast<char>(std::tolower(static_cast<unsigned char>(character))); });
+
+		MappedFile file;
+		if (!file.open(path)) return fail(error, "could not map the file");
+		file.prefetch();
+
+		MeshBuilder builder(filePath.filename().string(), { 3, 2 });
+		bool imported = false;
+		if (extension == ".obj") imported = importObj(file, builder, error);
+		else if (extension == ".gltf" || extension == ".glb") imported = importGltf(filePath, file, builder, error);
+		else error = "unknown mesh extension " + extension;
+		if (!imported) return false;
+
+		mesh = builder.build(false);
+		return true;
+	}
+
+	void reportImport(const char* path, const IndexedMesh& mesh, const std::size_t fileBytes, const double milliseconds) {
+		std::cout << "Imported " << path << ": " << mesh.vertexCount() << " vertices, " << mesh.indices.size() / 3 << " triangles, "
+			<< fileBytes / (1024.0 * 1024.0) / (milliseconds / 1000.0) << " MB/s" << '\n';
+	}
+}
+
+const char* parseFloat(const char* cursor, const char* end, float& value) {
+	double number;
+	cursor = parseNumber(cursor, end, number);
+	if (cursor) value = static_cast<float>(number);
+	return cursor;
+}
+
+bool importMesh(const char* path, IndexedMesh& mesh, const bool report) {
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	std::string error;
+	if (!importMeshFile(path, mesh, error)) {
+		std::cout << "There was an error loading the mesh " << path << ':' << '\n' << error << '\n';
+		return false;
+	}
+	if (report) {
+		std::error_code sizeError;
+		const std::size_t fileBytes = static_cast<std::size_t>(std::filesystem::file_size(path, sizeError));
+		reportImport(path, mesh, sizeError ? 0 : fileBytes, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+	}
+	return true;
+}
+
+// Errors are collected and printed afterwards so output from different files never interleaves.
+std::size_t importMeshes(const std::vector<std::string>& paths, std::vector<IndexedMesh>& meshes, JobSystem* jobSystem, const bool report) {
+	meshes.assign(paths.size(), IndexedMesh());
+	std::vector<std::string> errors(paths.size());
+	std::vector<double> milliseconds(paths.size(), 0.0);
+
+	const auto importFiles = [&](const std::size_t begin, const std::size_t end) {
+		for (std::size_t i = begin; i < end; ++i) {
+			const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			if (!importMeshFile(paths[i].c_str(), meshes[i], errors[i]) && errors[i].empty()) errors[i] = "unknown error";
+			milliseconds[i] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		}
+	};
+	if (jobSystem) parallelFor(*jobSystem, paths.size(), importFiles, 1);
+	else importFiles(0, paths.size());
+
+	std::size_t loaded = 0;
+	for (std::size_t i = 0; i < paths.size(); ++i) {
+		if (!errors[i].empty()) {
+			std::cout << "There was an error loading the mesh " << paths[i] << ':' << '\n' << errors[i] << '\n';
+			continue;
+		}
+		++loaded;
+		if (report) {
+			std::error_code sizeError;
+			const std::size_t fileBytes = static_cast<std::size_t>(std::filesystem::file_size(paths[i], sizeError));
+			reportImport(paths[i].c_str(), meshes[i], sizeError ? 0 : fileBytes, milliseconds[i]);
+		}
+	}
+	return loaded;
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include "MeshBuilder.h"
+#include <cstddef>
+#include <string>
+#include <vector>
+
+class JobSystem;
+
+// Loads Wavefront .obj, glTF 2.0 .gltf (with external .bin buffers) and binary .glb files into the
+// welded {3, 2} position + texture coordinate layout. Files are memory-mapped and parsed in place;
+// every triangle goes straight into a MeshBuilder, so no intermediate text or token copies exist.
+// glTF node transforms are not applied, and only triangle-list primitives are read. Each glTF
+// primitive and each OBJ o/g/usemtl line starts a new submesh.
+bool importMesh(const char* path, IndexedMesh& mesh, const bool report = true);
+
+// Imports each file as its own job on jobSystem, or one after another on the calling thread
+// without one; meshes[i] belongs to paths[i] and stays empty if that file failed. Returns how
+// many files loaded.
+std::size_t importMeshes(const std::vector<std::string>& paths, std::vector<IndexedMesh>& meshes, JobSystem* jobSystem = NULL, const bool report = true);
+
+// The number parser the OBJ and glTF readers share: no locale, no allocation, no iostreams.
+// Returns the first character after the number, or NULL if none was found.
+const char* parseFloat(const char* cursor, const char* end, float& value);
@@ -0,0 +1,330 @@
+#include "MeshOptimizer.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace {
+	const int FORSYTH_CACHE_SIZE = 32;
+	const float FORSYTH_CACHE_DECAY_POWER = 1.5f;
+	const float FORSYTH_LAST_TRIANGLE_SCORE = 0.75f;
+	const float FORSYTH_VALENCE_BOOST_SCALE = 2.0f;
+	const float FORSYTH_VALENCE_BOOST_POWER = 0.5f;
+	const unsigned OVERDRAW_CACHE_SIZE = 16;
+
+	float forsythVertexScore(const int cachePosition, const unsigned remainingTriangles) {
+		if (remainingTriangles == 0) return -1.0f;
+
+		float score = 0.0f;
+		if (cachePosition >= 0) {
+			if (cachePosition < 3) {
+				score = FORSYTH_LAST_TRIANGLE_SCORE;
+			}
+			else {
+				const float scaler = 1.0f / (FORSYTH_CACHE_SIZE - 3);
+				score = std::pow(1.0f - (cachePosition - 3) * scaler, FORSYTH_CACHE_DECAY_POWER);
+			}
+		}
+		return score + FORSYTH_VALENCE_BOOST_SCALE * std::pow(static_cast<float>(remainingTriangles), -FORSYTH_VALENCE_BOOST_POWER);
+	}
+
+	// FIFO cache whose entries are identified by the miss count at insertion, so a vertex is cached
+	// while it is among the last size inserts; advancing the clock by the cache size flushes it in O(1).
+	class FifoCache {
+	public:
+		FifoCache(const std::size_t vertexCount, const unsigned size) : insertedAt(vertexCount, 0), clock(size + 1), size(size) {}
+
+		unsigned access(const std::uint32_t vertex) {
+			if (clock - insertedAt[vertex] <= size) return 0;
+			insertedAt[vertex] = clock++;
+			return 1;
+		}
+
+		void flush() {
+			clock += size;
+		}
+
+	private:
+		std::vector<std::size_t> insertedAt;
+		std::size_t clock;
+		unsigned size;
+	};
+
+	void triangleCentroidAndNormal(const float* positions, const int stride, const std::uint32_t* triangle, float centroid[3], float normal[3]) {
+		const float* a = positions + static_cast<std::size_t>(triangle[0]) * stride;
+		const float* b = positions + static_cast<std::size_t>(triangle[1]) * stride;
+		const float* c = positions + static_cast<std::size_t>(triangle[2]) * stride;
+		const float ab[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+		const float ac[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+		// Unnormalized, so the length is twice the area and sums weight by area for free.
+		normal[0] = ab[1] * ac[2] - ab[2] * ac[1];
+		normal[1] = ab[2] * ac[0] - ab[0] * ac[2];
+		normal[2] = ab[0] * ac[1] - ab[1] * ac[0];
+		for (int i = 0; i < 3; ++i) centroid[i] = (a[i] + b[i] + c[i]) / 3.0f;
+	}
+
+	void printStatistics(const char* label, const std::vector<std::uint32_t>& indices, const std::size_t vertexCount) {
+		const VertexCacheStatistics fifo = simulateVertexCache(indices.data(), indices.size(), vertexCount, ACMR_CACHE_SIZE, CacheModel::Fifo);
+		const VertexCacheStatistics lru = simulateVertexCache(indices.data(), indices.size(), vertexCount, ACMR_CACHE_SIZE, CacheModel::Lru);
+		std::cout << "  " << label << ": ACMR " << fifo.acmr << " FIFO / " << lru.acmr << " LRU, ATVR " << fifo.atvr << " FIFO / " << lru.atvr << " LRU" << '\n';
+	}
+}
+
+VertexCacheStatistics simulateVertexCache(const std::uint32_t* indices, const std::size_t indexCount, const std::size_t vertexCount, const unsigned cacheSize, const CacheModel model) {
+	VertexCacheStatistics statistics = { 0.0, 0.0 };
+	if (indexCount < 3 || vertexCount == 0) return statistics;
+
+	std::size_t misses = 0;
+	if (model == CacheModel::Fifo) {
+		FifoCache cache(vertexCount, cacheSize);
+		for (std::size_t i = 0; i < indexCount; ++i) misses += cache.access(indices[i]);
+	}
+	else {
+		std::vector<std::uint32_t> cache;
+		cache.reserve(cacheSize + 1);
+		for (std::size_t i = 0; i < indexCount; ++i) {
+			std::vector<std::uint32_t>::iterator hit = std::find(cache.begin(), cache.end(), indices[i]);
+			if (hit != cache.end()) {
+				std::rotate(cache.begin(), hit, hit + 1);
+				continue;
+			}
+			++misses;
+			cache.insert(cache.begin(), indices[i]);
+			if (cache.size() > cacheSize) cache.pop_back();
+		}
+	}
+
+	std::size_t usedVertices = 0;
+	std::vector<bool> used(vertexCount, false);
+	for (std::size_t i = 0; i < indexCount; ++i) {
+		if (!used[indices[i]]) {
+			used[indices[i]] = true;
+			++usedVertices;
+		}
+	}
+	statistics.acmr = static_cast<double>(misses) / (indexCount / 3);
+	statistics.atvr = static_cast<double>(misses) / usedVertices;
+	return statistics;
+}
+
+void optimizeVertexCache(std::vector<std::uint32_t>& indices, const std::size_t vertexCount) {
+	const std::size_t triangleCount = indices.size() / 3;
+	if (triangleCount == 0) return;
+
+	// Triangles touching each vertex, as offsets into one flat list.
+	std::vector<unsigned> remaining(vertexCount, 0);
+	for (std::size_t i = 0; i < triangleCount * 3; ++i) ++remaining[indices[i]];
+	std::vector<std::size_t> adjacencyOffsets(vertexCount + 1, 0);
+	for (std::size_t vertex = 0; vertex < vertexCount; ++vertex) adjacencyOffsets[vertex + 1] = adjacencyOffsets[vertex] + remaining[vertex];
+	std::vector<std::uint32_t> adjacency(adjacencyOffsets[vertexCount]);
+	std::vector<std::size_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+	for (std::size_t i = 0; i < triangleCount * 3; ++i) adjacency[fill[indices[i]]++] = static_cast<std::uint32_t>(i / 3);
+
+	std::vector<int> cachePosition(vertexCount, -1);
+	std::vector<float> vertexScore(vertexCount);
+	for (std::size_t vertex = 0; vertex < vertexCount; ++vertex) vertexScore[vertex] = forsythVertexScore(-1, remaining[vertex]);
+	std::vector<float> triangleScore(triangleCount);
+	std::vector<bool> emitted(triangleCount, false);
+	for (std::size_t triangle = 0; triangle < triangleCount; ++triangle) {
+		triangleScore[triangle] = vertexScore[indices[triangle * 3]] + vertexScore[indices[triangle * 3 + 1]] + vertexScore[indices[triangle * 3 + 2]];
+	}
+
+	std::vector<std::uint32_t> ordered;
+	ordered.reserve(triangleCount * 3);
+	std::vector<std::uint32_t> cache;
+	cache.reserve(FORSYTH_CACHE_SIZE + 3);
+	std::size_t scanCursor = 0;
+	std::size_t bestTriangle = 0;
+	float bestScore = triangleScore[0];
+	for (std::size_t triangle = 1; triangle < triangleCount; ++triangle) {
+		if (triangleScore[triangle] > bestScore) {
+			bestScore = triangleScore[triangle];
+			bestTriangle = triangle;
+		}
+	}
+
+	for (std::size_t step = 0; step < triangleCount; ++step) {
+		if (bestScore < 0.0f) {
+			// Nothing in the cache connects to unemitted triangles; restart from the first unemitted one.
+			while (emitted[scanCursor]) ++scanCursor;
+			bestTriangle = scanCursor;
+		}
+
+		emitted[bestTriangle] = true;
+		const std::uint32_t* triangle = &indices[bestTriangle * 3];
+		for (int corner = 0; corner < 3; ++corner) {
+			const std::uint32_t vertex = triangle[corner];
+			ordered.push_back(vertex);
+			--remaining[vertex];
+
+			// Unlink the triangle from the vertex's adjacency so only live triangles are rescored.
+			std::uint32_t* first = &adjacency[adjacencyOffsets[vertex]];
+			std::uint32_t* last = first + remaining[vertex] + 1;
+			std::uint32_t* link = std::find(first, last, static_cast<std::uint32_t>(bestTriangle));
+			if (link != last) *link = *(last - 1);
+		}
+
+		// Move the triangle's vertices to the front of the LRU cache; anything pushed past the end
+		// is evicted but still needs rescoring.
+		for (int corner = 2; corner >= 0; --corner) {
+			std::vector<std::uint32_t>::iterator existing = std::find(cache.begin(), cache.end(), triangle[corner]);
+			if (existing != cache.end()) cache.erase(existing);
+			cache.insert(cache.begin(), triangle[corner]);
+		}
+		for (std::size_t i = 0; i < cache.size(); ++i) cachePosition[cache[i]] = (i < static_cast<std::size_t>(FORSYTH_CACHE_SIZE)) ? static_cast<int>(i) : -1;
+
+		for (const std::uint32_t vertex : cache) vertexScore[vertex] = forsythVertexScore(cachePosition[vertex], remaining[vertex]);
+
+		bestScore = -1.0f;
+		for (const std::uint32_t vertex : cache) {
+			for (std::size_t i = adjacencyOffsets[vertex]; i < adjacencyOffsets[vertex] + remaining[vertex]; ++i) {
+				const std::uint32_t candidate = adjacency[i];
+				const float score = vertexScore[indices[candidate * 3]] + vertexScore[indices[candidate * 3 + 1]] + vertexScore[indices[candidate * 3 + 2]];
+				triangleScore[candidate] = score;
+				if (score > bestScore) {
+					bestScore = score;
+					bestTriangle = candidate;
+				}
+			}
+		}
+		if (cache.size() > static_cast<std::size_t>(FORSYTH_CACHE_SIZE)) cache.resize(FORSYTH_CACHE_SIZE);
+	}
+
+	indices.swap(ordered);
+}
+
+void optimizeOverdraw(std::vector<std::uint32_t>& indices, const float* positions, const std::size_t vertexCount, const int stride, const float threshold) {
+	const std::size_t triangleCount = indices.size() / 3;
+	if (triangleCount == 0) return;
+
+	// Hard boundaries: triangles that miss on all three vertices start with a cold cache anyway.
+	std::vector<std::size_t> hardBoundaries;
+	FifoCache cache(vertexCount, OVERDRAW_CACHE_SIZE);
+	for (std::size_t triangle = 0; triangle < triangleCount; ++triangle) {
+		unsigned misses = 0;
+		for (int corner = 0; corner < 3; ++corner) misses += cache.access(indices[triangle * 3 + corner]);
+		if (triangle == 0 || misses == 3) hardBoundaries.push_back(triangle);
+	}
+	hardBoundaries.push_back(triangleCount);
+
+	// Soft boundaries: inside each hard cluster, cut whenever the running ACMR since the last cut is
+	// already within threshold of the cluster's own, so restarting the cache there costs little.
+	std::vector<std::size_t> clusters;
+	for (std::size_t cluster = 0; cluster + 1 < hardBoundaries.size(); ++cluster) {
+		const std::size_t start = hardBoundaries[cluster];
+		const std::size_t end = hardBoundaries[cluster + 1];
+		cache.flush();
+		std::size_t clusterMisses = 0;
+		for (std::size_t i = start * 3; i < end * 3; ++i) clusterMisses += cache.access(indices[i]);
+		const double clusterAcmr = static_cast<double>(clusterMisses) / (end - start);
+
+		cache.flush();
+		clusters.push_back(start);
+		std::size_t runningMisses = 0;
+		std::size_t runningTriangles = 0;
+		for (std::size_t triangle = start; triangle < end; ++triangle) {
+			for (int corner = 0; corner < 3; ++corner) runningMisses += cache.access(indices[triangle * 3 + corner]);
+			++runningTriangles;
+			if (triangle + 1 < end && static_cast<double>(runningMisses) / runningTriangles <= threshold * clusterAcmr) {
+				clusters.push_back(triangle + 1);
+				cache.flush();
+				runningMisses = 0;
+				runningTriangles = 0;
+			}
+		}
+	}
+	clusters.push_back(triangleCount);
+
+	float meshCentroid[3] = { 0.0f, 0.0f, 0.0f };
+	float meshArea = 0.0f;
+	std::vector<float> clusterCentroids((clusters.size() - 1) * 3, 0.0f);
+	std::vector<float> clusterNormals((clusters.size() - 1) * 3, 0.0f);
+	for (std::size_t cluster = 0; cluster + 1 < clusters.size(); ++cluster) {
+		float clusterArea = 0.0f;
+		for (std::size_t triangle = clusters[cluster]; triangle < clusters[cluster + 1]; ++triangle) {
+			float centroid[3], normal[3];
+			triangleCentroidAndNormal(positions, stride, &indices[triangle * 3], centroid, normal);
+			const float area = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+			for (int i = 0; i < 3; ++i) {
+				clusterCentroids[cluster * 3 + i] += centroid[i] * area;
+				clusterNormals[cluster * 3 + i] += normal[i];
+				meshCentroid[i] += centroid[i] * area;
+			}
+			clusterArea += area;
+		}
+		meshArea += clusterArea;
+		if (clusterArea > 0.0f) {
+			for (int i = 0; i < 3; ++i) clusterCentroids[cluster * 3 + i] /= clusterArea;
+		}
+	}
+	if (meshArea > 0.0f) {
+		for (int i = 0; i < 3; ++i) meshCentroid[i] /= meshArea;
+	}
+
+	std::vector<std::pair<float, std::size_t>> sortKeys(clusters.size() - 1);
+	for (std::size_t cluster = 0; cluster + 1 < clusters.size(); ++cluster) {
+		const float* centroid = &clusterCentroids[cluster * 3];
+		const float* normal = &clusterNormals[cluster * 3];
+		const float length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+		float facing = 0.0f;
+		for (int i = 0; i < 3; ++i) facing += (centroid[i] - meshCentroid[i]) * normal[i];
+		sortKeys[cluster] = std::make_pair(length > 0.0f ? -facing / length : 0.0f, cluster);
+	}
+	std::stable_sort(sortKeys.begin(), sortKeys.end(), [](const std::pair<float, std::size_t>& a, const std::pair<float, std::size_t>& b) { return a.first < b.first; });
+
+	std::vector<std::uint32_t> ordered;
+	ordered.reserve(indices.size());
+	for (const std::pair<float, std::size_t>& key : sortKeys) {
+		ordered.insert(ordered.end(), indices.begin() + clusters[key.second] * 3, indices.begin() + clusters[key.second + 1] * 3);
+	}
+	indices.swap(ordered);
+}
+
+std::size_t optimizeVertexFetch(std::vector<float>& vertices, const int floatsPerVertex, std::vector<std::uint32_t>& indices) {
+	const std::uint32_t UNUSED = 0xFFFFFFFFu;
+	const std::size_t vertexCount = vertices.size() / floatsPerVertex;
+	std::vector<std::uint32_t> remap(vertexCount, UNUSED);
+	std::vector<float> reordered;
+	reordered.reserve(vertices.size());
+
+	std::uint32_t nextVertex = 0;
+	for (std::uint32_t& index : indices) {
+		if (remap[index] == UNUSED) {
+			remap[index] = nextVertex++;
+			reordered.insert(reordered.end(), vertices.begin() + static_cast<std::size_t>(index) * floatsPerVertex, vertices.begin() + static_cast<std::size_t>(index + 1) * floatsPerVertex);
+		}
+		index = remap[index];
+	}
+	vertices.swap(reordered);
+	return nextVertex;
+}
+
+void optimizeMesh(IndexedMesh& mesh, const bool report) {
+	if (mesh.attributeSizes.empty() || mesh.attributeSizes[0] != 3) return;
+
+	const std::size_t vertexCount = mesh.vertexCount();
+	if (report) {
+		std::cout << "Optimizing mesh " << mesh.name << " (" << mesh.indices.size() / 3 << " triangles, cache " << ACMR_CACHE_SIZE << ")" << '\n';
+		printStatistics("before", mesh.indices, vertexCount);
+	}
+
+	// Submeshes are drawn separately, so triangles are only reordered within their own range.
+	if (mesh.submeshes.size() <= 1) {
+		optimizeVertexCache(mesh.indices, vertexCount);
+		if (report) printStatistics("vertex cache", mesh.indices, vertexCount);
+		optimizeOverdraw(mesh.indices, mesh.vertices.data(), vertexCount, mesh.floatsPerVertex());
+		if (report) printStatistics("overdraw", mesh.indices, vertexCount);
+	}
+	else {
+		std::vector<std::uint32_t> rangeIndices;
+		for (const MeshRange& range : mesh.submeshes) {
+			const std::vector<std::uint32_t>::iterator first = mesh.indices.begin() + range.firstIndex;
+			rangeIndices.assign(first, first + range.indexCount);
+			optimizeVertexCache(rangeIndices, vertexCount);
+			optimizeOverdraw(rangeIndices, mesh.vertices.data(), vertexCount, mesh.floatsPerVertex());
+			std::copy(rangeIndices.begin(), rangeIndices.end(), first);
+		}
+		if (report) printStatistics("cache + overdraw", mesh.indices, vertexCount);
+	}
+	const std::size_t usedVertices = optimizeVertexFetch(mesh.vertices, mesh.floatsPerVertex(), mesh.indices);
+	if (report && usedVertices != vertexCount) std::cout << "  dropped " << vertexCount - usedVertices << " unreferenced vertices" << '\n';
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include "MeshBuilder.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+const unsigned ACMR_CACHE_SIZE = 16;
+
+enum class CacheModel {
+	Fifo,
+	Lru
+};
+
+// ACMR is transformed vertices per triangle (3.0 is no reuse); ATVR is transformed vertices per
+// unique vertex (1.0 is the ideal, every vertex shaded exactly once).
+struct VertexCacheStatistics {
+	double acmr;
+	double atvr;
+};
+
+VertexCacheStatistics simulateVertexCache(const std::uint32_t* indices, const std::size_t indexCount, const std::size_t vertexCount, const unsigned cacheSize, const CacheModel model);
+
+// Forsyth's linear-speed greedy ordering against a 32-entry LRU cache.
+void optimizeVertexCache(std::vector<std::uint32_t>& indices, const std::size_t vertexCount);
+
+// Tipsify-style: splits the cache-ordered triangles into clusters wherever the cache restarts,
+// or where cutting costs less than threshold times the cluster's ACMR, then draws clusters that
+// face away from the mesh centre first so they tend to occlude the rest.
+void optimizeOverdraw(std::vector<std::uint32_t>& indices, const float* positions, const std::size_t vertexCount, const int stride, const float threshold = 1.05f);
+
+// Renumbers vertices in first-use order and drops unreferenced ones; returns the new count.
+std::size_t optimizeVertexFetch(std::vector<float>& vertices, const int floatsPerVertex, std::vector<std::uint32_t>& indices);
+
+// Runs all three passes; attribute 0 must be the xyz position, as set up with glVertexAttribPointer.
+void optimizeMesh(IndexedMesh& mesh, const bool report = true);
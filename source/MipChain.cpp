@@ -0,0 +1,239 @@
+#include "MipChain.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MIP_CHAIN_SSE2 1
+#endif
+
+namespace {
+	const int KAISER_WIDTH = 2;
+	const float KAISER_ALPHA = 4.0f;
+	const int LINEAR_TO_SRGB_ENTRIES = 65536;
+
+	struct FloatImage {
+		int width;
+		int height;
+		std::vector<float> texels;
+	};
+
+	struct FilterTaps {
+		int first;
+		int count;
+		std::vector<float> weights;
+	};
+
+	struct ColorTables {
+		float srgbToLinear[256];
+		unsigned char linearToSrgb[LINEAR_TO_SRGB_ENTRIES];
+
+		ColorTables() {
+			for (int i = 0; i < 256; ++i) {
+				const float value = i / 255.0f;
+				srgbToLinear[i] = value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+			}
+			for (int i = 0; i < LINEAR_TO_SRGB_ENTRIES; ++i) {
+				const float value = i / static_cast<float>(LINEAR_TO_SRGB_ENTRIES - 1);
+				const float encoded = value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+				linearToSrgb[i] = static_cast<unsigned char>(std::min(255.0f, encoded * 255.0f + 0.5f));
+			}
+		}
+	};
+
+	const ColorTables& colorTables() {
+		static const ColorTables tables;
+		return tables;
+	}
+
+	void toFloatImage(const unsigned char* pixels, const int width, const int height, const int channels, const bool isSrgb, FloatImage& image) {
+		const ColorTables& tables = colorTables();
+		image.width = width;
+		image.height = height;
+		image.texels.resize(static_cast<std::size_t>(width) * height * 4);
+		for (std::size_t i = 0, count = static_cast<std::size_t>(width) * height; i < count; ++i) {
+			const unsigned char* source = pixels + i * channels;
+			float* texel = &image.texels[i * 4];
+			for (int c = 0; c < 4; ++c) {
+				if (c >= channels) texel[c] = (c == 3) ? 1.0f : 0.0f;
+				else if (isSrgb && c < 3) texel[c] = tables.srgbToLinear[source[c]];
+				else texel[c] = source[c] / 255.0f;
+			}
+		}
+	}
+
+	void toLevel(const FloatImage& image, const int channels, const bool isSrgb, MipLevel& level) {
+		const ColorTables& tables = colorTables();
+		level.width = image.width;
+		level.height = image.height;
+		level.pixels.resize(static_cast<std::size_t>(image.width) * image.height * channels);
+		for (std::size_t i = 0, count = static_cast<std::size_t>(image.width) * image.height; i < count; ++i) {
+			const float* texel = &image.texels[i * 4];
+			unsigned char* destination = &level.pixels[i * channels];
+			for (int c = 0; c < channels; ++c) {
+				const float value = std::min(1.0f, std::max(0.0f, texel[c]));
+				if (isSrgb && c < 3) destination[c] = tables.linearToSrgb[static_cast<int>(value * (LINEAR_TO_SRGB_ENTRIES - 1) + 0.5f)];
+				else destination[c] = static_cast<unsigned char>(value * 255.0f + 0.5f);
+			}
+		}
+	}
+
+	float besselI0(const float x) {
+		float sum = 1.0f;
+		float term = 1.0f;
+		for (int k = 1; k < 20; ++k) {
+			term *= (x * 0.5f / k) * (x * 0.5f / k);
+			sum += term;
+		}
+		return sum;
+	}
+
+	float kaiserSinc(const float t) {
+		if (std::fabs(t) >= KAISER_WIDTH) return 0.0f;
+		const float ratio = t / KAISER_WIDTH;
+		const float window = besselI0(KAISER_ALPHA * std::sqrt(1.0f - ratio * ratio)) / besselI0(KAISER_ALPHA);
+		const float sinc = std::fabs(t) < 1e-5f ? 1.0f : std::sin(3.14159265f * t) / (3.14159265f * t);
+		return sinc * window;
+	}
+
+	// Taps for each destination texel along one axis, with out-of-range source texels clamped to the edge.
+	void buildKaiserTaps(const int sourceSize, const int destinationSize, std::vector<FilterTaps>& taps) {
+		const float scale = static_cast<float>(sourceSize) / destinationSize;
+		const float radius = KAISER_WIDTH * scale;
+		taps.resize(destinationSize);
+		for (int x = 0; x < destinationSize; ++x) {
+			const float center = (x + 0.5f) * scale;
+			const int first = static_cast<int>(std::floor(center - radius));
+			const int last = static_cast<int>(std::ceil(center + radius));
+			FilterTaps& tap = taps[x];
+			tap.first = std::max(0, first);
+			tap.count = std::min(sourceSize - 1, last) - tap.first + 1;
+			tap.weights.assign(tap.count, 0.0f);
+
+			float total = 0.0f;
+			for (int i = first; i <= last; ++i) {
+				const float weight = kaiserSinc((i + 0.5f - center) / scale);
+				tap.weights[std::min(sourceSize - 1, std::max(0, i)) - tap.first] += weight;
+				total += weight;
+			}
+			for (float& weight : tap.weights) weight /= total;
+		}
+	}
+
+	// Each output texel averages its 2x2 source block. An odd source size leaves a last column or
+	// row over, which folds into the last output texel as a third tap, so every texel contributes.
+	void boxDownsample(const FloatImage& source, FloatImage& destination, const bool useSimd) {
+		const bool foldColumn = source.width > 1 && source.width % 2 != 0;
+		const bool foldRow = source.height > 1 && source.height % 2 != 0;
+		for (int y = 0; y < destination.height; ++y) {
+			const int rowCount = (foldRow && y == destination.height - 1) ? 3 : 2;
+			const float* rows[3];
+			for (int r = 0; r < 3; ++r) rows[r] = &source.texels[static_cast<std::size_t>(std::min(2 * y + r, source.height - 1)) * source.width * 4];
+			const float* row0 = rows[0];
+			const float* row1 = rows[1];
+			float* output = &destination.texels[static_cast<std::size_t>(y) * destination.width * 4];
+			for (int x = 0; x < destination.width; ++x) {
+				const int columnCount = (foldColumn && x == destination.width - 1) ? 3 : 2;
+				if (rowCount == 3 || columnCount == 3) {
+					float sum[4] = {};
+					for (int r = 0; r < rowCount; ++r) {
+						for (int i = 0; i < columnCount; ++i) {
+							const int column = std::min(2 * x + i, source.width - 1) * 4;
+							for (int c = 0; c < 4; ++c) sum[c] += rows[r][column + c];
+						}
+					}
+					const float scale = 1.0f / static_cast<float>(rowCount * columnCount);
+					for (int c = 0; c < 4; ++c) output[x * 4 + c] = sum[c] * scale;
+					continue;
+				}
+				const int x0 = std::min(2 * x, source.width - 1) * 4;
+				const int x1 = std::min(2 * x + 1, source.width - 1) * 4;
+#ifdef MIP_CHAIN_SSE2
+				if (useSimd) {
+					__m128 sum = _mm_add_ps(_mm_add_ps(_mm_loadu_ps(row0 + x0), _mm_loadu_ps(row0 + x1)), _mm_add_ps(_mm_loadu_ps(row1 + x0), _mm_loadu_ps(row1 + x1)));
+					_mm_storeu_ps(output + x * 4, _mm_mul_ps(sum, _mm_set1_ps(0.25f)));
+					continue;
+				}
+#endif
+				for (int c = 0; c < 4; ++c) output[x * 4 + c] = (row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c]) * 0.25f;
+			}
+		}
+	}
+
+	void kaiserDownsample(const FloatImage& source, FloatImage& destination, const bool useSimd) {
+		std::vector<FilterTaps> horizontalTaps;
+		std::vector<FilterTaps> verticalTaps;
+		buildKaiserTaps(source.width, destination.width, horizontalTaps);
+		buildKaiserTaps(source.height, destination.height, verticalTaps);
+
+		std::vector<float> horizontal(static_cast<std::size_t>(destination.width) * source.height * 4);
+		for (int y = 0; y < source.height; ++y) {
+			const float* input = &source.texels[static_cast<std::size_t>(y) * source.width * 4];
+			float* output = &horizontal[static_cast<std::size_t>(y) * destination.width * 4];
+			for (int x = 0; x < destination.width; ++x) {
+				const FilterTaps& tap = horizontalTaps[x];
+#ifdef MIP_CHAIN_SSE2
+				if (useSimd) {
+					__m128 sum = _mm_setzero_ps();
+					for (int i = 0; i < tap.count; ++i) sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(tap.weights[i]), _mm_loadu_ps(input + (tap.first + i) * 4)));
+					_mm_storeu_ps(output + x * 4, sum);
+					continue;
+				}
+#endif
+				for (int c = 0; c < 4; ++c) {
+					float sum = 0.0f;
+					for (int i = 0; i < tap.count; ++i) sum += tap.weights[i] * input[(tap.first + i) * 4 + c];
+					output[x * 4 + c] = sum;
+				}
+			}
+		}
+
+		const std::size_t rowFloats = static_cast<std::size_t>(destination.width) * 4;
+		for (int y = 0; y < destination.height; ++y) {
+			const FilterTaps& tap = verticalTaps[y];
+			float* output = &destination.texels[y * rowFloats];
+#ifdef MIP_CHAIN_SSE2
+			if (useSimd) {
+				for (std::size_t i = 0; i < rowFloats; i += 4) {
+					__m128 sum = _mm_setzero_ps();
+					for (int t = 0; t < tap.count; ++t) sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(tap.weights[t]), _mm_loadu_ps(&horizontal[(tap.first + t) * rowFloats + i])));
+					_mm_storeu_ps(output + i, sum);
+				}
+				continue;
+			}
+#endif
+			for (std::size_t i = 0; i < rowFloats; ++i) {
+				float sum = 0.0f;
+				for (int t = 0; t < tap.count; ++t) sum += tap.weights[t] * horizontal[(tap.first + t) * rowFloats + i];
+				output[i] = sum;
+			}
+		}
+	}
+
+	void buildMipChain(const unsigned char* pixels, const int width, const int height, const int channels, const bool isSrgb, const MipFilter filter, const bool useSimd, std::vector<MipLevel>& levels) {
+		levels.clear();
+		FloatImage current;
+		FloatImage next;
+		toFloatImage(pixels, width, height, channels, isSrgb, current);
+
+		while (current.width > 1 || current.height > 1) {
+			next.width = std::max(1, current.width / 2);
+			next.height = std::max(1, current.height / 2);
+			next.texels.resize(static_cast<std::size_t>(next.width) * next.height * 4);
+			if (filter == MipFilter::Box) boxDownsample(current, next, useSimd);
+			else kaiserDownsample(current, next, useSimd);
+
+			levels.emplace_back();
+			toLevel(next, channels, isSrgb, levels.back());
+			std::swap(current, next);
+		}
+	}
+}
+
+void generateMipChain(const unsigned char* pixels, const int width, const int height, const int channels, const bool isSrgb, const MipFilter filter, std::vector<MipLevel>& levels) {
+	buildMipChain(pixels, width, height, channels, isSrgb, filter, true, levels);
+}
+
+void generateMipChainScalar(const unsigned char* pixels, const int width, const int height, const int channels, const bool isSrgb, const MipFilter filter, std::vector<MipLevel>& levels) {
+	buildMipChain(pixels, width, height, channels, isSrgb, filter, false, levels);
+}
@@ -0,0 +1,20 @@
+#pragma once
+#include <vector>
+
+enum class MipFilter {
+	Box,
+	Kaiser
+};
+
+struct MipLevel {
+	int width;
+	int height;
+	std::vector<unsigned char> pixels;
+};
+
+// Builds levels 1..n below an 8-bit image with 1-4 channels. Filtering happens in float RGBA;
+// sRGB sources are linearized first and re-encoded afterwards, alpha always stays linear.
+void generateMipChain(const unsigned char* pixels, const int width, const int height, const int channels, const bool isSrgb, const MipFilter filter, std::vector<MipLevel>& levels);
+
+// Plain per-channel loops with the same filters, kept as the reference for the SSE2 path.
+void generateMipChainScalar(const unsigned char* pixels, const int width, const int height, const int channels, const bool isSrgb, const MipFilter filter, std::vector<MipLevel>& levels);
@@ -0,0 +1,257 @@
+#include "OcclusionCuller.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define OCCLUSION_CULLER_SSE2 1
+#endif
+
+namespace {
+	// Rasterized depths and projected box corners round differently, so an object that is its own
+	// occluder could otherwise come out a hair behind itself.
+	const float DEPTH_BIAS = 1.0e-5f;
+
+	double millisecondsSince(const std::chrono::steady_clock::time_point start) {
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	int roundUpToPowerOfTwo(const int value) {
+		int rounded = 1;
+		while (rounded < value) rounded *= 2;
+		return rounded;
+	}
+
+	// In front of the near plane in GL clip space; anything else is left to frustum culling.
+	bool isInFrontOfNearPlane(const glm::vec4& clip) {
+		return clip.w > 0.0f && clip.z >= -clip.w;
+	}
+
+	glm::vec3 toWindow(const glm::vec4& clip, const int width, const int height) {
+		const glm::vec3 ndc = glm::vec3(clip) / clip.w;
+		return glm::vec3((ndc.x * 0.5f + 0.5f) * width, (ndc.y * 0.5f + 0.5f) * height, ndc.z * 0.5f + 0.5f);
+	}
+
+	void reduceLevel(const std::vector<float>& input, const glm::ivec2& inputSize, std::vector<float>& output, const glm::ivec2& outputSize, const bool farthest, const bool useSimd) {
+		for (int y = 0; y < outputSize.y; ++y) {
+			const float* row0 = &input[std::min(2 * y, inputSize.y - 1) * inputSize.x];
+			const float* row1 = &input[std::min(2 * y + 1, inputSize.y - 1) * inputSize.x];
+			float* out = &output[y * outputSize.x];
+			int x = 0;
+#ifdef OCCLUSION_CULLER_SSE2
+			// Eight inputs per row make four outputs: combine the rows, then the even and odd lanes.
+			if (useSimd && inputSize.x == 2 * outputSize.x) {
+				for (; x + 4 <= outputSize.x; x += 4) {
+					const __m128 a0 = _mm_loadu_ps(row0 + 2 * x), a1 = _mm_loadu_ps(row0 + 2 * x + 4);
+					const __m128 b0 = _mm_loadu_ps(row1 + 2 * x), b1 = _mm_loadu_ps(row1 + 2 * x + 4);
+					const __m128 low = farthest ? _mm_max_ps(a0, b0) : _mm_min_ps(a0, b0);
+					const __m128 high = farthest ? _mm_max_ps(a1, b1) : _mm_min_ps(a1, b1);
+					const __m128 even = _mm_shuffle_ps(low, high, _MM_SHUFFLE(2, 0, 2, 0)), odd = _mm_shuffle_ps(low, high, _MM_SHUFFLE(3, 1, 3, 1));
+					_mm_storeu_ps(out + x, farthest ? _mm_max_ps(even, odd) : _mm_min_ps(even, odd));
+				}
+			}
+#endif
+			for (; x < outputSize.x; ++x) {
+				const int x0 = std::min(2 * x, inputSize.x - 1), x1 = std::min(2 * x + 1, inputSize.x - 1);
+				out[x] = farthest ? std::max(std::max(row0[x0], row0[x1]), std::max(row1[x0], row1[x1])) : std::min(std::min(row0[x0], row0[x1]), std::min(row1[x0], row1[x1]));
+			}
+		}
+	}
+}
+
+OcclusionCuller::OcclusionCuller() : width(0), height(0), useSimd(true), viewProjection(1.0f), frameStatistics() {}
+
+void OcclusionCuller::create(const int requestedWidth, const int requestedHeight, const bool simd) {
+	width = std::max(4, roundUpToPowerOfTwo(requestedWidth));
+	height = roundUpToPowerOfTwo(requestedHeight);
+	useSimd = simd;
+	depth.assign(static_cast<std::size_t>(width) * height, 1.0f);
+
+	levelSizes.clear();
+	nearestLevels.clear();
+	farthestLevels.clear();
+	glm::ivec2 size(width, height);
+	for (;;) {
+		levelSizes.push_back(size);
+		nearestLevels.push_back(std::vector<float>(static_cast<std::size_t>(size.x) * size.y, 1.0f));
+		farthestLevels.push_back(std::vector<float>(static_cast<std::size_t>(size.x) * size.y, 1.0f));
+		if (size.x == 1 && size.y == 1) break;
+		size = glm::max(size / 2, glm::ivec2(1));
+	}
+}
+
+void OcclusionCuller::beginFrame(const glm::mat4& frameViewProjection) {
+	viewProjection = frameViewProjection;
+	std::fill(depth.begin(), depth.end(), 1.0f);
+	frameStatistics = OcclusionStatistics();
+}
+
+void OcclusionCuller::addOccluder(const IndexedMesh& mesh, const glm::mat4& model) {
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	const glm::mat4 modelViewProjection = viewProjection * model;
+	const int stride = mesh.floatsPerVertex();
+	for (std::size_t i = 0; i + 2 < mesh.indices.size(); i += 3) {
+		glm::vec4 clip[3];
+		bool visible = true;
+		for (int corner = 0; corner < 3; ++corner) {
+			const float* position = &mesh.vertices[mesh.indices[i + corner] * stride];
+			clip[corner] = modelViewProjection * glm::vec4(position[0], position[1], position[2], 1.0f);
+			visible = visible && isInFrontOfNearPlane(clip[corner]);
+		}
+		if (!visible) continue;
+		rasterizeTriangle(clip[0], clip[1], clip[2]);
+		++frameStatistics.occluderTriangles;
+	}
+	frameStatistics.rasterMilliseconds += millisecondsSince(start);
+}
+
+// Edge functions and depth are planes in window space, evaluated at pixel centres. Each pixel is
+// computed the same way on both paths, so the SIMD rows give exactly the scalar result.
+void OcclusionCuller::rasterizeTriangle(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c) {
+	glm::vec3 v0 = toWindow(a, width, height), v1 = toWindow(b, width, height), v2 = toWindow(c, width, height);
+	float area = (v1.x - v0.x) * (v2.y - v0.y) - (v2.x - v0.x) * (v1.y - v0.y);
+	if (area == 0.0f) return;
+	if (area < 0.0f) {
+		std::swap(v1, v2);
+		area = -area;
+	}
+
+	const glm::vec3* vertices[3] = { &v0, &v1, &v2 };
+	float edgeA[3], edgeB[3], edgeC[3];
+	for (int edge = 0; edge < 3; ++edge) {
+		const glm::vec3& from = *vertices[(edge + 1) % 3];
+		const glm::vec3& to = *vertices[(edge + 2) % 3];
+		edgeA[edge] = from.y - to.y;
+		edgeB[edge] = to.x - from.x;
+		edgeC[edge] = from.x * to.y - to.x * from.y;
+	}
+	const float depthA = (edgeA[0] * v0.z + edgeA[1] * v1.z + edgeA[2] * v2.z) / area;
+	const float depthB = (edgeB[0] * v0.z + edgeB[1] * v1.z + edgeB[2] * v2.z) / area;
+	const float depthC = (edgeC[0] * v0.z + edgeC[1] * v1.z + edgeC[2] * v2.z) / area;
+
+	const int minX = std::max(0, static_cast<int>(std::floor(std::min(std::min(v0.x, v1.x), v2.x))));
+	const int maxX = std::min(width - 1, static_cast<int>(std::ceil(std::max(std::max(v0.x, v1.x), v2.x))));
+	const int minY = std::max(0, static_cast<int>(std::floor(std::min(std::min(v0.y, v1.y), v2.y))));
+	const int maxY = std::min(height - 1, static_cast<int>(std::ceil(std::max(std::max(v0.y, v1.y), v2.y))));
+	if (minX > maxX || minY > maxY) return;
+
+	for (int y = minY; y <= maxY; ++y) {
+		const float pixelY = y + 0.5f;
+		const float rowEdge0 = edgeB[0] * pixelY + edgeC[0], rowEdge1 = edgeB[1] * pixelY + edgeC[1], rowEdge2 = edgeB[2] * pixelY + edgeC[2];
+		const float rowDepth = depthB * pixelY + depthC;
+		float* row = &depth[static_cast<std::size_t>(y) * width];
+#ifdef OCCLUSION_CULLER_SSE2
+		if (useSimd) {
+			// Rows are a multiple of four wide, so starting on a group boundary never overruns.
+			const __m128 zero = _mm_setzero_ps();
+			for (int x = minX & ~3; x <= maxX; x += 4) {
+				const __m128 pixelX = _mm_add_ps(_mm_set1_ps(x + 0.5f), _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f));
+				const __m128 edge0 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(edgeA[0]), pixelX), _mm_set1_ps(rowEdge0));
+				const __m128 edge1 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(edgeA[1]), pixelX), _mm_set1_ps(rowEdge1));
+				const __m128 edge2 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(edgeA[2]), pixelX), _mm_set1_ps(rowEdge2));
+				const __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(edge0, zero), _mm_cmpge_ps(edge1, zero)), _mm_cmpge_ps(edge2, zero));
+				const __m128 pixelDepth = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(depthA), pixelX), _mm_set1_ps(rowDepth));
+				const __m128 old = _mm_loadu_ps(row + x);
+				_mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, _mm_min_ps(old, pixelDepth)), _mm_andnot_ps(inside, old)));
+			}
+			continue;
+		}
+#endif
+		for (int x = minX; x <= maxX; ++x) {
+			const float pixelX = x + 0.5f;
+			if (edgeA[0] * pixelX + rowEdge0 >= 0.0f && edgeA[1] * pixelX + rowEdge1 >= 0.0f && edgeA[2] * pixelX + rowEdge2 >= 0.0f) {
+				row[x] = std::min(row[x], depthA * pixelX + rowDepth);
+			}
+		}
+	}
+}
+
+void OcclusionCuller::finishOccluders() {
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	nearestLevels[0] = depth;
+	farthestLevels[0] = depth;
+	for (std::size_t level = 1; level < levelSizes.size(); ++level) {
+		reduceLevel(nearestLevels[level - 1], levelSizes[level - 1], nearestLevels[level], levelSizes[level], false, useSimd);
+		reduceLevel(farthestLevels[level - 1], levelSizes[level - 1], farthestLevels[level], levelSizes[level], true, useSimd);
+	}
+	frameStatistics.pyramidMilliseconds += millisecondsSince(start);
+}
+
+// Starts at the level where the box covers at most 2x2 texels and refines up to two levels down
+// while the answer is still open.
+bool OcclusionCuller::isOccluded(const glm::vec3& center, const glm::vec3& extents) const {
+	glm::vec2 screenMinimum(static_cast<float>(width), static_cast<float>(height)), screenMaximum(0.0f);
+	float nearestDepth = 1.0f;
+	// Corners are the projected centre plus or minus each projected half axis, so one
+	// matrix-vector product and three column scales replace eight full transforms.
+	const glm::vec4 clipCenter = viewProjection * glm::vec4(center, 1.0f);
+	const glm::vec4 axisX = viewProjection[0] * extents.x, axisY = viewProjection[1] * extents.y, axisZ = viewProjection[2] * extents.z;
+	for (int corner = 0; corner < 8; ++corner) {
+		const glm::vec4 clip = clipCenter + ((corner & 1) ? axisX : -axisX) + ((corner & 2) ? axisY : -axisY) + ((corner & 4) ? axisZ : -axisZ);
+		if (!isInFrontOfNearPlane(clip)) return false;
+		const glm::vec3 window = toWindow(clip, width, height);
+		screenMinimum = glm::min(screenMinimum, glm::vec2(window));
+		screenMaximum = glm::max(screenMaximum, glm::vec2(window));
+		nearestDepth = std::min(nearestDepth, window.z);
+	}
+
+	const int x0 = std::max(0, static_cast<int>(std::floor(screenMinimum.x))), x1 = std::min(width - 1, static_cast<int>(std::floor(screenMaximum.x)));
+	const int y0 = std::max(0, static_cast<int>(std::floor(screenMinimum.y))), y1 = std::min(height - 1, static_cast<int>(std::floor(screenMaximum.y)));
+	if (x0 > x1 || y0 > y1) return false;
+
+	int level = 0;
+	while (level + 1 < static_cast<int>(levelSizes.size()) && ((x1 >> level) - (x0 >> level) > 1 || (y1 >> level) - (y0 >> level) > 1)) ++level;
+	for (int refine = level; refine >= std::max(0, level - 2); --refine) {
+		const glm::ivec2& size = levelSizes[refine];
+		const std::vector<float>& nearest = nearestLevels[refine];
+		const std::vector<float>& farthest = farthestLevels[refine];
+		float regionNearest = 1.0f, regionFarthest = 0.0f;
+		for (int y = std::min(y0 >> refine, size.y - 1); y <= std::min(y1 >> refine, size.y - 1); ++y) {
+			for (int x = std::min(x0 >> refine, size.x - 1); x <= std::min(x1 >> refine, size.x - 1); ++x) {
+				regionNearest = std::min(regionNearest, nearest[y * size.x + x]);
+				regionFarthest = std::max(regionFarthest, farthest[y * size.x + x]);
+			}
+		}
+		if (nearestDepth > regionFarthest + DEPTH_BIAS) return true;
+		if (nearestDepth <= regionNearest) return false;
+	}
+	return false;
+}
+
+std::size_t OcclusionCuller::cullObjects(const ObjectBounds& bounds, std::uint32_t* visible, const std::size_t visibleCount) {
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	std::size_t kept = 0;
+	for (std::size_t i = 0; i < visibleCount; ++i) {
+		const std::uint32_t object = visible[i];
+		const glm::vec3 center(bounds.centerX[object], bounds.centerY[object], bounds.centerZ[object]);
+		const glm::vec3 extents(bounds.extentX[object], bounds.extentY[object], bounds.extentZ[object]);
+		if (!isOccluded(center, extents)) visible[kept++] = object;
+	}
+	frameStatistics.testedObjects += visibleCount;
+	frameStatistics.occludedObjects += visibleCount - kept;
+	frameStatistics.testMilliseconds += millisecondsSince(start);
+	return kept;
+}
+
+const OcclusionStatistics& OcclusionCuller::statistics() const {
+	return frameStatistics;
+}
+
+const std::vector<float>& OcclusionCuller::depthBuffer() const {
+	return depth;
+}
+
+// Without occluder triangles the depth buffer stays at the far plane, so say so rather than
+// report a 0% cull rate as if the test had a chance.
+void OcclusionCuller::report() const {
+	if (frameStatistics.occluderTriangles == 0) {
+		std::cout << "Occlusion: no occluder triangles were rasterized, so none of " << frameStatistics.testedObjects << " objects could be culled" << '\n';
+		return;
+	}
+	const double culledPercent = frameStatistics.testedObjects ? 100.0 * frameStatistics.occludedObjects / frameStatistics.testedObjects : 0.0;
+	std::cout << "Occlusion: " << frameStatistics.occludedObjects << " of " << frameStatistics.testedObjects << " objects culled (" << culledPercent << "%), "
+		<< frameStatistics.occluderTriangles << " occluder triangles at " << width << 'x' << height << "; raster " << frameStatistics.rasterMilliseconds
+		<< " ms, pyramid " << frameStatistics.pyramidMilliseconds << " ms, tests " << frameStatistics.testMilliseconds << " ms" << '\n';
+}
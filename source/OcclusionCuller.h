@@ -0,0 +1,55 @@
+#pragma once
+#include "FrustumCulling.h"
+#include "MeshBuilder.h"
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct OcclusionStatistics {
+	std::size_t occluderTriangles;
+	std::size_t testedObjects;
+	std::size_t occludedObjects;
+	double rasterMilliseconds;
+	double pyramidMilliseconds;
+	double testMilliseconds;
+};
+
+// Software hierarchical-Z: occluders are rasterized into a small depth buffer, which is reduced
+// into a pyramid holding the nearest and farthest depth under each texel. An object is hidden when
+// the nearest point of its box is behind the farthest occluder depth over its screen rectangle.
+// Depths are window-space [0, 1] like the GL depth buffer; everything runs on the CPU.
+class OcclusionCuller {
+public:
+	OcclusionCuller();
+
+	// width and height are rounded up to powers of two, width to at least 4 for the SIMD rows.
+	void create(const int width, const int height, const bool useSimd = true);
+	void beginFrame(const glm::mat4& viewProjection);
+	// attribute 0 of mesh must be the xyz position. Triangles crossing the near plane are skipped,
+	// which only ever makes the culler more conservative.
+	void addOccluder(const IndexedMesh& mesh, const glm::mat4& model);
+	void finishOccluders();
+
+	bool isOccluded(const glm::vec3& center, const glm::vec3& extents) const;
+	// Removes hidden objects from visible (as written by cullBoxes) and returns the new count.
+	std::size_t cullObjects(const ObjectBounds& bounds, std::uint32_t* visible, const std::size_t visibleCount);
+
+	const OcclusionStatistics& statistics() const;
+	const std::vector<float>& depthBuffer() const;
+	void report() const;
+
+private:
+	void rasterizeTriangle(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c);
+
+	int width;
+	int height;
+	bool useSimd;
+	glm::mat4 viewProjection;
+	std::vector<float> depth;
+	// Level 0 of each pyramid is a copy of depth.
+	std::vector<std::vector<float> > nearestLevels;
+	std::vector<std::vector<float> > farthestLevels;
+	std::vector<glm::ivec2> levelSizes;
+	OcclusionStatistics frameStatistics;
+};
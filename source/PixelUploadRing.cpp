@@ -0,0 +1,130 @@
+#include "PixelUploadRing.h"
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+PixelUploadRing::PixelUploadRing() : buffer(0), segmentSize(0), nextSegment(0), bytesUploaded(0), uploadMilliseconds(0.0), stallMilliseconds(0.0), stallCount(0), mapFailures(0) {}
+
+void PixelUploadRing::create(const unsigned segmentCount, const std::size_t segmentSize) {
+	this->segmentSize = segmentSize;
+	fences.assign(segmentCount, static_cast<GLsync>(NULL));
+	nextSegment = 0;
+
+	glGenBuffers(1, &buffer);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer);
+	glBufferData(GL_PIXEL_UNPACK_BUFFER, segmentCount * segmentSize, NULL, GL_STREAM_DRAW);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+unsigned PixelUploadRing::acquireSegment() {
+	const unsigned segment = nextSegment;
+	nextSegment = (nextSegment + 1) % fences.size();
+
+	if (fences[segment]) {
+		const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		if (glClientWaitSync(fences[segment], 0, 0) == GL_TIMEOUT_EXPIRED) {
+			while (glClientWaitSync(fences[segment], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED) {}
+			stallMilliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+			++stallCount;
+		}
+		glDeleteSync(fences[segment]);
+		fences[segment] = NULL;
+	}
+	return segment;
+}
+
+// Returns false when the segment cannot be mapped; the caller then uploads the band from client
+// memory instead, with the pixel unpack buffer unbound.
+bool PixelUploadRing::stageBand(const unsigned char* source, const std::size_t byteCount, unsigned& segment, std::size_t& offset) {
+	segment = acquireSegment();
+	offset = segment * segmentSize;
+	void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, offset, byteCount, GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+	if (!mapped) {
+		++mapFailures;
+		return false;
+	}
+	std::memcpy(mapped, source, byteCount);
+	glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+	return true;
+}
+
+void PixelUploadRing::uploadTexture2D(const int level, const int width, const int height, const unsigned format, const unsigned char* pixels) {
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	const std::size_t rowBytes = static_cast<std::size_t>(width) * (format == GL_RGBA ? 4 : format == GL_RGB ? 3 : format == GL_RG ? 2 : 1);
+	const int rowsPerBand = static_cast<int>(segmentSize / rowBytes);
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	if (rowsPerBand == 0) {
+		glTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, width, height, format, GL_UNSIGNED_BYTE, pixels);
+	} else {
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer);
+		for (int row = 0; row < height; row += rowsPerBand) {
+			const int bandRows = (height - row < rowsPerBand) ? height - row : rowsPerBand;
+			unsigned segment;
+			std::size_t offset;
+			if (stageBand(pixels + row * rowBytes, bandRows * rowBytes, segment, offset)) {
+				glTexSubImage2D(GL_TEXTURE_2D, level, 0, row, width, bandRows, format, GL_UNSIGNED_BYTE, reinterpret_cast<void*>(offset));
+				fences[segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+			} else {
+				glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+				glTexSubImage2D(GL_TEXTURE_2D, level, 0, row, width, bandRows, format, GL_UNSIGNED_BYTE, pixels + row * rowBytes);
+				glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer);
+			}
+		}
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	}
+
+	bytesUploaded += rowBytes * height;
+	uploadMilliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void PixelUploadRing::uploadCompressedTexture2D(const int level, const int width, const int height, const unsigned internalFormat, const std::size_t bytesPerBlock, const unsigned char* blocks) {
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	const std::size_t blockRowBytes = static_cast<std::size_t>((width + 3) / 4) * bytesPerBlock;
+	const int blockRows = (height + 3) / 4;
+	const int blockRowsPerBand = static_cast<int>(segmentSize / blockRowBytes);
+
+	if (blockRowsPerBand == 0) {
+		glCompressedTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, width, height, internalFormat, static_cast<int>(blockRows * blockRowBytes), blocks);
+	} else {
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer);
+		for (int blockRow = 0; blockRow < blockRows; blockRow += blockRowsPerBand) {
+			const int bandBlockRows = (blockRows - blockRow < blockRowsPerBand) ? blockRows - blockRow : blockRowsPerBand;
+			const int bandHeight = (height - blockRow * 4 < bandBlockRows * 4) ? height - blockRow * 4 : bandBlockRows * 4;
+			unsigned segment;
+			std::size_t offset;
+			if (stageBand(blocks + blockRow * blockRowBytes, bandBlockRows * blockRowBytes, segment, offset)) {
+				glCompressedTexSubImage2D(GL_TEXTURE_2D, level, 0, blockRow * 4, width, bandHeight, internalFormat, static_cast<int>(bandBlockRows * blockRowBytes), reinterpret_cast<void*>(offset));
+				fences[segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+			} else {
+				glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+				glCompressedTexSubImage2D(GL_TEXTURE_2D, level, 0, blockRow * 4, width, bandHeight, internalFormat, static_cast<int>(bandBlockRows * blockRowBytes), blocks + blockRow * blockRowBytes);
+				glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer);
+			}
+		}
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	}
+
+	bytesUploaded += blockRows * blockRowBytes;
+	uploadMilliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// The rate is CPU submit throughput: it stops the clock once the copies are queued, not when the
+// GPU has finished them; fence stalls are what show the GPU falling behind.
+void PixelUploadRing::report() const {
+	const double megabytes = bytesUploaded / (1024.0 * 1024.0);
+	const double megabytesPerSecond = uploadMilliseconds > 0.0 ? megabytes / (uploadMilliseconds / 1000.0) : 0.0;
+	std::cout << "Pixel upload ring (" << fences.size() << " x " << segmentSize / 1024 << " KB): " << megabytes << " MB submitted at " << megabytesPerSecond << " MB/s CPU submit throughput, "
+		<< stallMilliseconds << " ms stalled over " << stallCount << " fence waits";
+	if (mapFailures > 0) std::cout << ", " << mapFailures << " bands uploaded from client memory after a failed map";
+	std::cout << '\n';
+}
+
+void PixelUploadRing::destroy() {
+	for (GLsync& fence : fences) {
+		if (fence) glDeleteSync(fence);
+		fence = NULL;
+	}
+	glDeleteBuffers(1, &buffer);
+	buffer = 0;
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include <glad/glad.h>
+#include <cstddef>
+#include <vector>
+
+// One GL_PIXEL_UNPACK_BUFFER split into segments that are reused round-robin. Each segment is
+// mapped unsynchronized and guarded by a fence, so the CPU only waits when it laps the GPU.
+// Images larger than a segment stream through the ring in bands of whole rows. A band whose
+// segment fails to map is uploaded straight from client memory instead.
+class PixelUploadRing {
+public:
+	PixelUploadRing();
+
+	void create(const unsigned segmentCount, const std::size_t segmentSize);
+	void uploadTexture2D(const int level, const int width, const int height, const unsigned format, const unsigned char* pixels);
+	void uploadCompressedTexture2D(const int level, const int width, const int height, const unsigned internalFormat, const std::size_t bytesPerBlock, const unsigned char* blocks);
+	void report() const;
+	void destroy();
+
+private:
+	unsigned acquireSegment();
+	bool stageBand(const unsigned char* source, const std::size_t byteCount, unsigned& segment, std::size_t& offset);
+
+	unsigned buffer;
+	std::size_t segmentSize;
+	std::vector<GLsync> fences;
+	unsigned nextSegment;
+
+	unsigned long long bytesUploaded;
+	double uploadMilliseconds;
+	double stallMilliseconds;
+	unsigned stallCount;
+	unsigned mapFailures;
+};
@@ -0,0 +1,129 @@
+#include "ProgramCache.h"
+#include "GLExtensions.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+namespace {
+	const char CACHE_MAGIC[8] = { 'L', 'O', 'G', 'L', 'P', 'R', 'G', '1' };
+
+	struct CacheEntryHeader {
+		char magic[8];
+		std::uint64_t key;
+		unsigned binaryFormat;
+		unsigned binaryLength;
+		double compileMilliseconds;
+	};
+
+	std::uint64_t hashBytes(std::uint64_t hash, const void* data, const std::size_t length) {
+		const unsigned char* bytes = static_cast<const unsigned char*>(data);
+		for (std::size_t i = 0; i < length; ++i) {
+			hash ^= bytes[i];
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+
+	std::uint64_t hashString(const std::uint64_t hash, const char* text) {
+		return text ? hashBytes(hash, text, std::strlen(text) + 1) : hashBytes(hash, "", 1);
+	}
+}
+
+ProgramCache::ProgramCache(const char* directory) : directory(directory), hits(0), misses(0), millisecondsSaved(0.0) {}
+
+std::uint64_t ProgramCache::cacheKey(const std::string& vertexSource, const std::string& fragmentSource) const {
+	std::uint64_t hash = 14695981039346656037ull;
+	hash = hashString(hash, vertexSource.c_str());
+	hash = hashString(hash, fragmentSource.c_str());
+	hash = hashString(hash, reinterpret_cast<const char*>(glGetString(GL_VENDOR)));
+	hash = hashString(hash, reinterpret_cast<const char*>(glGetString(GL_RENDERER)));
+	hash = hashString(hash, reinterpret_cast<const char*>(glGetString(GL_VERSION)));
+	hash = hashString(hash, reinterpret_cast<const char*>(glGetString(GL_SHADING_LANGUAGE_VERSION)));
+	return hash;
+}
+
+std::string ProgramCache::entryPath(const std::uint64_t key) const {
+	char fileName[32];
+	std::snprintf(fileName, sizeof(fileName), "%016llx.bin", static_cast<unsigned long long>(key));
+	return directory + '/' + fileName;
+}
+
+unsigned ProgramCache::load(const char* label, const std::string& vertexSource, const std::string& fragmentSource) {
+	if (!GLAD_GL_ARB_get_program_binary) return 0;
+
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	const std::uint64_t key = cacheKey(vertexSource, fragmentSource);
+	const std::string path = entryPath(key);
+	std::ifstream entryFile(path, std::ios::binary);
+	CacheEntryHeader header;
+	if (!entryFile.read(reinterpret_cast<char*>(&header), sizeof(header)) || std::memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 || header.key != key) {
+		++misses;
+		std::cout << "Shader cache miss for " << label << '\n';
+		return 0;
+	}
+
+	// binaryLength is checked against the file before it sizes an allocation, so a truncated or
+	// corrupt entry is a miss rather than a huge allocation or a short read.
+	std::error_code error;
+	const std::uintmax_t fileSize = std::filesystem::file_size(path, error);
+	std::vector<char> binary;
+	if (!error && header.binaryLength == fileSize - sizeof(header)) {
+		binary.resize(header.binaryLength);
+		entryFile.read(binary.data(), binary.size());
+	}
+	if (binary.empty() || !entryFile) {
+		++misses;
+		std::cout << "Shader cache entry for " << label << " is truncated or corrupt, recompiling" << '\n';
+		return 0;
+	}
+	unsigned program = glCreateProgram();
+	glProgramBinary(program, header.binaryFormat, binary.data(), static_cast<int>(binary.size()));
+
+	int success = 0;
+	glGetProgramiv(program, GL_LINK_STATUS, &success);
+	if (!success) {
+		glDeleteProgram(program);
+		++misses;
+		std::cout << "Shader cache entry for " << label << " was rejected by the driver, recompiling" << '\n';
+		return 0;
+	}
+
+	const double loadMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	++hits;
+	millisecondsSaved += header.compileMilliseconds - loadMilliseconds;
+	std::cout << "Shader cache hit for " << label << ": loaded in " << loadMilliseconds << " ms, saved " << header.compileMilliseconds - loadMilliseconds << " ms" << '\n';
+	return program;
+}
+
+void ProgramCache::store(const unsigned program, const std::string& vertexSource, const std::string& fragmentSource, const double compileMilliseconds) {
+	if (!GLAD_GL_ARB_get_program_binary) return;
+
+	int success = 0;
+	int binaryLength = 0;
+	glGetProgramiv(program, GL_LINK_STATUS, &success);
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &binaryLength);
+	if (!success || binaryLength <= 0) return;
+
+	std::vector<char> binary(binaryLength);
+	CacheEntryHeader header;
+	std::memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+	header.key = cacheKey(vertexSource, fragmentSource);
+	header.compileMilliseconds = compileMilliseconds;
+	glGetProgramBinary(program, binaryLength, &binaryLength, &header.binaryFormat, binary.data());
+	header.binaryLength = static_cast<unsigned>(binaryLength);
+
+	std::error_code error;
+	std::filesystem::create_directories(directory, error);
+	std::ofstream entryFile(entryPath(header.key), std::ios::binary | std::ios::trunc);
+	entryFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	entryFile.write(binary.data(), header.binaryLength);
+	if (!entryFile) std::cout << "Could not write shader cache entry to " << directory << '\n';
+}
+
+void ProgramCache::report() const {
+	std::cout << "Shader cache: " << hits << " hits, " << misses << " misses, " << millisecondsSaved << " ms saved" << '\n';
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+// Stores glGetProgramBinary blobs keyed by a hash of the shader sources and the driver identity,
+// so a driver update or an edited shader simply misses and falls back to compiling.
+class ProgramCache {
+public:
+	explicit ProgramCache(const char* directory);
+
+	unsigned load(const char* label, const std::string& vertexSource, const std::string& fragmentSource);
+	void store(const unsigned program, const std::string& vertexSource, const std::string& fragmentSource, const double compileMilliseconds);
+	void report() const;
+
+private:
+	std::uint64_t cacheKey(const std::string& vertexSource, const std::string& fragmentSource) const;
+	std::string entryPath(const std::uint64_t key) const;
+
+	std::string directory;
+	unsigned hits;
+	unsigned misses;
+	double millisecondsSaved;
+};
@@ -0,0 +1,211 @@
+#include "RenderQueue.h"
+#include "CommandBuffer.h"
+#include "InstanceBuffer.h"
+#include "JobSystem.h"
+#include "MeshBuilder.h"
+#include "ShaderProgram.h"
+#include <glad/glad.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+namespace {
+	const int RADIX_BITS = 8;
+	const int BUCKET_COUNT = 1 << RADIX_BITS;
+	const int PASS_COUNT = 64 / RADIX_BITS;
+
+	// Runs work(chunk) for every chunk, as one job each when there is more than one.
+	template <typename Work>
+	void forEachChunk(JobSystem* jobSystem, const std::size_t chunkCount, const Work& work) {
+		if (chunkCount == 1) {
+			work(0);
+			return;
+		}
+		parallelFor(*jobSystem, chunkCount, [&](const std::size_t begin, const std::size_t end) {
+			for (std::size_t chunk = begin; chunk < end; ++chunk) work(chunk);
+		}, 1);
+	}
+
+	unsigned bucketOf(const SortEntry& entry, const int pass) {
+		return static_cast<unsigned>(entry.key >> (pass * RADIX_BITS)) & (BUCKET_COUNT - 1);
+	}
+
+	// Program, texture or vertex array switches needed to draw the packets in this order.
+	std::size_t countStateChanges(const std::vector<DrawPacket>& packets, const SortEntry* order) {
+		std::size_t changes = 0;
+		const ShaderProgram* program = NULL;
+		unsigned texture = 0, vertexArray = 0;
+		for (std::size_t i = 0; i < packets.size(); ++i) {
+			const DrawPacket& packet = packets[order ? order[i].index : i];
+			changes += (i == 0 || packet.program != program) + (i == 0 || packet.texture != texture) + (i == 0 || packet.mesh->vertexArray != vertexArray);
+			program = packet.program;
+			texture = packet.texture;
+			vertexArray = packet.mesh->vertexArray;
+		}
+		return changes;
+	}
+}
+
+std::uint64_t makeSortKey(const unsigned program, const unsigned texture, const unsigned vertexArray, const float depth) {
+	// A non-negative float's bit pattern orders the same way as its value, so the top 24 of its
+	// 31 magnitude bits make a monotonic depth field without knowing the depth range.
+	std::uint32_t depthBits = 0;
+	if (depth > 0.0f) std::memcpy(&depthBits, &depth, sizeof(depthBits));
+	return (static_cast<std::uint64_t>(program & 0xFFF) << 52) | (static_cast<std::uint64_t>(texture & 0x3FFF) << 38)
+		| (static_cast<std::uint64_t>(vertexArray & 0x3FFF) << 24) | (depthBits >> 7);
+}
+
+void radixSort(SortEntry* entries, SortEntry* scratch, const std::size_t count, JobSystem* jobSystem) {
+	const std::size_t chunkCount = (jobSystem && count >= PARALLEL_SORT_THRESHOLD) ? jobSystem->threadCount() : 1;
+	const std::size_t chunkSize = (count + chunkCount - 1) / chunkCount;
+
+	SortEntry* source = entries;
+	SortEntry* destination = scratch;
+	std::vector<std::size_t> histograms(chunkCount * BUCKET_COUNT);
+	for (int pass = 0; pass < PASS_COUNT; ++pass) {
+		// Each chunk is counted on its own, then scattered behind the earlier chunks' entries for
+		// every bucket, which keeps the sort stable.
+		std::fill(histograms.begin(), histograms.end(), 0);
+		forEachChunk(jobSystem, chunkCount, [&](const std::size_t chunk) {
+			std::size_t* histogram = &histograms[chunk * BUCKET_COUNT];
+			const std::size_t end = std::min(count, (chunk + 1) * chunkSize);
+			for (std::size_t i = chunk * chunkSize; i < end; ++i) ++histogram[bucketOf(source[i], pass)];
+		});
+
+		bool singleBucket = false;
+		std::size_t offset = 0;
+		for (int bucket = 0; bucket < BUCKET_COUNT; ++bucket) {
+			std::size_t bucketTotal = 0;
+			for (std::size_t chunk = 0; chunk < chunkCount; ++chunk) {
+				std::size_t& slot = histograms[chunk * BUCKET_COUNT + bucket];
+				const std::size_t bucketCount = slot;
+				slot = offset;
+				offset += bucketCount;
+				bucketTotal += bucketCount;
+			}
+			singleBucket = singleBucket || bucketTotal == count;
+		}
+		if (singleBucket) continue;
+
+		forEachChunk(jobSystem, chunkCount, [&](const std::size_t chunk) {
+			std::size_t* offsets = &histograms[chunk * BUCKET_COUNT];
+			const std::size_t end = std::min(count, (chunk + 1) * chunkSize);
+			for (std::size_t i = chunk * chunkSize; i < end; ++i) destination[offsets[bucketOf(source[i], pass)]++] = source[i];
+		});
+		std::swap(source, destination);
+	}
+	if (source != entries) std::copy(source, source + count, entries);
+}
+
+RenderQueue::RenderQueue() : frameStatistics() {}
+
+void RenderQueue::clear() {
+	packets.clear();
+	frameStatistics = RenderQueueStatistics();
+}
+
+void RenderQueue::push(const DrawPacket& packet) {
+	packets.push_back(packet);
+}
+
+void RenderQueue::sort(JobSystem* jobSystem) {
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	entries.resize(packets.size());
+	scratch.resize(packets.size());
+	for (std::size_t i = 0; i < packets.size(); ++i) {
+		const DrawPacket& packet = packets[i];
+		entries[i].key = makeSortKey(packet.program->id(), packet.texture, packet.mesh->vertexArray, packet.depth);
+		entries[i].index = static_cast<std::uint32_t>(i);
+	}
+	radixSort(entries.data(), scratch.data(), entries.size(), jobSystem);
+	frameStatistics.sortMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	frameStatistics.packets = packets.size();
+	frameStatistics.naiveBinds = 3 * packets.size();
+	frameStatistics.unsortedStateChanges = countStateChanges(packets, NULL);
+	frameStatistics.sortedStateChanges = countStateChanges(packets, entries.data());
+}
+
+// The position scale and bias are set for every packet, but ShaderProgram drops unchanged values.
+void RenderQueue::submit() {
+	ShaderProgram* program = NULL;
+	unsigned texture = 0, vertexArray = 0;
+	bool first = true;
+	for (const SortEntry& entry : entries) {
+		const DrawPacket& packet = packets[entry.index];
+		if (first || packet.program != program) {
+			program = packet.program;
+			program->use();
+		}
+		if (first || packet.mesh->vertexArray != vertexArray) {
+			vertexArray = packet.mesh->vertexArray;
+			glBindVertexArray(vertexArray);
+		}
+		if (first || packet.texture != texture) {
+			texture = packet.texture;
+			glBindTexture(GL_TEXTURE_2D, texture);
+		}
+		first = false;
+
+		program->setVec3("positionScale", packet.mesh->positionScale);
+		program->setVec3("positionBias", packet.mesh->positionBias);
+		if (packet.instances) packet.instances->drawElements(GL_TRIANGLES, packet.mesh->indexCount, packet.mesh->indexType);
+		else glDrawElements(GL_TRIANGLES, packet.mesh->indexCount, packet.mesh->indexType, NULL);
+	}
+}
+
+void RenderQueue::record(std::vector<CommandBuffer>& buffers, JobSystem* jobSystem) const {
+	buffers.resize((jobSystem && entries.size() >= PARALLEL_RECORD_THRESHOLD) ? jobSystem->threadCount() : 1);
+	// Done up front on this thread, since ranges recorded in parallel can share a program.
+	const ShaderProgram* invalidated = NULL;
+	for (const SortEntry& entry : entries) {
+		ShaderProgram* program = packets[entry.index].program;
+		if (program == invalidated) continue;
+		program->invalidateCachedValue(program->uniformSlot("positionScale"));
+		program->invalidateCachedValue(program->uniformSlot("positionBias"));
+		invalidated = program;
+	}
+	// Each range starts from unknown state, since another range may have been replayed before it.
+	recordCommandBuffers(buffers, entries.size(), jobSystem, [this](CommandBuffer& buffer, const std::size_t begin, const std::size_t end) {
+		const ShaderProgram* program = NULL;
+		unsigned texture = 0, vertexArray = 0;
+		int scaleLocation = -1, biasLocation = -1;
+		bool first = true;
+		for (std::size_t i = begin; i < end; ++i) {
+			const DrawPacket& packet = packets[entries[i].index];
+			if (packet.instances && packet.instances->count() == 0) continue;
+			if (first || packet.program != program) {
+				program = packet.program;
+				scaleLocation = program->uniformLocation(program->uniformSlot("positionScale"));
+				biasLocation = program->uniformLocation(program->uniformSlot("positionBias"));
+				buffer.bindProgram(program->id());
+			}
+			if (first || packet.mesh->vertexArray != vertexArray) {
+				vertexArray = packet.mesh->vertexArray;
+				buffer.bindVertexArray(vertexArray);
+			}
+			if (first || packet.texture != texture) {
+				texture = packet.texture;
+				buffer.bindTexture(0, texture);
+			}
+			first = false;
+			buffer.setVec3(scaleLocation, packet.mesh->positionScale);
+			buffer.setVec3(biasLocation, packet.mesh->positionBias);
+			buffer.drawElements(GL_TRIANGLES, packet.mesh->indexCount, packet.mesh->indexType, packet.instances ? static_cast<int>(packet.instances->count()) : 0);
+		}
+	});
+}
+
+std::size_t RenderQueue::size() const {
+	return packets.size();
+}
+
+const RenderQueueStatistics& RenderQueue::statistics() const {
+	return frameStatistics;
+}
+
+void RenderQueue::report() const {
+	std::cout << "Render queue: " << frameStatistics.packets << " draws, state changes " << frameStatistics.naiveBinds << " binding everything, "
+		<< frameStatistics.unsortedStateChanges << " unsorted, " << frameStatistics.sortedStateChanges << " sorted (sort " << frameStatistics.sortMilliseconds << " ms)" << '\n';
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class CommandBuffer;
+class InstanceBuffer;
+class JobSystem;
+class ShaderProgram;
+struct MeshBuffers;
+
+// One draw: the mesh's VAO and indices, the program and the texture on unit 0. depth is the
+// view-space distance used to order draws front to back within the same state.
+struct DrawPacket {
+	ShaderProgram* program;
+	unsigned texture;
+	const MeshBuffers* mesh;
+	const InstanceBuffer* instances;
+	float depth;
+};
+
+struct SortEntry {
+	std::uint64_t key;
+	std::uint32_t index;
+};
+
+struct RenderQueueStatistics {
+	std::size_t packets;
+	std::size_t naiveBinds;
+	std::size_t unsortedStateChanges;
+	std::size_t sortedStateChanges;
+	double sortMilliseconds;
+};
+
+// Bits 63-52 program, 51-38 texture, 37-24 vertex array, 23-0 depth, so sorting groups draws by
+// the most expensive state first. GL names are masked into their fields; two names that collide
+// only sort next to each other, since submission binds the real ones.
+std::uint64_t makeSortKey(const unsigned program, const unsigned texture, const unsigned vertexArray, const float depth);
+
+// Stable LSD radix sort on the key, eight bits per pass, skipping passes where every key has the
+// same byte. Counts past PARALLEL_SORT_THRESHOLD split each pass into one chunk per thread of
+// jobSystem, which must be called from one of its threads; without one the sort runs on the
+// calling thread. scratch must hold count entries; the result ends up in entries.
+const std::size_t PARALLEL_SORT_THRESHOLD = 1 << 16;
+void radixSort(SortEntry* entries, SortEntry* scratch, const std::size_t count, JobSystem* jobSystem = NULL);
+
+const std::size_t PARALLEL_RECORD_THRESHOLD = 4096;
+
+// Collects a frame's draws, sorts them by key and submits them, binding only state that changes.
+class RenderQueue {
+public:
+	RenderQueue();
+
+	void clear();
+	void push(const DrawPacket& packet);
+	void sort(JobSystem* jobSystem = NULL);
+	void submit();
+	// Records the sorted draws into buffers for replayCommandBuffers() on the GL thread, one buffer
+	// per thread of jobSystem once there are PARALLEL_RECORD_THRESHOLD draws.
+	// Uniforms go straight to their locations, so the programs forget their cached values for
+	// those uniforms here, before any replay can change them.
+	void record(std::vector<CommandBuffer>& buffers, JobSystem* jobSystem = NULL) const;
+	std::size_t size() const;
+
+	const RenderQueueStatistics& statistics() const;
+	void report() const;
+
+private:
+	std::vector<DrawPacket> packets;
+	std::vector<SortEntry> entries;
+	std::vector<SortEntry> scratch;
+	RenderQueueStatistics frameStatistics;
+};
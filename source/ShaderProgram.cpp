@@ -0,0 +1,321 @@
+#include "ShaderProgram.h"
+#include "FrameConstants.h"
+#include "GLExtensions.h"
+#include "ProgramCache.h"
+#include <glm/gtc/type_ptr.hpp>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <fstream>
+
+namespace {
+	const unsigned MAX_UNIFORM_VALUE_BYTES = sizeof(glm::mat4);
+
+	unsigned hashUniformName(const char* name, const unsigned seed) {
+		unsigned hash = 2166136261u ^ (seed * 16777619u);
+		for (; *name; ++name) {
+			hash ^= static_cast<unsigned char>(*name);
+			hash *= 16777619u;
+		}
+		return hash;
+	}
+}
+
+bool checkShaderErrors(const unsigned shader, const char* wordName, const bool isProgram) {
+	int success;
+	char errorMessage[512];
+
+	if (isProgram) {
+		glGetProgramiv(shader, GL_LINK_STATUS, &success);
+		if (!success) {
+			glGetProgramInfoLog(shader, sizeof(errorMessage), NULL, errorMessage);
+			std::cout << "There was an error linking the " << wordName << ':' <<'\n' << errorMessage << '\n';
+		}
+	} else {
+		glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+		if (!success) {
+			glGetShaderInfoLog(shader, sizeof(errorMessage), NULL, errorMessage);
+			std::cout << "There was an error compiling the " << wordName << ':' << '\n' << errorMessage << '\n';
+		}
+	}
+
+	return success;
+}
+
+unsigned compileShaderProgram(const char* vertexShaderContents, const char* fragmentShaderContents) {
+	unsigned vertexShader;
+	vertexShader = glCreateShader(GL_VERTEX_SHADER);
+	glShaderSource(vertexShader, 1, &vertexShaderContents, NULL);
+	glCompileShader(vertexShader);
+	checkShaderErrors(vertexShader, "vertex shader", false);
+
+	unsigned fragmentShader;
+	fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
+	glShaderSource(fragmentShader, 1, &fragmentShaderContents, NULL);
+	glCompileShader(fragmentShader);
+	checkShaderErrors(fragmentShader, "fragment shader", false);
+
+	unsigned shaderProgram;
+	shaderProgram = glCreateProgram();
+	if (GLAD_GL_ARB_get_program_binary) glProgramParameteri(shaderProgram, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	glAttachShader(shaderProgram, vertexShader);
+	glAttachShader(shaderProgram, fragmentShader);
+	glLinkProgram(shaderProgram);
+	checkShaderErrors(shaderProgram, "shader program", true);
+
+	glDeleteShader(vertexShader);
+	glDeleteShader(fragmentShader);
+
+	return shaderProgram;
+}
+
+unsigned createShaderProgram(const char* vertexShaderPath, const char* fragmentShaderPath, ProgramCache* cache) {
+	std::ifstream vertexShaderFile(vertexShaderPath);
+	std::ifstream fragmentShaderFile(fragmentShaderPath);
+	std::stringstream intermediary;
+
+	intermediary << vertexShaderFile.rdbuf();
+	std::string vertexTempStringHolder = intermediary.str();
+
+	intermediary.str("");
+	intermediary.clear();
+	intermediary << fragmentShaderFile.rdbuf();
+	std::string fragmentTempStringHolder = intermediary.str();
+
+	unsigned shaderProgram = cache ? cache->load(vertexShaderPath, vertexTempStringHolder, fragmentTempStringHolder) : 0;
+	if (!shaderProgram) {
+		const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		shaderProgram = compileShaderProgram(vertexTempStringHolder.c_str(), fragmentTempStringHolder.c_str());
+		const double compileMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		if (cache) cache->store(shaderProgram, vertexTempStringHolder, fragmentTempStringHolder, compileMilliseconds);
+	}
+	bindFrameConstantsBlock(shaderProgram);
+
+	return shaderProgram;
+}
+
+int ShaderBatch::add(const std::string& vertexSource, const std::string& fragmentSource) {
+	Entry entry = { vertexSource, fragmentSource, 0, 0, 0, false };
+	entries.push_back(entry);
+	return static_cast<int>(entries.size() - 1);
+}
+
+void ShaderBatch::submit() {
+	if (GLAD_GL_KHR_parallel_shader_compile) glMaxShaderCompilerThreadsKHR(0xFFFFFFFFu);
+
+	for (Entry& entry : entries) {
+		if (entry.program) continue;
+		const char* vertexShaderContents = entry.vertexSource.c_str();
+		const char* fragmentShaderContents = entry.fragmentSource.c_str();
+		entry.vertexShader = glCreateShader(GL_VERTEX_SHADER);
+		glShaderSource(entry.vertexShader, 1, &vertexShaderContents, NULL);
+		glCompileShader(entry.vertexShader);
+		entry.fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
+		glShaderSource(entry.fragmentShader, 1, &fragmentShaderContents, NULL);
+		glCompileShader(entry.fragmentShader);
+	}
+
+	for (Entry& entry : entries) {
+		if (entry.program) continue;
+		entry.program = glCreateProgram();
+		glAttachShader(entry.program, entry.vertexShader);
+		glAttachShader(entry.program, entry.fragmentShader);
+		glLinkProgram(entry.program);
+	}
+}
+
+bool ShaderBatch::isReady(const int index) const {
+	const Entry& entry = entries[index];
+	if (!entry.program) return false;
+	if (entry.checked || !GLAD_GL_KHR_parallel_shader_compile) return true;
+
+	int completed = 0;
+	glGetProgramiv(entry.program, GL_COMPLETION_STATUS_KHR, &completed);
+	return completed != 0;
+}
+
+bool ShaderBatch::allReady() const {
+	for (std::size_t i = 0; i < entries.size(); ++i) {
+		if (!isReady(static_cast<int>(i))) return false;
+	}
+	return true;
+}
+
+unsigned ShaderBatch::program(const int index) {
+	Entry& entry = entries[index];
+	if (!entry.checked && entry.program) {
+		checkShaderErrors(entry.vertexShader, "vertex shader", false);
+		checkShaderErrors(entry.fragmentShader, "fragment shader", false);
+		checkShaderErrors(entry.program, "shader program", true);
+		bindFrameConstantsBlock(entry.program);
+
+		glDetachShader(entry.program, entry.vertexShader);
+		glDetachShader(entry.program, entry.fragmentShader);
+		glDeleteShader(entry.vertexShader);
+		glDeleteShader(entry.fragmentShader);
+		entry.vertexShader = 0;
+		entry.fragmentShader = 0;
+		entry.checked = true;
+	}
+	return entry.program;
+}
+
+std::size_t ShaderBatch::size() const {
+	return entries.size();
+}
+
+ShaderProgram::ShaderProgram() : program(0), hashSeed(0) {}
+
+ShaderProgram::ShaderProgram(const unsigned programId) : program(programId), hashSeed(0) {
+	reflectUniforms();
+	buildHashTable();
+}
+
+void ShaderProgram::use() const {
+	glUseProgram(program);
+}
+
+void ShaderProgram::destroy() {
+	glDeleteProgram(program);
+	program = 0;
+	uniforms.clear();
+	hashTable.clear();
+	cachedValues.clear();
+}
+
+unsigned ShaderProgram::id() const {
+	return program;
+}
+
+void ShaderProgram::reflectUniforms() {
+	int uniformCount = 0;
+	int maxNameLength = 0;
+	glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &uniformCount);
+	glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+	std::vector<char> nameBuffer(maxNameLength + 1);
+
+	for (int i = 0; i < uniformCount; ++i) {
+		int nameLength = 0;
+		int arraySize = 0;
+		unsigned type = 0;
+		glGetActiveUniform(program, static_cast<unsigned>(i), static_cast<int>(nameBuffer.size()), &nameLength, &arraySize, &type, nameBuffer.data());
+
+		int location = glGetUniformLocation(program, nameBuffer.data());
+		if (location < 0) continue;
+
+		std::string name(nameBuffer.data(), nameLength);
+		if (name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0) name.resize(name.size() - 3);
+
+		Uniform uniform = { name, location, type, static_cast<unsigned>(cachedValues.size()), false };
+		uniforms.push_back(uniform);
+		cachedValues.resize(cachedValues.size() + MAX_UNIFORM_VALUE_BYTES);
+	}
+}
+
+void ShaderProgram::buildHashTable() {
+	if (uniforms.empty()) return;
+
+	unsigned tableSize = 1;
+	while (tableSize < uniforms.size()) tableSize <<= 1;
+
+	for (;; tableSize <<= 1) {
+		for (unsigned seed = 0; seed < 1024; ++seed) {
+			hashTable.assign(tableSize, -1);
+			bool collided = false;
+			for (unsigned i = 0; i < uniforms.size() && !collided; ++i) {
+				int& entry = hashTable[hashUniformName(uniforms[i].name.c_str(), seed) & (tableSize - 1)];
+				if (entry != -1) collided = true;
+				else entry = static_cast<int>(i);
+			}
+			if (!collided) {
+				hashSeed = seed;
+				return;
+			}
+		}
+	}
+}
+
+int ShaderProgram::uniformSlot(const char* name) const {
+	if (hashTable.empty()) return -1;
+
+	int slot = hashTable[hashUniformName(name, hashSeed) & (hashTable.size() - 1)];
+	if (slot == -1 || uniforms[slot].name != name) return -1;
+	return slot;
+}
+
+int ShaderProgram::uniformLocation(const int slot) const {
+	return slot < 0 ? -1 : uniforms[slot].location;
+}
+
+bool ShaderProgram::storeIfChanged(const int slot, const void* value, const unsigned byteCount) {
+	if (slot < 0) return false;
+
+	Uniform& uniform = uniforms[slot];
+	unsigned char* cached = &cachedValues[uniform.valueOffset];
+	if (uniform.hasValue && std::memcmp(cached, value, byteCount) == 0) return false;
+
+	std::memcpy(cached, value, byteCount);
+	uniform.hasValue = true;
+	return true;
+}
+
+void ShaderProgram::invalidateCachedValue(const int slot) {
+	if (slot >= 0) uniforms[slot].hasValue = false;
+}
+
+void ShaderProgram::setInt(const int slot, const int value) {
+	if (storeIfChanged(slot, &value, sizeof(value))) glUniform1i(uniforms[slot].location, value);
+}
+
+void ShaderProgram::setFloat(const int slot, const float value) {
+	if (storeIfChanged(slot, &value, sizeof(value))) glUniform1f(uniforms[slot].location, value);
+}
+
+void ShaderProgram::setVec2(const int slot, const glm::vec2& value) {
+	if (storeIfChanged(slot, glm::value_ptr(value), sizeof(value))) glUniform2fv(uniforms[slot].location, 1, glm::value_ptr(value));
+}
+
+void ShaderProgram::setVec3(const int slot, const glm::vec3& value) {
+	if (storeIfChanged(slot, glm::value_ptr(value), sizeof(value))) glUniform3fv(uniforms[slot].location, 1, glm::value_ptr(value));
+}
+
+void ShaderProgram::setVec4(const int slot, const glm::vec4& value) {
+	if (storeIfChanged(slot, glm::value_ptr(value), sizeof(value))) glUniform4fv(uniforms[slot].location, 1, glm::value_ptr(value));
+}
+
+void ShaderProgram::setMat3(const int slot, const glm::mat3& value) {
+	if (storeIfChanged(slot, glm::value_ptr(value), sizeof(value))) glUniformMatrix3fv(uniforms[slot].location, 1, GL_FALSE, glm::value_ptr(value));
+}
+
+void ShaderProgram::setMat4(const int slot, const glm::mat4& value) {
+	if (storeIfChanged(slot, glm::value_ptr(value), sizeof(value))) glUniformMatrix4fv(uniforms[slot].location, 1, GL_FALSE, glm::value_ptr(value));
+}
+
+void ShaderProgram::setInt(const char* name, const int value) {
+	setInt(uniformSlot(name), value);
+}
+
+void ShaderProgram::setFloat(const char* name, const float value) {
+	setFloat(uniformSlot(name), value);
+}
+
+void ShaderProgram::setVec2(const char* name, const glm::vec2& value) {
+	setVec2(uniformSlot(name), value);
+}
+
+void ShaderProgram::setVec3(const char* name, const glm::vec3& value) {
+	setVec3(uniformSlot(name), value);
+}
+
+void ShaderProgram::setVec4(const char* name, const glm::vec4& value) {
+	setVec4(uniformSlot(name), value);
+}
+
+void ShaderProgram::setMat3(const char* name, const glm::mat3& value) {
+	setMat3(uniformSlot(name), value);
+}
+
+void ShaderProgram::setMat4(const char* name, const glm::mat4& value) {
+	setMat4(uniformSlot(name), value);
+}
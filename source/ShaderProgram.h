@@ -0,0 +1,91 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+class ProgramCache;
+
+bool checkShaderErrors(const unsigned shader, const char* wordName, const bool isProgram);
+unsigned compileShaderProgram(const char* vertexShaderContents, const char* fragmentShaderContents);
+unsigned createShaderProgram(const char* vertexShaderPath, const char* fragmentShaderPath, ProgramCache* cache = NULL);
+
+// Submits every compile and link up front so the driver can work on them in parallel, and only
+// checks a program's status the first time it is requested. With KHR_parallel_shader_compile,
+// isReady() lets callers poll instead of blocking.
+class ShaderBatch {
+public:
+	int add(const std::string& vertexSource, const std::string& fragmentSource);
+	void submit();
+	bool isReady(const int index) const;
+	bool allReady() const;
+	unsigned program(const int index);
+	std::size_t size() const;
+
+private:
+	struct Entry {
+		std::string vertexSource;
+		std::string fragmentSource;
+		unsigned vertexShader;
+		unsigned fragmentShader;
+		unsigned program;
+		bool checked;
+	};
+
+	std::vector<Entry> entries;
+};
+
+// Active uniforms are reflected once after link into a perfect-hashed table, and each setter
+// remembers the last value it uploaded so unchanged values never reach the driver.
+// Setters write to the currently bound program, so call use() first.
+class ShaderProgram {
+public:
+	ShaderProgram();
+	explicit ShaderProgram(const unsigned programId);
+
+	void use() const;
+	void destroy();
+	unsigned id() const;
+
+	int uniformSlot(const char* name) const;
+	int uniformLocation(const int slot) const;
+
+	void setInt(const int slot, const int value);
+	void setFloat(const int slot, const float value);
+	void setVec2(const int slot, const glm::vec2& value);
+	void setVec3(const int slot, const glm::vec3& value);
+	void setVec4(const int slot, const glm::vec4& value);
+	void setMat3(const int slot, const glm::mat3& value);
+	void setMat4(const int slot, const glm::mat4& value);
+
+	void setInt(const char* name, const int value);
+	void setFloat(const char* name, const float value);
+	void setVec2(const char* name, const glm::vec2& value);
+	void setVec3(const char* name, const glm::vec3& value);
+	void setVec4(const char* name, const glm::vec4& value);
+	void setMat3(const char* name, const glm::mat3& value);
+	void setMat4(const char* name, const glm::mat4& value);
+
+	// Forgets the last value uploaded for slot, for when something set the uniform behind the
+	// program's back, so the next setter uploads again.
+	void invalidateCachedValue(const int slot);
+
+private:
+	struct Uniform {
+		std::string name;
+		int location;
+		unsigned type;
+		unsigned valueOffset;
+		bool hasValue;
+	};
+
+	void reflectUniforms();
+	void buildHashTable();
+	bool storeIfChanged(const int slot, const void* value, const unsigned byteCount);
+
+	unsigned program;
+	std::vector<Uniform> uniforms;
+	std::vector<int> hashTable;
+	unsigned hashSeed;
+	std::vector<unsigned char> cachedValues;
+};
@@ -0,0 +1,19 @@
+#include "SimulationStep.h"
+
+InputTimeline::InputTimeline() : held({ 0.0f, 0.0f }) {}
+
+void InputTimeline::record(const KeyChange& change) {
+	changes.push_back(change);
+}
+
+HeldKeys InputTimeline::keysAt(const double seconds) {
+	std::size_t passed = 0;
+	while (passed < changes.size() && changes[passed].seconds <= seconds) held = changes[passed++].keys;
+	changes.erase(changes.begin(), changes.begin() + passed);
+	return held;
+}
+
+void stepSimulation(Transform& camera, Transform& cube, const HeldKeys& keys, const float stepSeconds) {
+	if (keys.moveAxis != 0.0f) camera.translate(glm::vec3(0.0f, 0.0f, keys.moveAxis * CAMERA_SPEED * stepSeconds));
+	if (keys.turnAxis != 0.0f) cube.rotate(glm::radians(keys.turnAxis * TURN_DEGREES_PER_SECOND * stepSeconds), glm::vec3(0.5, 1.0, 0.0));
+}
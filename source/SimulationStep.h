@@ -0,0 +1,38 @@
+#pragma once
+#include "Transform.h"
+#include <vector>
+
+// Held keys move the camera and turn the cube at these rates.
+const float CAMERA_SPEED = 6.0f;
+const float TURN_DEGREES_PER_SECOND = 300.0f;
+
+// -1, 0 or 1 on each axis.
+struct HeldKeys {
+	float moveAxis;
+	float turnAxis;
+};
+
+// The keys held from seconds on.
+struct KeyChange {
+	double seconds;
+	HeldKeys keys;
+};
+
+// Key changes in time order, so every fixed step can use the keys held at its own start time
+// (FixedTimestep::stepStartSeconds) and the result does not depend on the frame rate. A change
+// that is undone before the next step starts is never seen.
+class InputTimeline {
+public:
+	InputTimeline();
+
+	void record(const KeyChange& change);
+	// Queries must not go back in time; changes that have been passed are dropped.
+	HeldKeys keysAt(const double seconds);
+
+private:
+	std::vector<KeyChange> changes;
+	HeldKeys held;
+};
+
+// Advances the camera and cube by one fixed step of stepSeconds with keys held throughout.
+void stepSimulation(Transform& camera, Transform& cube, const HeldKeys& keys, const float stepSeconds);
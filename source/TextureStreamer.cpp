@@ -0,0 +1,204 @@
+#include "TextureStreamer.h"
+#include "MappedFile.h"
+#include <glad/glad.h>
+#include <stb_image.h>
+#include <chrono>
+#include <iostream>
+#include <utility>
+
+TextureStreamer::TextureStreamer() : stopping(false), mipFilter(MipFilter::Kaiser), compressTextures(false), decodedImages(64), placeholderTexture(0), pending(0) {}
+
+void TextureStreamer::create(unsigned workerCount, const MipFilter mipFilter, const bool compressTextures) {
+	const unsigned char placeholderPixels[] = {
+		255, 0, 255,  0, 0, 0,
+		0, 0, 0,  255, 0, 255
+	};
+	glGenTextures(1, &placeholderTexture);
+	glBindTexture(GL_TEXTURE_2D, placeholderTexture);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, 2, 2, 0, GL_RGB, GL_UNSIGNED_BYTE, placeholderPixels);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	uploadRing.create(4, 4 * 1024 * 1024);
+
+	if (workerCount == 0) workerCount = std::thread::hardware_concurrency() > 1 ? std::thread::hardware_concurrency() - 1 : 1;
+	stopping = false;
+	this->mipFilter = mipFilter;
+	this->compressTextures = compressTextures && isBlockFormatSupported(BlockFormat::BC1) && isBlockFormatSupported(BlockFormat::BC3);
+	for (unsigned i = 0; i < workerCount; ++i) workers.emplace_back(&TextureStreamer::decodeWorker, this);
+}
+
+int TextureStreamer::request(const char* path, const bool flipVertically, const bool isSrgb) {
+	Entry entry = { path, 0, false };
+	glGenTextures(1, &entry.texture);
+	entries.push_back(entry);
+	const int handle = static_cast<int>(entries.size() - 1);
+	++pending;
+
+	{
+		std::lock_guard<std::mutex> lock(jobMutex);
+		DecodeJob job = { handle, path, flipVertically, isSrgb };
+		jobs.push_back(job);
+	}
+	jobAvailable.notify_one();
+	return handle;
+}
+
+void TextureStreamer::decodeWorker() {
+	for (;;) {
+		DecodeJob job;
+		{
+			std::unique_lock<std::mutex> lock(jobMutex);
+			jobAvailable.wait(lock, [this] { return stopping || !jobs.empty(); });
+			if (stopping) return;
+			job = jobs.front();
+			jobs.pop_front();
+		}
+
+		DecodedImage image = { job.handle, NULL, 0, 0, 0, {}, {}, BlockFormat::BC1, NULL, NULL, NULL };
+		if (job.path.size() > 5 && job.path.compare(job.path.size() - 5, 5, ".ctex") == 0) {
+			image.cookedFile = new MappedFile();
+			if (image.cookedFile->open(job.path.c_str())) image.cookedHeader = validateCookedTexture(*image.cookedFile);
+			if (!image.cookedHeader) image.failureReason = "not a valid cooked texture";
+			else if (job.flipVertically) image.failureReason = "cooked textures are stored unflipped and cannot be flipped on load";
+			else if ((image.cookedHeader->isSrgb != 0) != job.isSrgb) image.failureReason = "the cooked texture's color space does not match the requested one";
+			else image.cookedFile->prefetch();
+		} else {
+			stbi_set_flip_vertically_on_load_thread(job.flipVertically);
+			image.pixels = stbi_load(job.path.c_str(), &image.width, &image.height, &image.channels, 0);
+			if (image.pixels) {
+				generateMipChain(image.pixels, image.width, image.height, image.channels, job.isSrgb, mipFilter, image.mipLevels);
+				if (compressTextures) compressImageLevels(image);
+			} else {
+				image.failureReason = stbi_failure_reason();
+			}
+		}
+
+		while (!decodedImages.push(std::move(image))) {
+			if (stopping) {
+				releaseImage(image);
+				return;
+			}
+			std::this_thread::yield();
+		}
+	}
+}
+
+void TextureStreamer::update(const double budgetMilliseconds) {
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	DecodedImage image;
+	while (decodedImages.pop(image)) {
+		upload(image);
+		if (std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() >= budgetMilliseconds) break;
+	}
+}
+
+void TextureStreamer::upload(const DecodedImage& image) {
+	Entry& entry = entries[image.handle];
+	--pending;
+	if (image.failureReason) {
+		std::cout << "There was an error loading the texture " << entry.path << ':' << '\n' << image.failureReason << '\n';
+		releaseImage(image);
+		return;
+	}
+
+	glBindTexture(GL_TEXTURE_2D, entry.texture);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	if (image.cookedHeader) {
+		entry.ready = uploadCookedTexture(*image.cookedHeader, image.cookedFile->data());
+		if (!entry.ready) std::cout << "There was an error loading the texture " << entry.path << ':' << '\n' << "its compressed format is not supported by this driver" << '\n';
+		glBindTexture(GL_TEXTURE_2D, 0);
+		releaseImage(image);
+		return;
+	}
+
+	if (!image.compressedLevels.empty()) {
+		const unsigned internalFormat = blockFormatGLInternalFormat(image.blockFormat);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<int>(image.compressedLevels.size() - 1));
+		for (std::size_t i = 0; i < image.compressedLevels.size(); ++i) {
+			const MipLevel& level = image.compressedLevels[i];
+			glCompressedTexImage2D(GL_TEXTURE_2D, static_cast<int>(i), internalFormat, level.width, level.height, 0, static_cast<int>(level.pixels.size()), NULL);
+			uploadRing.uploadCompressedTexture2D(static_cast<int>(i), level.width, level.height, internalFormat, blockBytes(image.blockFormat), level.pixels.data());
+		}
+		glBindTexture(GL_TEXTURE_2D, 0);
+		releaseImage(image);
+		entry.ready = true;
+		return;
+	}
+
+	unsigned format = (image.channels == 4) ? GL_RGBA : (image.channels == 3) ? GL_RGB : (image.channels == 2) ? GL_RG : GL_RED;
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<int>(image.mipLevels.size()));
+	glTexImage2D(GL_TEXTURE_2D, 0, format, image.width, image.height, 0, format, GL_UNSIGNED_BYTE, NULL);
+	uploadRing.uploadTexture2D(0, image.width, image.height, format, image.pixels);
+	for (std::size_t i = 0; i < image.mipLevels.size(); ++i) {
+		const MipLevel& level = image.mipLevels[i];
+		glTexImage2D(GL_TEXTURE_2D, static_cast<int>(i + 1), format, level.width, level.height, 0, format, GL_UNSIGNED_BYTE, NULL);
+		uploadRing.uploadTexture2D(static_cast<int>(i + 1), level.width, level.height, format, level.pixels.data());
+	}
+	glBindTexture(GL_TEXTURE_2D, 0);
+	releaseImage(image);
+	entry.ready = true;
+}
+
+void TextureStreamer::compressImageLevels(DecodedImage& image) {
+	image.blockFormat = chooseBlockFormat(image.pixels, image.width, image.height, image.channels, false, false);
+	image.compressedLevels.resize(image.mipLevels.size() + 1);
+
+	MipLevel& base = image.compressedLevels[0];
+	base.width = image.width;
+	base.height = image.height;
+	compressImage(image.pixels, image.width, image.height, image.channels, image.blockFormat, BlockQuality::Fast, 1, base.pixels);
+	for (std::size_t i = 0; i < image.mipLevels.size(); ++i) {
+		const MipLevel& source = image.mipLevels[i];
+		MipLevel& level = image.compressedLevels[i + 1];
+		level.width = source.width;
+		level.height = source.height;
+		compressImage(source.pixels.data(), source.width, source.height, image.channels, image.blockFormat, BlockQuality::Fast, 1, level.pixels);
+	}
+}
+
+void TextureStreamer::releaseImage(const DecodedImage& image) {
+	stbi_image_free(image.pixels);
+	delete image.cookedFile;
+}
+
+unsigned TextureStreamer::texture(const int handle) const {
+	return entries[handle].ready ? entries[handle].texture : placeholderTexture;
+}
+
+bool TextureStreamer::isReady(const int handle) const {
+	return entries[handle].ready;
+}
+
+unsigned TextureStreamer::pendingCount() const {
+	return pending;
+}
+
+void TextureStreamer::reportUploads() const {
+	uploadRing.report();
+}
+
+void TextureStreamer::destroy() {
+	{
+		std::lock_guard<std::mutex> lock(jobMutex);
+		stopping = true;
+		jobs.clear();
+	}
+	jobAvailable.notify_all();
+	for (std::thread& worker : workers) worker.join();
+	workers.clear();
+
+	DecodedImage image;
+	while (decodedImages.pop(image)) releaseImage(image);
+
+	for (Entry& entry : entries) glDeleteTextures(1, &entry.texture);
+	entries.clear();
+	uploadRing.destroy();
+	glDeleteTextures(1, &placeholderTexture);
+	placeholderTexture = 0;
+	pending = 0;
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include "CookedTexture.h"
+#include "LockFreeQueue.h"
+#include "MipChain.h"
+#include "PixelUploadRing.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class MappedFile;
+
+// Decodes images, builds their mip chains and optionally block-compresses them on worker threads
+// (or maps pre-mipped .ctex files written by --texcook), then uploads every level on the GL thread under a per-frame time budget.
+// texture() hands out a placeholder until a request's upload has finished.
+class TextureStreamer {
+public:
+	TextureStreamer();
+
+	void create(unsigned workerCount = 0, const MipFilter mipFilter = MipFilter::Kaiser, const bool compressTextures = false);
+	// A .ctex file is uploaded as cooked, so it fails to load if flipVertically or isSrgb disagree with it.
+	int request(const char* path, const bool flipVertically = false, const bool isSrgb = true);
+	void update(const double budgetMilliseconds);
+	unsigned texture(const int handle) const;
+	bool isReady(const int handle) const;
+	unsigned pendingCount() const;
+	void reportUploads() const;
+	void destroy();
+
+private:
+	struct DecodeJob {
+		int handle;
+		std::string path;
+		bool flipVertically;
+		bool isSrgb;
+	};
+
+	struct DecodedImage {
+		int handle;
+		unsigned char* pixels;
+		int width;
+		int height;
+		int channels;
+		std::vector<MipLevel> mipLevels;
+		std::vector<MipLevel> compressedLevels;
+		BlockFormat blockFormat;
+		MappedFile* cookedFile;
+		const CookedTextureHeader* cookedHeader;
+		const char* failureReason;
+	};
+
+	struct Entry {
+		std::string path;
+		unsigned texture;
+		bool ready;
+	};
+
+	void decodeWorker();
+	void upload(const DecodedImage& image);
+	void compressImageLevels(DecodedImage& image);
+	static void releaseImage(const DecodedImage& image);
+
+	std::vector<std::thread> workers;
+	std::mutex jobMutex;
+	std::condition_variable jobAvailable;
+	std::deque<DecodeJob> jobs;
+	std::atomic<bool> stopping;
+	MipFilter mipFilter;
+	bool compressTextures;
+	LockFreeQueue<DecodedImage> decodedImages;
+
+	std::vector<Entry> entries;
+	PixelUploadRing uploadRing;
+	unsigned placeholderTexture;
+	unsigned pending;
+};
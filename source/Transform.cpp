@@ -0,0 +1,89 @@
+#include "Transform.h"
+#include <glm/simd/matrix.h>
+
+Transform::Transform() : translation(0.0f), orientation(1.0f, 0.0f, 0.0f, 0.0f), scaling(1.0f), cachedMatrix(1.0f), dirty(false) {}
+
+void Transform::setPosition(const glm::vec3& position) {
+	translation = position;
+	dirty = true;
+}
+
+void Transform::setRotation(const glm::quat& rotation) {
+	orientation = glm::normalize(rotation);
+	dirty = true;
+}
+
+void Transform::setScale(const glm::vec3& scale) {
+	scaling = scale;
+	dirty = true;
+}
+
+void Transform::translate(const glm::vec3& offset) {
+	translation += offset;
+	dirty = true;
+}
+
+// Rotates about a local axis, like glm::rotate(matrix, ...) did. Renormalizing every time keeps the
+// quaternion on the unit sphere however many small rotations are applied.
+void Transform::rotate(const float radians, const glm::vec3& axis) {
+	orientation = glm::normalize(orientation * glm::angleAxis(radians, glm::normalize(axis)));
+	dirty = true;
+}
+
+const glm::vec3& Transform::position() const {
+	return translation;
+}
+
+const glm::quat& Transform::rotation() const {
+	return orientation;
+}
+
+const glm::vec3& Transform::scale() const {
+	return scaling;
+}
+
+bool Transform::isDirty() const {
+	return dirty;
+}
+
+// T * R * S written out directly: the rotation columns come from the quaternion and are scaled in
+// place, so no matrix multiply is needed.
+const glm::mat4& Transform::matrix() {
+	if (!dirty) return cachedMatrix;
+
+	const glm::mat3 rotationMatrix = glm::mat3_cast(orientation);
+	cachedMatrix[0] = glm::vec4(rotationMatrix[0] * scaling.x, 0.0f);
+	cachedMatrix[1] = glm::vec4(rotationMatrix[1] * scaling.y, 0.0f);
+	cachedMatrix[2] = glm::vec4(rotationMatrix[2] * scaling.z, 0.0f);
+	cachedMatrix[3] = glm::vec4(translation, 1.0f);
+	dirty = false;
+	return cachedMatrix;
+}
+
+void multiplyMatrices(const glm::mat4& parent, const glm::mat4& local, glm::mat4& out) {
+#if GLM_ARCH & GLM_ARCH_SSE2_BIT
+	// glm::mat4 is only float-aligned, so load the columns into registers rather than casting.
+	glm_vec4 a[4], b[4], result[4];
+	for (int i = 0; i < 4; ++i) {
+		a[i] = _mm_loadu_ps(&parent[i][0]);
+		b[i] = _mm_loadu_ps(&local[i][0]);
+	}
+	glm_mat4_mul(a, b, result);
+	for (int i = 0; i < 4; ++i) _mm_storeu_ps(&out[i][0], result[i]);
+#else
+	out = parent * local;
+#endif
+}
+
+void composeTransforms(Transform* transforms, const std::size_t count, const glm::mat4& parent, glm::mat4* worldMatrices) {
+	for (std::size_t i = 0; i < count; ++i) multiplyMatrices(parent, transforms[i].matrix(), worldMatrices[i]);
+}
+
+Transform interpolateTransforms(const Transform& from, const Transform& to, const float alpha) {
+	// Components that did not change are copied, since blending equal values need not return them exactly.
+	Transform blended;
+	blended.setPosition(from.position() == to.position() ? to.position() : glm::mix(from.position(), to.position(), alpha));
+	blended.setRotation(from.rotation() == to.rotation() ? to.rotation() : glm::slerp(from.rotation(), to.rotation(), alpha));
+	blended.setScale(from.scale() == to.scale() ? to.scale() : glm::mix(from.scale(), to.scale(), alpha));
+	return blended;
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <cstddef>
+
+// Position, unit quaternion and scale are the source of truth; the matrix is rebuilt from them
+// only after a change, so per-frame updates never feed a matrix back into itself.
+class Transform {
+public:
+	Transform();
+
+	void setPosition(const glm::vec3& position);
+	void setRotation(const glm::quat& rotation);
+	void setScale(const glm::vec3& scale);
+	void translate(const glm::vec3& offset);
+	void rotate(const float radians, const glm::vec3& axis);
+
+	const glm::vec3& position() const;
+	const glm::quat& rotation() const;
+	const glm::vec3& scale() const;
+	bool isDirty() const;
+
+	const glm::mat4& matrix();
+
+private:
+	glm::vec3 translation;
+	glm::quat orientation;
+	glm::vec3 scaling;
+	glm::mat4 cachedMatrix;
+	bool dirty;
+};
+
+// out = parent * local, through glm_mat4_mul where GLM was built with SSE2 intrinsics.
+void multiplyMatrices(const glm::mat4& parent, const glm::mat4& local, glm::mat4& out);
+
+// Rebuilds every dirty transform and writes parent * local for each into worldMatrices.
+void composeTransforms(Transform* transforms, const std::size_t count, const glm::mat4& parent, glm::mat4* worldMatrices);
+
+// Blends position and scale linearly and rotation along the shortest arc, for drawing between
+// two fixed simulation steps.
+Transform interpolateTransforms(const Transform& from, const Transform& to, const float alpha);
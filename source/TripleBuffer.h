@@ -0,0 +1,70 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
+// One writer and one reader exchanging whole values without copying. The writer fills
+// writeBuffer() and publishes it; the reader acquires the newest published value into
+// readBuffer(). Neither side ever touches the other's slot, and the swap is a single atomic
+// exchange of the middle slot. The waits are optional pacing on top: waitForPublish() blocks the
+// reader until there is something new, waitUntilConsumed() blocks the writer until the reader has
+// taken the last value, which keeps the writer exactly one frame ahead.
+template <typename T>
+class TripleBuffer {
+public:
+	TripleBuffer() : front(0), middle(1), back(2), closed(false) {}
+
+	T& writeBuffer() {
+		return slots[back];
+	}
+
+	void publish() {
+		back = middle.exchange(back | FRESH, std::memory_order_acq_rel) & INDEX_MASK;
+		std::lock_guard<std::mutex> lock(mutex);
+		changed.notify_all();
+	}
+
+	// Returns false, keeping the current read buffer, when nothing was published since last time.
+	bool acquire() {
+		if (!(middle.load(std::memory_order_relaxed) & FRESH)) return false;
+		front = middle.exchange(front, std::memory_order_acq_rel) & INDEX_MASK;
+		std::lock_guard<std::mutex> lock(mutex);
+		changed.notify_all();
+		return true;
+	}
+
+	const T& readBuffer() const {
+		return slots[front];
+	}
+
+	// Both waits return false once close() has been called.
+	bool waitForPublish() {
+		std::unique_lock<std::mutex> lock(mutex);
+		changed.wait(lock, [this]() { return closed || (middle.load(std::memory_order_relaxed) & FRESH) != 0; });
+		return !closed;
+	}
+
+	bool waitUntilConsumed() {
+		std::unique_lock<std::mutex> lock(mutex);
+		changed.wait(lock, [this]() { return closed || (middle.load(std::memory_order_relaxed) & FRESH) == 0; });
+		return !closed;
+	}
+
+	void close() {
+		std::lock_guard<std::mutex> lock(mutex);
+		closed = true;
+		changed.notify_all();
+	}
+
+private:
+	static const unsigned INDEX_MASK = 3;
+	static const unsigned FRESH = 4;
+
+	T slots[3];
+	unsigned front;
+	std::atomic<unsigned> middle;
+	unsigned back;
+	bool closed;
+	std::mutex mutex;
+	std::condition_variable changed;
+};
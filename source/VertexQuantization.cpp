@@ -0,0 +1,112 @@
+#include "VertexQuantization.h"
+#include <glad/glad.h>
+#include <glm/gtc/packing.hpp>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace {
+	const float SNORM16_MAX = 32767.0f;
+	const float UNORM16_MAX = 65535.0f;
+
+	std::int16_t encodeSnorm16(const float value) {
+		return static_cast<std::int16_t>(std::lround(std::min(std::max(value, -1.0f), 1.0f) * SNORM16_MAX));
+	}
+
+	std::uint16_t encodeUnorm16(const float value) {
+		return static_cast<std::uint16_t>(std::lround(std::min(std::max(value, 0.0f), 1.0f) * UNORM16_MAX));
+	}
+
+	// Same conversions GL applies when fetching normalized and half-float attributes.
+	float decodeSnorm16(const std::int16_t value) {
+		return std::max(value / SNORM16_MAX, -1.0f);
+	}
+
+	float decodeTextureCoordinate(const std::uint16_t value, const bool isHalfFloat) {
+		return isHalfFloat ? glm::unpackHalf1x16(value) : value / UNORM16_MAX;
+	}
+}
+
+// The AABB centre becomes the bias and its half extent the scale, so every position maps into
+// [-1, 1]; a flat axis keeps a scale of 1 to avoid dividing by zero.
+bool quantizeMesh(const IndexedMesh& mesh, QuantizedMesh& quantized, const bool report) {
+	if (mesh.attributeSizes.size() != 2 || mesh.attributeSizes[0] != 3 || mesh.attributeSizes[1] != 2) return false;
+
+	const std::size_t vertexCount = mesh.vertexCount();
+	glm::vec3 minimum(0.0f), maximum(0.0f);
+	bool textureCoordinatesInUnitRange = true;
+	for (std::size_t i = 0; i < vertexCount; ++i) {
+		const float* vertex = &mesh.vertices[i * 5];
+		const glm::vec3 position(vertex[0], vertex[1], vertex[2]);
+		minimum = (i == 0) ? position : glm::min(minimum, position);
+		maximum = (i == 0) ? position : glm::max(maximum, position);
+		if (vertex[3] < 0.0f || vertex[3] > 1.0f || vertex[4] < 0.0f || vertex[4] > 1.0f) textureCoordinatesInUnitRange = false;
+	}
+
+	quantized.name = mesh.name;
+	quantized.indices = mesh.indices;
+	quantized.submeshes = mesh.submeshes;
+	quantized.positionBias = (minimum + maximum) * 0.5f;
+	quantized.positionScale = (maximum - minimum) * 0.5f;
+	for (int axis = 0; axis < 3; ++axis) {
+		if (quantized.positionScale[axis] <= 0.0f) quantized.positionScale[axis] = 1.0f;
+	}
+	quantized.halfFloatTextureCoordinates = !textureCoordinatesInUnitRange;
+
+	quantized.vertices.resize(vertexCount);
+	for (std::size_t i = 0; i < vertexCount; ++i) {
+		const float* vertex = &mesh.vertices[i * 5];
+		QuantizedVertex& encoded = quantized.vertices[i];
+		for (int axis = 0; axis < 3; ++axis) encoded.position[axis] = encodeSnorm16((vertex[axis] - quantized.positionBias[axis]) / quantized.positionScale[axis]);
+		encoded.position[3] = 0;
+		for (int component = 0; component < 2; ++component) {
+			encoded.textureCoordinate[component] = quantized.halfFloatTextureCoordinates ? glm::packHalf1x16(vertex[3 + component]) : encodeUnorm16(vertex[3 + component]);
+		}
+	}
+
+	if (report) {
+		const QuantizationError error = measureQuantizationError(mesh, quantized);
+		const std::size_t floatBytes = vertexCount * 5 * sizeof(float);
+		const std::size_t quantizedBytes = vertexCount * sizeof(QuantizedVertex);
+		std::cout << "Quantized mesh " << mesh.name << ": " << floatBytes << " -> " << quantizedBytes << " vertex bytes (" << 100.0 * (floatBytes - quantizedBytes) / floatBytes << "% smaller), "
+			<< (quantized.halfFloatTextureCoordinates ? "half" : "unorm16") << " texture coordinates" << '\n';
+		std::cout << "  max position error " << error.maxPositionError << " (" << error.maxRelativePositionError * 100.0f << "% of the AABB diagonal), max texture coordinate error " << error.maxTextureCoordinateError << '\n';
+	}
+	return true;
+}
+
+QuantizationError measureQuantizationError(const IndexedMesh& mesh, const QuantizedMesh& quantized) {
+	QuantizationError error = { 0.0f, 0.0f, 0.0f };
+	for (std::size_t i = 0; i < quantized.vertices.size(); ++i) {
+		const float* vertex = &mesh.vertices[i * 5];
+		const QuantizedVertex& encoded = quantized.vertices[i];
+		const glm::vec3 offset = dequantizePosition(encoded, quantized.positionScale, quantized.positionBias) - glm::vec3(vertex[0], vertex[1], vertex[2]);
+		error.maxPositionError = std::max(error.maxPositionError, glm::length(offset));
+		for (int component = 0; component < 2; ++component) {
+			const float decoded = decodeTextureCoordinate(encoded.textureCoordinate[component], quantized.halfFloatTextureCoordinates);
+			error.maxTextureCoordinateError = std::max(error.maxTextureCoordinateError, std::abs(decoded - vertex[3 + component]));
+		}
+	}
+	const float diagonal = 2.0f * glm::length(quantized.positionScale);
+	error.maxRelativePositionError = (diagonal > 0.0f) ? error.maxPositionError / diagonal : 0.0f;
+	return error;
+}
+
+glm::vec3 dequantizePosition(const QuantizedVertex& vertex, const glm::vec3& positionScale, const glm::vec3& positionBias) {
+	return glm::vec3(decodeSnorm16(vertex.position[0]), decodeSnorm16(vertex.position[1]), decodeSnorm16(vertex.position[2])) * positionScale + positionBias;
+}
+
+std::vector<VertexAttributeLayout> quantizedVertexLayout(const bool halfFloatTextureCoordinates) {
+	std::vector<VertexAttributeLayout> attributes;
+	attributes.push_back({ 3, GL_SHORT, true, 0 });
+	if (halfFloatTextureCoordinates) attributes.push_back({ 2, GL_HALF_FLOAT, false, 8 });
+	else attributes.push_back({ 2, GL_UNSIGNED_SHORT, true, 8 });
+	return attributes;
+}
+
+MeshBuffers createMeshBuffers(const QuantizedMesh& mesh) {
+	MeshBuffers buffers = createMeshBuffers(mesh.vertices.data(), mesh.vertices.size(), sizeof(QuantizedVertex), quantizedVertexLayout(mesh.halfFloatTextureCoordinates), mesh.indices);
+	buffers.positionScale = mesh.positionScale;
+	buffers.positionBias = mesh.positionBias;
+	return buffers;
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include "MeshBuilder.h"
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 12 bytes instead of 20: the position is snorm16 across the mesh AABB (the fourth short only keeps
+// the texture coordinate 4-byte aligned), and the texture coordinate is unorm16 when it stays in
+// [0, 1] or half float when it tiles.
+struct QuantizedVertex {
+	std::int16_t position[4];
+	std::uint16_t textureCoordinate[2];
+};
+
+struct QuantizedMesh {
+	std::string name;
+	std::vector<QuantizedVertex> vertices;
+	std::vector<std::uint32_t> indices;
+	std::vector<MeshRange> submeshes;
+	glm::vec3 positionScale;
+	glm::vec3 positionBias;
+	bool halfFloatTextureCoordinates;
+};
+
+struct QuantizationError {
+	float maxPositionError;
+	float maxRelativePositionError;
+	float maxTextureCoordinateError;
+};
+
+// Expects the {3, 2} position + texture coordinate layout the cube uses; returns false otherwise.
+bool quantizeMesh(const IndexedMesh& mesh, QuantizedMesh& quantized, const bool report = true);
+QuantizationError measureQuantizationError(const IndexedMesh& mesh, const QuantizedMesh& quantized);
+// The object-space position the vertex shader reconstructs from positionScale and positionBias.
+glm::vec3 dequantizePosition(const QuantizedVertex& vertex, const glm::vec3& positionScale, const glm::vec3& positionBias);
+std::vector<VertexAttributeLayout> quantizedVertexLayout(const bool halfFloatTextureCoordinates);
+MeshBuffers createMeshBuffers(const QuantizedMesh& mesh);
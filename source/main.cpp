@@ -5,210 +5,473 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
 #include <iostream>
-#include <sstream>
-#include <fstream>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Benchmarks.h"
+#include "BoundingVolumeHierarchy.h"
+#include "CommandBuffer.h"
+#include "CookedMesh.h"
+#include "CookedTexture.h"
+#include "CubeGeometry.h"
+#include "InstanceBuffer.h"
+#include "JobSystem.h"
+#include "MeshImport.h"
+#include "MeshOptimizer.h"
+#include "OcclusionCuller.h"
+#include "ShaderProgram.h"
+#include "SimulationStep.h"
+#include "TextureStreamer.h"
+#include "FixedTimestep.h"
+#include "FrameConstants.h"
+#include "FrustumCulling.h"
+#include "GLExtensions.h"
+#include "GLStateCache.h"
+#include "ProgramCache.h"
+#include "RenderQueue.h"
+#include "Transform.h"
+#include "TripleBuffer.h"
+#include "VertexQuantization.h"
 
 const int WINDOW_WIDTH = 600;
 const int WINDOW_HEIGHT = 600;
-float distance = 0.0f;
-float degrees = 0.0f;
+float moveAxis = 0.0f;
+float turnAxis = 0.0f;
+bool pickRequested = false;
+bool reportRequested = false;
 
 void glfwFrameBufferCallback(GLFWwindow* targetWindow, const int newWidth, const int newHeight) {
 	glViewport(0, 0, newWidth - 100, newHeight - 100);
 }
 
+void glfwMouseButtonCallback(GLFWwindow* targetWindow, const int button, const int action, const int modifiers) {
+	if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS) pickRequested = true;
+}
+
+void glfwKeyCallback(GLFWwindow* targetWindow, const int key, const int scancode, const int action, const int modifiers) {
+	if (key == GLFW_KEY_O && action == GLFW_PRESS) reportRequested = true;
+}
+
 void checkGlfwWindowActions(GLFWwindow* window) {
 	if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) glfwSetWindowShouldClose(window, true);
-	if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) distance -= 0.1f;
-	if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) distance += 0.1f;
-	if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) degrees += 5.0f;
-	if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) degrees -= 5.0f;
+	moveAxis = static_cast<float>(glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) - static_cast<float>(glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS);
+	turnAxis = static_cast<float>(glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) - static_cast<float>(glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS);
+}
+
+// Input gathered on the main thread since the simulation last took it. Key changes are stamped in
+// seconds since inputEpoch, which is also where the simulation clock starts.
+struct FrameInput {
+	std::vector<KeyChange> keyChanges;
+	bool pickRequested;
+	bool reportRequested;
+	glm::dvec2 cursor;
+	glm::ivec4 viewport;
+	std::chrono::steady_clock::time_point time;
+};
+
+// Everything the renderer needs from one simulated frame. instanceVersion changes whenever
+// instanceMatrices does, so the renderer only uploads new matrices.
+struct FrameSnapshot {
+	FrameSnapshot() : view(1.0f), projection(1.0f), cubeDepth(0.0f), instanceVersion(0), reportRequested(false), simulationMilliseconds(0.0) {}
+
+	glm::mat4 view;
+	glm::mat4 projection;
+	float cubeDepth;
+	std::uint64_t instanceVersion;
+	std::vector<glm::mat4> instanceMatrices;
+	bool reportRequested;
+	std::chrono::steady_clock::time_point inputTime;
+	double simulationMilliseconds;
+};
+
+// cube and camera hold the latest fixed step and previousCube and previousCamera the one before;
+// renderCube and renderCamera are blended between them each frame, and are what gets culled and drawn.
+struct Simulation {
+	Transform cube;
+	Transform camera;
+	Transform previousCube;
+	Transform previousCamera;
+	Transform renderCube;
+	Transform renderCamera;
+	FixedTimestep timestep;
+	InputTimeline input;
+	std::chrono::steady_clock::time_point lastFrame;
+	glm::mat4 projection;
+	std::vector<Transform*> sceneObjects;
+	ObjectBounds objectBounds;
+	BoundingVolumeHierarchy sceneHierarchy;
+	float builtHierarchyCost;
+	OcclusionCuller occlusionCuller;
+	JobSystem jobSystem;
+	const IndexedMesh* sceneMesh;
+	glm::vec3 positionScale;
+	glm::vec3 positionBias;
+	std::vector<std::uint32_t> visibleObjects;
+	std::vector<glm::mat4> objectMatrices;
+	std::uint64_t instanceVersion;
+};
+
+struct PipelineStatistics {
+	std::size_t frames;
+	double frameMilliseconds;
+	double simulationMilliseconds;
+	double renderMilliseconds;
+	double latencyMilliseconds;
+};
+
+std::mutex inputMutex;
+FrameInput pendingInput = {};
+std::chrono::steady_clock::time_point inputEpoch;
+HeldKeys recordedKeys = { 0.0f, 0.0f };
+
+void gatherInput(GLFWwindow* window) {
+	glfwPollEvents();
+	checkGlfwWindowActions(window);
+	std::lock_guard<std::mutex> lock(inputMutex);
+	const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	if (pendingInput.time == std::chrono::steady_clock::time_point()) pendingInput.time = now;
+	if (moveAxis != recordedKeys.moveAxis || turnAxis != recordedKeys.turnAxis) {
+		recordedKeys.moveAxis = moveAxis;
+		recordedKeys.turnAxis = turnAxis;
+		pendingInput.keyChanges.push_back({ std::chrono::duration<double>(now - inputEpoch).count(), recordedKeys });
+	}
+	if (pickRequested) {
+		pendingInput.pickRequested = true;
+		// GLFW reports the cursor in screen coordinates from the top; picking unprojects framebuffer
+		// pixels from the bottom, through the viewport the frame is drawn with. Screen coordinates and
+		// pixels differ on high-DPI displays, and the viewport does not cover the whole window.
+		glm::dvec2 cursor;
+		glm::ivec2 windowSize, framebufferSize;
+		glfwGetCursorPos(window, &cursor.x, &cursor.y);
+		glfwGetWindowSize(window, &windowSize.x, &windowSize.y);
+		glfwGetFramebufferSize(window, &framebufferSize.x, &framebufferSize.y);
+		glGetIntegerv(GL_VIEWPORT, &pendingInput.viewport[0]);
+		if (windowSize.x > 0 && windowSize.y > 0) cursor *= glm::dvec2(framebufferSize) / glm::dvec2(windowSize);
+		pendingInput.cursor = glm::dvec2(cursor.x, framebufferSize.y - cursor.y);
+	}
+	pendingInput.reportRequested = pendingInput.reportRequested || reportRequested;
+	pickRequested = reportRequested = false;
+}
+
+FrameInput takeInput() {
+	std::lock_guard<std::mutex> lock(inputMutex);
+	FrameInput input = pendingInput;
+	pendingInput = FrameInput();
+	if (input.time == std::chrono::steady_clock::time_point()) input.time = std::chrono::steady_clock::now();
+	return input;
+}
+
+// Only replaces the render transform when the blend moved it, so a scene at rest stays clean and
+// skips the hierarchy and culling work.
+void blendRenderTransform(const Transform& previous, const Transform& current, const float alpha, Transform& render) {
+	const Transform blended = interpolateTransforms(previous, current, alpha);
+	if (blended.position() != render.position() || blended.rotation() != render.rotation() || blended.scale() != render.scale()) render = blended;
 }
 
-bool checkShaderErrors(const unsigned shader, const char* wordName, const bool isProgram) {
-	int success;
-	char errorMessage[512];
+// Runs everything up to the draw list: input, fixed steps, transforms, hierarchy, culling and
+// picking. It only touches the simulation and the snapshot, so it can run on its own thread.
+// The simulation clock starts at inputEpoch, and each step uses the keys held when it starts, so
+// how steps fall into frames does not change where the camera and cube end up.
+void simulateFrame(Simulation& simulation, const FrameInput& input, FrameSnapshot& snapshot) {
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	const double frameSeconds = std::chrono::duration<double>(start - simulation.lastFrame).count();
+	simulation.lastFrame = start;
+	for (const KeyChange& change : input.keyChanges) simulation.input.record(change);
+	const int steps = simulation.timestep.advance(frameSeconds);
+	const float stepSeconds = static_cast<float>(simulation.timestep.stepSeconds());
+	for (int step = 0; step < steps; ++step) {
+		simulation.previousCamera = simulation.camera;
+		simulation.previousCube = simulation.cube;
+		stepSimulation(simulation.camera, simulation.cube, simulation.input.keysAt(simulation.timestep.stepStartSeconds(step)), stepSeconds);
+	}
+	blendRenderTransform(simulation.previousCamera, simulation.camera, simulation.timestep.alpha(), simulation.renderCamera);
+	blendRenderTransform(simulation.previousCube, simulation.cube, simulation.timestep.alpha(), simulation.renderCube);
+	const bool cameraMoved = simulation.renderCamera.isDirty();
+	const glm::mat4 view = simulation.renderCamera.matrix();
 
-	if (isProgram) {
-		glGetProgramiv(shader, GL_LINK_STATUS, &success);
-		if (!success) {
-			glGetProgramInfoLog(shader, sizeof(errorMessage), NULL, errorMessage);
-			std::cout << "There was an error linking the " << wordName << ':' <<'\n' << errorMessage << '\n';
+	// Transforms update on the job system, each object written only by the job covering it.
+	// Moved objects refit the hierarchy, which is rebuilt once refitting has doubled its cost.
+	// Only objects that survive culling go into the snapshot's instance matrices.
+	std::atomic<bool> sceneMoved(false);
+	parallelFor(simulation.jobSystem, simulation.objectBounds.size(), [&](const std::size_t begin, const std::size_t end) {
+		for (std::size_t i = begin; i < end; ++i) {
+			if (!simulation.sceneObjects[i]->isDirty()) continue;
+			simulation.objectMatrices[i] = simulation.sceneObjects[i]->matrix();
+			glm::vec3 worldCenter, worldExtents;
+			transformBounds(simulation.objectMatrices[i], simulation.positionBias, simulation.positionScale, worldCenter, worldExtents);
+			simulation.objectBounds.set(i, worldCenter, worldExtents);
+			sceneMoved.store(true, std::memory_order_relaxed);
+		}
+	});
+	BoundingVolumeHierarchy& sceneHierarchy = simulation.sceneHierarchy;
+	if (sceneMoved.load()) {
+		if (sceneHierarchy.nodes().empty()) {
+			sceneHierarchy.build(simulation.objectBounds);
+			simulation.builtHierarchyCost = sceneHierarchy.cost();
+		}
+		else {
+			sceneHierarchy.refit(simulation.objectBounds);
+			if (sceneHierarchy.cost() > 2.0f * simulation.builtHierarchyCost) {
+				sceneHierarchy.build(simulation.objectBounds);
+				simulation.builtHierarchyCost = sceneHierarchy.cost();
+			}
 		}
-	} else {
-		glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
-		if (!success) {
-			glGetShaderInfoLog(shader, sizeof(errorMessage), NULL, errorMessage);
-			std::cout << "There was an error compiling the " << wordName << ':' << '\n' << errorMessage << '\n';
+	}
+	if (sceneMoved || cameraMoved) {
+		const glm::mat4 viewProjection = simulation.projection * view;
+		std::vector<std::uint32_t>& visibleObjects = simulation.visibleObjects;
+		sceneHierarchy.queryFrustum(extractFrustum(viewProjection), simulation.objectBounds, visibleObjects);
+		// Every object in view doubles as an occluder, rasterized from the CPU copy of the mesh (the
+		// dequantized positions for a cooked one); a bigger scene would pick a few large ones.
+		simulation.occlusionCuller.beginFrame(viewProjection);
+		for (const std::uint32_t object : visibleObjects) simulation.occlusionCuller.addOccluder(*simulation.sceneMesh, simulation.objectMatrices[object]);
+		simulation.occlusionCuller.finishOccluders();
+		visibleObjects.resize(simulation.occlusionCuller.cullObjects(simulation.objectBounds, visibleObjects.data(), visibleObjects.size()));
+		++simulation.instanceVersion;
+	}
+	// Snapshot slots rotate, so one that last held an older version is brought up to date.
+	if (snapshot.instanceVersion != simulation.instanceVersion) {
+		snapshot.instanceMatrices.clear();
+		for (const std::uint32_t object : simulation.visibleObjects) snapshot.instanceMatrices.push_back(simulation.objectMatrices[object]);
+		snapshot.instanceVersion = simulation.instanceVersion;
+	}
+
+	if (input.pickRequested) {
+		const glm::vec4 viewport(input.viewport);
+		const glm::vec3 nearPoint = glm::unProject(glm::vec3(input.cursor.x, input.cursor.y, 0.0), view, simulation.projection, viewport);
+		const glm::vec3 farPoint = glm::unProject(glm::vec3(input.cursor.x, input.cursor.y, 1.0), view, simulation.projection, viewport);
+		RayHit hit;
+		if (sceneHierarchy.intersectRay(nearPoint, farPoint - nearPoint, *simulation.sceneMesh, simulation.objectMatrices.data(), hit)) {
+			const glm::vec3 hitPoint = nearPoint + hit.distance * (farPoint - nearPoint);
+			std::cout << "Picked object " << hit.object << ", triangle " << hit.triangle << " at view depth " << -(view * glm::vec4(hitPoint, 1.0f)).z << '\n';
 		}
 	}
+	if (input.reportRequested) {
+		simulation.occlusionCuller.report();
+		std::cout << "Fixed timestep: " << simulation.timestep.steps() << " steps of " << simulation.timestep.stepSeconds() * 1000.0 << " ms, " << simulation.timestep.droppedSeconds() << " s dropped catching up" << '\n';
+	}
 
-	return success;
+	snapshot.view = view;
+	snapshot.projection = simulation.projection;
+	snapshot.cubeDepth = -(view * glm::vec4(simulation.renderCube.position(), 1.0f)).z;
+	snapshot.reportRequested = input.reportRequested;
+	snapshot.inputTime = input.time;
+	snapshot.simulationMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
 }
 
-unsigned createShaderProgram(const char* vertexShaderPath, const char* fragmentShaderPath) {
-	std::ifstream vertexShaderFile(vertexShaderPath);
-	std::ifstream fragmentShaderFile(fragmentShaderPath);
-	std::stringstream intermediary;
-	
-	intermediary << vertexShaderFile.rdbuf();
-	std::string vertexTempStringHolder = intermediary.str();
-	const char* vertexShaderContents = vertexTempStringHolder.c_str();
-	unsigned vertexShader;
-	vertexShader = glCreateShader(GL_VERTEX_SHADER);
-	glShaderSource(vertexShader, 1, &vertexShaderContents, NULL);
-	glCompileShader(vertexShader);
-	checkShaderErrors(vertexShader, "vertex shader", false);
-
-	intermediary.str("");
-	intermediary.clear();
-	intermediary << fragmentShaderFile.rdbuf();
-	std::string fragmentTempStringHolder = intermediary.str();
-	const char* fragmentShaderContents = fragmentTempStringHolder.c_str();
-	unsigned fragmentShader;
-	fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-	glShaderSource(fragmentShader, 1, &fragmentShaderContents, NULL);
-	glCompileShader(fragmentShader);
-	checkShaderErrors(fragmentShader, "fragment shader", false);
-
-	unsigned shaderProgram;
-	shaderProgram = glCreateProgram();
-	glAttachShader(shaderProgram, vertexShader);
-	glAttachShader(shaderProgram, fragmentShader);
-	glLinkProgram(shaderProgram);
-	checkShaderErrors(shaderProgram, "shader program", true);
-
-	glDeleteShader(vertexShader);
-	glDeleteShader(fragmentShader);
-
-	return shaderProgram;
+void reportPipeline(const bool pipelined, const PipelineStatistics& statistics) {
+	if (statistics.frames == 0) return;
+	const double frames = static_cast<double>(statistics.frames);
+	std::cout << (pipelined ? "Pipelined" : "Sequential") << " frames: " << statistics.frames << " frames, " << statistics.frameMilliseconds / frames << " ms/frame, simulation "
+		<< statistics.simulationMilliseconds / frames << " ms, render " << statistics.renderMilliseconds / frames << " ms, input to present " << statistics.latencyMilliseconds / frames << " ms" << '\n';
 }
 
-int main() {
+int main(int argc, char** argv) {
+	if (argc > 1 && std::strcmp(argv[1], "--texcook") == 0) {
+		const char* sourceDirectory = "source/textures";
+		TextureCookOptions options;
+		for (int i = 2; i < argc; ++i) {
+			if (std::strcmp(argv[i], "--compress") == 0) options.compress = true;
+			else if (std::strcmp(argv[i], "--bc7") == 0) options.compress = options.preferBC7 = true;
+			else if (std::strcmp(argv[i], "--quality") == 0 && i + 1 < argc) {
+				++i;
+				if (std::strcmp(argv[i], "fast") == 0) options.quality = BlockQuality::Fast;
+				else if (std::strcmp(argv[i], "high") == 0) options.quality = BlockQuality::High;
+				else options.quality = BlockQuality::Normal;
+			}
+			else sourceDirectory = argv[i];
+		}
+		return cookTextureDirectory(sourceDirectory, (std::filesystem::path(sourceDirectory) / "cooked").string().c_str(), options) == 0 ? 0 : 1;
+	}
+	if (argc > 1 && std::strcmp(argv[1], "--meshcook") == 0) {
+		const char* sourceDirectory = (argc > 2) ? argv[2] : "source/meshes";
+		return cookMeshDirectory(sourceDirectory, (std::filesystem::path(sourceDirectory) / "cooked").string().c_str()) == 0 ? 0 : 1;
+	}
+	const char* benchmarkName = (argc > 2 && std::strcmp(argv[1], "--benchmark") == 0) ? argv[2] : NULL;
+	const char* meshPath = (argc > 2 && std::strcmp(argv[1], "--mesh") == 0) ? argv[2] : NULL;
+	// Simulates frame N + 1 on its own thread while frame N renders, at one frame of extra latency.
+	bool pipelined = false, vsync = true;
+	for (int i = 1; i < argc; ++i) {
+		pipelined = pipelined || std::strcmp(argv[i], "--pipelined") == 0;
+		vsync = vsync && std::strcmp(argv[i], "--novsync") != 0;
+	}
+
 	glfwInit();
 	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	if (benchmarkName) glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
 	GLFWwindow* window = glfwCreateWindow(WINDOW_WIDTH, WINDOW_HEIGHT, "LearnOpenGLRound2", NULL, NULL);
 
 	glfwMakeContextCurrent(window);
 	glfwSetFramebufferSizeCallback(window, glfwFrameBufferCallback);
+	glfwSetMouseButtonCallback(window, glfwMouseButtonCallback);
+	glfwSetKeyCallback(window, glfwKeyCallback);
 	gladLoadGLLoader(reinterpret_cast<GLADloadproc>(glfwGetProcAddress));
+	loadGLExtensions(reinterpret_cast<GLADloadproc>(glfwGetProcAddress));
 	glEnable(GL_DEPTH_TEST);
 
-	unsigned program = createShaderProgram("source/shaders/VertexShader.txt", "source/shaders/FragmentShader.txt");
-
-	float verticies[] = {
-	-0.5f, -0.5f, -0.5f,  0.0f, 0.0f,
-	 0.5f, -0.5f, -0.5f,  1.0f, 0.0f,
-	 0.5f,  0.5f, -0.5f,  1.0f, 1.0f,
-	 0.5f,  0.5f, -0.5f,  1.0f, 1.0f,
-	-0.5f,  0.5f, -0.5f,  0.0f, 1.0f,
-	-0.5f, -0.5f, -0.5f,  0.0f, 0.0f,
-
-	-0.5f, -0.5f,  0.5f,  0.0f, 0.0f,
-	 0.5f, -0.5f,  0.5f,  1.0f, 0.0f,
-	 0.5f,  0.5f,  0.5f,  1.0f, 1.0f,
-	 0.5f,  0.5f,  0.5f,  1.0f, 1.0f,
-	-0.5f,  0.5f,  0.5f,  0.0f, 1.0f,
-	-0.5f, -0.5f,  0.5f,  0.0f, 0.0f,
-
-	-0.5f,  0.5f,  0.5f,  1.0f, 0.0f,
-	-0.5f,  0.5f, -0.5f,  1.0f, 1.0f,
-	-0.5f, -0.5f, -0.5f,  0.0f, 1.0f,
-	-0.5f, -0.5f, -0.5f,  0.0f, 1.0f,
-	-0.5f, -0.5f,  0.5f,  0.0f, 0.0f,
-	-0.5f,  0.5f,  0.5f,  1.0f, 0.0f,
-
-	 0.5f,  0.5f,  0.5f,  1.0f, 0.0f,
-	 0.5f,  0.5f, -0.5f,  1.0f, 1.0f,
-	 0.5f, -0.5f, -0.5f,  0.0f, 1.0f,
-	 0.5f, -0.5f, -0.5f,  0.0f, 1.0f,
-	 0.5f, -0.5f,  0.5f,  0.0f, 0.0f,
-	 0.5f,  0.5f,  0.5f,  1.0f, 0.0f,
-
-	-0.5f, -0.5f, -0.5f,  0.0f, 1.0f,
-	 0.5f, -0.5f, -0.5f,  1.0f, 1.0f,
-	 0.5f, -0.5f,  0.5f,  1.0f, 0.0f,
-	 0.5f, -0.5f,  0.5f,  1.0f, 0.0f,
-	-0.5f, -0.5f,  0.5f,  0.0f, 0.0f,
-	-0.5f, -0.5f, -0.5f,  0.0f, 1.0f,
-
-	-0.5f,  0.5f, -0.5f,  0.0f, 1.0f,
-	 0.5f,  0.5f, -0.5f,  1.0f, 1.0f,
-	 0.5f,  0.5f,  0.5f,  1.0f, 0.0f,
-	 0.5f,  0.5f,  0.5f,  1.0f, 0.0f,
-	-0.5f,  0.5f,  0.5f,  0.0f, 0.0f,
-	-0.5f,  0.5f, -0.5f,  0.0f, 1.0f
-	};
-	unsigned VAO, VBO;
-	glGenVertexArrays(1, &VAO);
-	glBindVertexArray(VAO);
-	glEnableVertexAttribArray(0);
-	glEnableVertexAttribArray(1);
-
-	glGenBuffers(1, &VBO);
-	glBindBuffer(GL_ARRAY_BUFFER, VBO);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(verticies), verticies, GL_STATIC_DRAW);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), reinterpret_cast<void*>(0));
-	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), reinterpret_cast<void*>(3 * sizeof(float)));
-	
-	glBindBuffer(GL_ARRAY_BUFFER, NULL);
-	glBindVertexArray(NULL);
-
-	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-	unsigned sionTexture;
-	glGenTextures(1, &sionTexture);
-	glBindTexture(GL_TEXTURE_2D, sionTexture);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	int sionWidth, sionHeight, sionChannels;
-	unsigned char* sionData = stbi_load("source/textures/sion.jpg", &sionWidth, &sionHeight, &sionChannels, 0);
-	unsigned sionFormat = (sionChannels == 4) ? GL_RGBA : GL_RGB;
-	glTexImage2D(GL_TEXTURE_2D, 0, sionFormat, sionWidth, sionHeight, 0, sionFormat, GL_UNSIGNED_BYTE, sionData);
-	glGenerateMipmap(GL_TEXTURE_2D);
-	stbi_image_free(sionData);
-	glBindTexture(GL_TEXTURE_2D, NULL);	
-
-	glUseProgram(program);
-	glUniform1i(glGetUniformLocation(program, "sion"), 0);
+	if (benchmarkName) {
+		const bool benchmarkPassed = runBenchmark(benchmarkName);
+		glfwTerminate();
+		return benchmarkPassed ? 0 : 1;
+	}
+
+	// Motion no longer depends on the frame rate, so vsync can be turned off to measure frame time.
+	glfwSwapInterval(vsync ? 1 : 0);
+	installGLStateCache();
+	ProgramCache programCache("shadercache");
+	ShaderProgram program(createShaderProgram("source/shaders/VertexShader.txt", "source/shaders/FragmentShader.txt", &programCache));
+	programCache.report();
+	FrameConstantsBuffer frameConstantsBuffer;
+	frameConstantsBuffer.create();
+
+	// sceneMesh keeps the CPU copy that picking and the occlusion culler use; a cooked mesh fills it
+	// with its dequantized positions.
+	MeshBuffers cubeMesh;
+	IndexedMesh sceneMesh;
+	// A cooked mesh older than its source is skipped, so an edited source is not hidden behind a stale cook.
+	const std::string cookedScenePath = meshPath ? cookedMeshPath(meshPath) : std::string();
+	bool useCookedScene = false;
+	if (meshPath && std::filesystem::exists(cookedScenePath)) {
+		std::error_code cookedTimeError, sourceTimeError;
+		const std::filesystem::file_time_type cookedTime = std::filesystem::last_write_time(cookedScenePath, cookedTimeError);
+		const std::filesystem::file_time_type sourceTime = std::filesystem::last_write_time(meshPath, sourceTimeError);
+		useCookedScene = !cookedTimeError && (sourceTimeError || cookedTime >= sourceTime);
+		if (!useCookedScene) std::cout << "Ignoring " << cookedScenePath << ", which is older than " << meshPath << '\n';
+	}
+	if (useCookedScene && loadCookedMesh(cookedScenePath.c_str(), cubeMesh, &sceneMesh)) std::cout << "Loaded the cooked mesh " << cookedScenePath << '\n';
+	else {
+		if (meshPath && importMesh(meshPath, sceneMesh)) optimizeMesh(sceneMesh);
+		else sceneMesh = buildCubeMesh();
+		QuantizedMesh quantizedCube;
+		quantizeMesh(sceneMesh, quantizedCube);
+		cubeMesh = createMeshBuffers(quantizedCube);
+	}
+	InstanceBuffer instanceBuffer;
+	instanceBuffer.create(cubeMesh.vertexArray, 2, 1);
+
+	TextureStreamer textureStreamer;
+	textureStreamer.create();
+	const std::string cookedSionPath = cookedTexturePath("source/textures/sion.jpg");
+	int sionTexture = textureStreamer.request(std::filesystem::exists(cookedSionPath) ? cookedSionPath.c_str() : "source/textures/sion.jpg");
+
+	program.use();
+	program.setInt("sion", 0);
 	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, sionTexture);
 	glUseProgram(NULL);
 
-	glm::mat4 model(1.0);
-	model = glm::rotate(model, glm::radians(-75.0f), glm::vec3(1.0, 0.0, 0.0));
-	glm::mat4 view(1.0);
-	view = glm::translate(view, glm::vec3(0.0, 0.0, -3.0));
-	glm::mat4 projection = glm::perspective(glm::radians(45.0f), static_cast<float>(WINDOW_WIDTH) / WINDOW_HEIGHT, 0.1f, 100.0f);
+	Simulation simulation;
+	simulation.cube.rotate(glm::radians(-75.0f), glm::vec3(1.0, 0.0, 0.0));
+	simulation.camera.setPosition(glm::vec3(0.0, 0.0, -3.0));
+	simulation.projection = glm::perspective(glm::radians(45.0f), static_cast<float>(WINDOW_WIDTH) / WINDOW_HEIGHT, 0.1f, 100.0f);
+	simulation.previousCube = simulation.renderCube = simulation.cube;
+	simulation.previousCamera = simulation.renderCamera = simulation.camera;
+	simulation.sceneObjects.push_back(&simulation.renderCube);
+	simulation.objectBounds.resize(simulation.sceneObjects.size());
+	simulation.builtHierarchyCost = 0.0f;
+	simulation.occlusionCuller.create(256, 128);
+	simulation.sceneMesh = &sceneMesh;
+	simulation.positionScale = cubeMesh.positionScale;
+	simulation.positionBias = cubeMesh.positionBias;
+	simulation.objectMatrices.resize(simulation.sceneObjects.size());
+	simulation.instanceVersion = 0;
+	inputEpoch = simulation.lastFrame = std::chrono::steady_clock::now();
+
+	// A job system belongs to the thread that created it. Sequential frames share one between
+	// simulation and rendering; pipelined ones give each thread its own, with workers for about half the cores each.
+	TripleBuffer<FrameSnapshot> snapshots;
+	std::thread simulationThread;
+	JobSystem renderJobSystem;
+	JobSystem& renderJobs = pipelined ? renderJobSystem : simulation.jobSystem;
+	if (pipelined) {
+		const unsigned workersPerThread = std::max(1u, std::thread::hardware_concurrency() / 2);
+		renderJobSystem.create(workersPerThread);
+		simulationThread = std::thread([&simulation, &snapshots, workersPerThread]() {
+			simulation.jobSystem.create(workersPerThread);
+			while (snapshots.waitUntilConsumed()) {
+				simulateFrame(simulation, takeInput(), snapshots.writeBuffer());
+				snapshots.publish();
+			}
+			simulation.jobSystem.destroy();
+		});
+	}
+	else simulation.jobSystem.create();
+
+	FrameConstants frameConstants;
+	RenderQueue renderQueue;
+	std::vector<CommandBuffer> commandBuffers;
+	std::uint64_t uploadedInstanceVersion = 0;
+	PipelineStatistics pipelineStatistics = {};
+	std::chrono::steady_clock::time_point lastPresent = std::chrono::steady_clock::now();
 
 	while (!glfwWindowShouldClose(window)) {
-		glfwPollEvents();
-		checkGlfwWindowActions(window);
-		view = glm::translate(view, glm::vec3(0.0, 0.0, distance));
-		distance = 0.0f;
-		model = glm::rotate(model, glm::radians(degrees), glm::vec3(0.5, 1.0, 0.0));
-		degrees = 0.0f;
+		gatherInput(window);
+		if (pipelined) snapshots.waitForPublish();
+		else {
+			simulateFrame(simulation, takeInput(), snapshots.writeBuffer());
+			snapshots.publish();
+		}
+		snapshots.acquire();
+		const FrameSnapshot& snapshot = snapshots.readBuffer();
+		const std::chrono::steady_clock::time_point renderStart = std::chrono::steady_clock::now();
+
+		frameConstants.view = snapshot.view;
+		frameConstants.projection = snapshot.projection;
+		if (snapshot.instanceVersion != uploadedInstanceVersion) {
+			instanceBuffer.update(snapshot.instanceMatrices.data(), snapshot.instanceMatrices.size());
+			uploadedInstanceVersion = snapshot.instanceVersion;
+		}
 
 		glClearColor(0.2, 0.7, 0.2, 1.0);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-		glBindVertexArray(VAO);
-		glUseProgram(program);
-		glUniformMatrix4fv(glGetUniformLocation(program, "model"), 1, GL_FALSE, glm::value_ptr(model));
-		glUniformMatrix4fv(glGetUniformLocation(program, "view"), 1, GL_FALSE, glm::value_ptr(view));
-		glUniformMatrix4fv(glGetUniformLocation(program, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
-		glDrawArrays(GL_TRIANGLES, 0, 36);
+		textureStreamer.update(2.0);
+		frameConstantsBuffer.update(frameConstants);
+
+		renderQueue.clear();
+		renderQueue.push({ &program, textureStreamer.texture(sionTexture), &cubeMesh, &instanceBuffer, snapshot.cubeDepth });
+		renderQueue.sort(&renderJobs);
+		renderQueue.record(commandBuffers, &renderJobs);
+		replayCommandBuffers(commandBuffers);
 
+		if (snapshot.reportRequested) {
+			renderQueue.report();
+			reportGLStateCache();
+			reportPipeline(pipelined, pipelineStatistics);
+		}
+
+		const std::chrono::steady_clock::time_point renderEnd = std::chrono::steady_clock::now();
 		glfwSwapBuffers(window);
+		endGLStateFrame();
+		const std::chrono::steady_clock::time_point present = std::chrono::steady_clock::now();
+		++pipelineStatistics.frames;
+		pipelineStatistics.frameMilliseconds += std::chrono::duration<double, std::milli>(present - lastPresent).count();
+		pipelineStatistics.simulationMilliseconds += snapshot.simulationMilliseconds;
+		pipelineStatistics.renderMilliseconds += std::chrono::duration<double, std::milli>(renderEnd - renderStart).count();
+		pipelineStatistics.latencyMilliseconds += std::chrono::duration<double, std::milli>(present - snapshot.inputTime).count();
+		lastPresent = present;
 	}
 
-	glDeleteBuffers(1, &VBO);
-	glDeleteVertexArrays(1, &VAO);
-	glDeleteProgram(program);
+	if (pipelined) {
+		snapshots.close();
+		simulationThread.join();
+		renderJobSystem.destroy();
+	}
+	else simulation.jobSystem.destroy();
+	reportPipeline(pipelined, pipelineStatistics);
+	instanceBuffer.destroy();
+	destroyMeshBuffers(cubeMesh);
+	textureStreamer.reportUploads();
+	textureStreamer.destroy();
+	frameConstantsBuffer.destroy();
+	program.destroy();
 	glfwTerminate();
 	return 0;
 }
\ No newline at end of file
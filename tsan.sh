@@ -0,0 +1,19 @@
+#!/bin/sh
+# ThreadSanitizer build of the game on Linux, which then runs the job system checks. MSVC has no
+# ThreadSanitizer, so this lives beside the Visual Studio project instead of in it.
+# Needs GCC or Clang and GLFW 3 (found through pkg-config). Run it from the repository root;
+# without a display, run it as "xvfb-run sh tsan.sh". Any reported race fails the run.
+set -e
+CXX=${CXX:-g++}
+CC=${CC:-gcc}
+OUTPUT=build-tsan
+FLAGS="-O1 -g -fsanitize=thread -msse2 -DGLM_FORCE_INTRINSICS -Iinclude -Isource"
+
+mkdir -p "$OUTPUT"
+for file in source/*.cpp; do
+	$CXX -std=c++17 $FLAGS -c "$file" -o "$OUTPUT/$(basename "$file" .cpp).o"
+done
+$CC $FLAGS -c source/glad.c -o "$OUTPUT/glad.o"
+$CXX -fsanitize=thread "$OUTPUT"/*.o $(pkg-config --libs glfw3) -ldl -lpthread -o "$OUTPUT/LearnOpenGLRound2"
+
+TSAN_OPTIONS="halt_on_error=1 $TSAN_OPTIONS" "./$OUTPUT/LearnOpenGLRound2" --benchmark jobs